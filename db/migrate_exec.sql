@@ -0,0 +1,74 @@
+-- The Restful Matching-Engine.
+-- Copyright (C) 2013, 2017 Swirly Cloud Limited.
+--
+-- This program is free software; you can redistribute it and/or modify it under the terms of the
+-- GNU General Public License as published by the Free Software Foundation; either version 2 of the
+-- License, or (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+-- even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+-- General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License along with this program; if
+-- not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+-- 02110-1301, USA.
+
+-- Migrate the exec_t journal triggers to keyed operations. The order update is keyed by the
+-- order_t primary key, and seq_id is assigned by the journal on insert, rather than by updating the
+-- exec row afterwards. The script may be run more than once.
+
+-- Use ';' on single line to terminate statement.
+PRAGMA foreign_keys = ON
+;
+
+BEGIN TRANSACTION
+;
+
+DROP TRIGGER IF EXISTS before_insert_on_exec2
+;
+
+CREATE TRIGGER before_insert_on_exec2
+  BEFORE INSERT ON exec_t
+  WHEN NEW.order_id IS NOT NULL
+  AND NEW.state_id != 1
+  BEGIN
+    UPDATE order_t
+    SET
+      state_id = NEW.state_id,
+      lots = NEW.lots,
+      resd_lots = NEW.resd_lots,
+      exec_lots = NEW.exec_lots,
+      exec_cost = NEW.exec_cost,
+      last_lots = NEW.last_lots,
+      last_ticks = NEW.last_ticks,
+      modified = NEW.created
+    WHERE market_id = NEW.market_id
+    AND id = NEW.order_id;
+  END
+;
+
+DROP TRIGGER IF EXISTS after_insert_on_exec1
+;
+
+CREATE TRIGGER after_insert_on_exec1
+  AFTER INSERT ON exec_t
+  BEGIN
+    INSERT INTO accnt_t (
+      symbol,
+      max_id,
+      created,
+      modified
+    ) VALUES (
+      NEW.accnt,
+      1,
+      NEW.created,
+      NEW.created
+    ) ON CONFLICT (symbol) DO UPDATE
+    SET
+      max_id = max_id + 1,
+      modified = excluded.modified;
+  END
+;
+
+COMMIT
+;
@@ -0,0 +1,115 @@
+-- The Restful Matching-Engine.
+-- Copyright (C) 2013, 2017 Swirly Cloud Limited.
+--
+-- This program is free software; you can redistribute it and/or modify it under the terms of the
+-- GNU General Public License as published by the Free Software Foundation; either version 2 of the
+-- License, or (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+-- even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+-- General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License along with this program; if
+-- not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+-- 02110-1301, USA.
+
+-- Migrate a database created before posn_t to the materialised position table. Positions are
+-- backfilled from trades in exec_t. The script may be run more than once.
+
+-- Use ';' on single line to terminate statement.
+PRAGMA foreign_keys = ON
+;
+
+BEGIN TRANSACTION
+;
+
+CREATE TABLE IF NOT EXISTS posn_t (
+  accnt CHAR(16) NOT NULL,
+  market_id BIGINT NOT NULL,
+  instr CHAR(16) NOT NULL,
+  settl_day INT NULL DEFAULT NULL,
+  buy_lots BIGINT NOT NULL DEFAULT 0,
+  buy_cost BIGINT NOT NULL DEFAULT 0,
+  sell_lots BIGINT NOT NULL DEFAULT 0,
+  sell_cost BIGINT NOT NULL DEFAULT 0,
+
+  PRIMARY KEY (accnt, market_id),
+
+  FOREIGN KEY (market_id) REFERENCES market_t (id),
+  FOREIGN KEY (instr) REFERENCES instr_t (symbol)
+)
+;
+
+DELETE FROM posn_t
+;
+
+INSERT INTO posn_t (
+  accnt,
+  market_id,
+  instr,
+  settl_day,
+  buy_lots,
+  buy_cost,
+  sell_lots,
+  sell_cost
+)
+  SELECT
+    e.accnt,
+    e.market_id,
+    MAX(e.instr),
+    MAX(e.settl_day),
+    SUM(CASE WHEN e.side_id = 1 THEN e.last_lots ELSE 0 END),
+    SUM(CASE WHEN e.side_id = 1 THEN e.last_lots * e.last_ticks ELSE 0 END),
+    SUM(CASE WHEN e.side_id = -1 THEN e.last_lots ELSE 0 END),
+    SUM(CASE WHEN e.side_id = -1 THEN e.last_lots * e.last_ticks ELSE 0 END)
+  FROM exec_t e
+  WHERE e.state_id = 4
+  GROUP BY e.accnt, e.market_id
+;
+
+CREATE TRIGGER IF NOT EXISTS after_insert_on_exec2
+  AFTER INSERT ON exec_t
+  WHEN NEW.state_id = 4
+  BEGIN
+    INSERT OR IGNORE INTO posn_t (
+      accnt,
+      market_id,
+      instr,
+      settl_day
+    ) VALUES (
+      NEW.accnt,
+      NEW.market_id,
+      NEW.instr,
+      NEW.settl_day
+    );
+    UPDATE posn_t
+    SET
+      buy_lots = buy_lots + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots ELSE 0 END,
+      buy_cost = buy_cost
+        + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END,
+      sell_lots = sell_lots + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots ELSE 0 END,
+      sell_cost = sell_cost
+        + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END
+    WHERE accnt = NEW.accnt
+    AND market_id = NEW.market_id;
+  END
+;
+
+DROP VIEW IF EXISTS posn_v
+;
+
+CREATE VIEW posn_v AS
+  SELECT
+    p.accnt,
+    p.market_id,
+    p.instr,
+    p.settl_day,
+    p.buy_lots,
+    p.buy_cost,
+    p.sell_lots,
+    p.sell_cost
+  FROM posn_t p
+;
+
+COMMIT
+;
@@ -0,0 +1,171 @@
+-- The Restful Matching-Engine.
+-- Copyright (C) 2013, 2017 Swirly Cloud Limited.
+--
+-- This program is free software; you can redistribute it and/or modify it under the terms of the
+-- GNU General Public License as published by the Free Software Foundation; either version 2 of the
+-- License, or (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+-- even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+-- General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License along with this program; if
+-- not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+-- 02110-1301, USA.
+
+-- Migrate a database created before time-in-force was journaled. Existing orders and executions are
+-- good-till-cancel. SQLite cannot add a column conditionally, so the script must be run only once.
+
+-- Use ';' on single line to terminate statement.
+PRAGMA foreign_keys = ON
+;
+
+BEGIN TRANSACTION
+;
+
+CREATE TABLE IF NOT EXISTS tif_t (
+  id INT NOT NULL PRIMARY KEY,
+  symbol CHAR(16) NOT NULL UNIQUE
+)
+;
+
+INSERT OR IGNORE INTO tif_t (id, symbol) VALUES (1, 'GTC')
+;
+INSERT OR IGNORE INTO tif_t (id, symbol) VALUES (2, 'IOC')
+;
+INSERT OR IGNORE INTO tif_t (id, symbol) VALUES (3, 'FOK')
+;
+
+ALTER TABLE order_t ADD COLUMN tif_id INT NOT NULL DEFAULT 1 REFERENCES tif_t (id)
+;
+
+ALTER TABLE exec_t ADD COLUMN tif_id INT NOT NULL DEFAULT 1 REFERENCES tif_t (id)
+;
+
+DROP TRIGGER IF EXISTS before_insert_on_exec1
+;
+
+CREATE TRIGGER before_insert_on_exec1
+  BEFORE INSERT ON exec_t
+  WHEN NEW.order_id IS NOT NULL
+  AND NEW.state_id = 1
+  BEGIN
+    INSERT INTO order_t (
+      accnt,
+      market_id,
+      instr,
+      settl_day,
+      id,
+      ref,
+      state_id,
+      side_id,
+      lots,
+      ticks,
+      resd_lots,
+      exec_lots,
+      exec_cost,
+      last_lots,
+      last_ticks,
+      min_lots,
+      tif_id,
+      created,
+      modified
+    ) VALUES (
+      NEW.accnt,
+      NEW.market_id,
+      NEW.instr,
+      NEW.settl_day,
+      NEW.order_id,
+      NEW.ref,
+      NEW.state_id,
+      NEW.side_id,
+      NEW.lots,
+      NEW.ticks,
+      NEW.resd_lots,
+      NEW.exec_lots,
+      NEW.exec_cost,
+      NEW.last_lots,
+      NEW.last_ticks,
+      NEW.min_lots,
+      NEW.tif_id,
+      NEW.created,
+      NEW.created
+    );
+  END
+;
+
+DROP VIEW IF EXISTS order_v
+;
+
+CREATE VIEW order_v AS
+  SELECT
+    o.accnt,
+    o.market_id,
+    o.instr,
+    o.settl_day,
+    o.id,
+    o.ref,
+    s.symbol state,
+    a.symbol side,
+    o.lots,
+    o.ticks,
+    o.resd_lots,
+    o.exec_lots,
+    o.exec_cost,
+    o.last_lots,
+    o.last_ticks,
+    o.min_lots,
+    t.symbol tif,
+    o.created,
+    o.modified
+  FROM order_t o
+  LEFT OUTER JOIN state_t s
+  ON o.state_id = s.id
+  LEFT OUTER JOIN side_t a
+  ON o.side_id = a.id
+  LEFT OUTER JOIN tif_t t
+  ON o.tif_id = t.id
+;
+
+DROP VIEW IF EXISTS exec_v
+;
+
+CREATE VIEW exec_v AS
+  SELECT
+    e.accnt,
+    e.market_id,
+    e.instr,
+    e.settl_day,
+    e.id,
+    e.order_id,
+    e.ref,
+    e.seq_id,
+    s.symbol state,
+    a.symbol side,
+    e.lots,
+    e.ticks,
+    e.resd_lots,
+    e.exec_lots,
+    e.exec_cost,
+    e.last_lots,
+    e.last_ticks,
+    e.min_lots,
+    e.match_id,
+    r.symbol liqind,
+    t.symbol tif,
+    e.cpty,
+    e.created,
+    e.archive
+  FROM exec_t e
+  LEFT OUTER JOIN state_t s
+  ON e.state_id = s.id
+  LEFT OUTER JOIN side_t a
+  ON e.side_id = a.id
+  LEFT OUTER JOIN liqind_t r
+  ON e.liqind_id = r.id
+  LEFT OUTER JOIN tif_t t
+  ON e.tif_id = t.id
+;
+
+COMMIT
+;
@@ -68,6 +68,19 @@ INSERT INTO liqind_t (id, symbol) VALUES (1, 'MAKER')
 INSERT INTO liqind_t (id, symbol) VALUES (2, 'TAKER')
 ;
 
+CREATE TABLE tif_t (
+  id INT NOT NULL PRIMARY KEY,
+  symbol CHAR(16) NOT NULL UNIQUE
+)
+;
+
+INSERT INTO tif_t (id, symbol) VALUES (1, 'GTC')
+;
+INSERT INTO tif_t (id, symbol) VALUES (2, 'IOC')
+;
+INSERT INTO tif_t (id, symbol) VALUES (3, 'FOK')
+;
+
 CREATE TABLE asset_type_t (
   id INT NOT NULL PRIMARY KEY,
   symbol CHAR(16) NOT NULL UNIQUE
@@ -156,6 +169,7 @@ CREATE TABLE order_t (
   last_lots BIGINT NULL DEFAULT NULL,
   last_ticks BIGINT NULL DEFAULT NULL,
   min_lots BIGINT NOT NULL DEFAULT 1,
+  tif_id INT NOT NULL DEFAULT 1,
   created BIGINT NOT NULL,
   modified BIGINT NOT NULL,
 
@@ -164,7 +178,8 @@ CREATE TABLE order_t (
   FOREIGN KEY (market_id) REFERENCES market_t (id),
   FOREIGN KEY (instr) REFERENCES instr_t (symbol),
   FOREIGN KEY (state_id) REFERENCES state_t (id),
-  FOREIGN KEY (side_id) REFERENCES side_t (id)
+  FOREIGN KEY (side_id) REFERENCES side_t (id),
+  FOREIGN KEY (tif_id) REFERENCES tif_t (id)
 )
 ;
 
@@ -191,6 +206,7 @@ CREATE TABLE exec_t (
   min_lots BIGINT NOT NULL DEFAULT 1,
   match_id BIGINT NULL DEFAULT NULL,
   liqind_id INT NULL DEFAULT NULL,
+  tif_id INT NOT NULL DEFAULT 1,
   cpty CHAR(16) NULL DEFAULT NULL,
   created BIGINT NOT NULL,
   archive BIGINT NULL DEFAULT NULL,
@@ -202,13 +218,31 @@ CREATE TABLE exec_t (
   FOREIGN KEY (instr) REFERENCES instr_t (symbol),
   FOREIGN KEY (state_id) REFERENCES state_t (id),
   FOREIGN KEY (side_id) REFERENCES side_t (id),
-  FOREIGN KEY (liqind_id) REFERENCES liqind_t (id)
+  FOREIGN KEY (liqind_id) REFERENCES liqind_t (id),
+  FOREIGN KEY (tif_id) REFERENCES tif_t (id)
 )
 ;
 
 CREATE INDEX exec_accnt_seq_id_idx ON exec_t (accnt, seq_id);
 CREATE INDEX exec_state_archive_idx ON exec_t (state_id, archive);
 
+CREATE TABLE posn_t (
+  accnt CHAR(16) NOT NULL,
+  market_id BIGINT NOT NULL,
+  instr CHAR(16) NOT NULL,
+  settl_day INT NULL DEFAULT NULL,
+  buy_lots BIGINT NOT NULL DEFAULT 0,
+  buy_cost BIGINT NOT NULL DEFAULT 0,
+  sell_lots BIGINT NOT NULL DEFAULT 0,
+  sell_cost BIGINT NOT NULL DEFAULT 0,
+
+  PRIMARY KEY (accnt, market_id),
+
+  FOREIGN KEY (market_id) REFERENCES market_t (id),
+  FOREIGN KEY (instr) REFERENCES instr_t (symbol)
+)
+;
+
 CREATE TRIGGER before_insert_on_exec1
   BEFORE INSERT ON exec_t
   WHEN NEW.order_id IS NOT NULL
@@ -231,6 +265,7 @@ CREATE TRIGGER before_insert_on_exec1
       last_lots,
       last_ticks,
       min_lots,
+      tif_id,
       created,
       modified
     ) VALUES (
@@ -250,6 +285,7 @@ CREATE TRIGGER before_insert_on_exec1
       NEW.last_lots,
       NEW.last_ticks,
       NEW.min_lots,
+      NEW.tif_id,
       NEW.created,
       NEW.created
     );
@@ -271,7 +307,8 @@ CREATE TRIGGER before_insert_on_exec2
       last_lots = NEW.last_lots,
       last_ticks = NEW.last_ticks,
       modified = NEW.created
-    WHERE id = NEW.order_id;
+    WHERE market_id = NEW.market_id
+    AND id = NEW.order_id;
   END
 ;
 
@@ -288,28 +325,53 @@ CREATE TRIGGER before_insert_on_exec3
   END
 ;
 
+-- The journal assigns seq_id from accnt_t.max_id + 1 when inserting the exec, so that the exec row
+-- is never updated after insert.
 CREATE TRIGGER after_insert_on_exec1
   AFTER INSERT ON exec_t
   BEGIN
-    INSERT OR IGNORE INTO accnt_t (
+    INSERT INTO accnt_t (
       symbol,
+      max_id,
       created,
       modified
     ) VALUES (
       NEW.accnt,
+      1,
       NEW.created,
       NEW.created
-    );
-    UPDATE accnt_t
+    ) ON CONFLICT (symbol) DO UPDATE
     SET
       max_id = max_id + 1,
-      modified = NEW.created
-    WHERE symbol = NEW.accnt;
-    UPDATE exec_t
+      modified = excluded.modified;
+  END
+;
+
+CREATE TRIGGER after_insert_on_exec2
+  AFTER INSERT ON exec_t
+  WHEN NEW.state_id = 4
+  BEGIN
+    INSERT OR IGNORE INTO posn_t (
+      accnt,
+      market_id,
+      instr,
+      settl_day
+    ) VALUES (
+      NEW.accnt,
+      NEW.market_id,
+      NEW.instr,
+      NEW.settl_day
+    );
+    UPDATE posn_t
     SET
-      seq_id = (SELECT max_id FROM accnt_t WHERE symbol = NEW.accnt)
-    WHERE market_id = NEW.market_id
-    AND id = NEW.id;
+      buy_lots = buy_lots + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots ELSE 0 END,
+      buy_cost = buy_cost
+        + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END,
+      sell_lots = sell_lots + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots ELSE 0 END,
+      sell_cost = sell_cost
+        + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END
+    WHERE accnt = NEW.accnt
+    AND market_id = NEW.market_id;
   END
 ;
 
@@ -378,6 +440,7 @@ CREATE VIEW order_v AS
     o.last_lots,
     o.last_ticks,
     o.min_lots,
+    t.symbol tif,
     o.created,
     o.modified
   FROM order_t o
@@ -385,6 +448,8 @@ CREATE VIEW order_v AS
   ON o.state_id = s.id
   LEFT OUTER JOIN side_t a
   ON o.side_id = a.id
+  LEFT OUTER JOIN tif_t t
+  ON o.tif_id = t.id
 ;
 
 CREATE VIEW exec_v AS
@@ -409,6 +474,7 @@ CREATE VIEW exec_v AS
     e.min_lots,
     e.match_id,
     r.symbol liqind,
+    t.symbol tif,
     e.cpty,
     e.created,
     e.archive
@@ -419,20 +485,21 @@ CREATE VIEW exec_v AS
   ON e.side_id = a.id
   LEFT OUTER JOIN liqind_t r
   ON e.liqind_id = r.id
+  LEFT OUTER JOIN tif_t t
+  ON e.tif_id = t.id
 ;
 
 CREATE VIEW posn_v AS
   SELECT
-    e.accnt,
-    e.market_id,
-    e.instr,
-    e.settl_day,
-    e.side_id,
-    SUM(e.last_lots) lots,
-    SUM(e.last_lots * e.last_ticks) cost
-  FROM exec_t e
-  WHERE e.state_id = 4
-  GROUP BY e.accnt, e.market_id, e.side_id
+    p.accnt,
+    p.market_id,
+    p.instr,
+    p.settl_day,
+    p.buy_lots,
+    p.buy_cost,
+    p.sell_lots,
+    p.sell_cost
+  FROM posn_t p
 ;
 
 COMMIT
@@ -73,6 +73,7 @@ class SWIRLY_API Accnt : public Comparable<Accnt> {
     const auto& posns() const noexcept { return posns_; }
 
     auto& orders() noexcept { return orders_; }
+    auto& posns() noexcept { return posns_; }
     Order& order(Id64 marketId, Id64 id)
     {
         auto it = orders_.find(marketId, id);
@@ -126,13 +127,18 @@ class SWIRLY_API Accnt : public Comparable<Accnt> {
         assert(trade.accnt() == symbol_);
         return trades_.remove(trade);
     }
-    PosnPtr posn(Id64 marketId, Symbol instr, JDay settlDay) throw(std::bad_alloc);
+    PosnPtr posn(Id64 marketId, Symbol instr, JDay settlDay);
 
     void insertPosn(const PosnPtr& posn) noexcept
     {
         assert(posn->accnt() == symbol_);
         posns_.insert(posn);
     }
+    PosnPtr removePosn(const Posn& posn) noexcept
+    {
+        assert(posn.accnt() == symbol_);
+        return posns_.remove(posn);
+    }
     boost::intrusive::set_member_hook<> symbolHook_;
     using PosnSet = IdSet<Posn, MarketIdTraits<Posn>>;
 
@@ -19,7 +19,12 @@
 #include <swirly/fin/Exec.hpp>
 #include <swirly/fin/Journ.hpp>
 
+#include <swirly/util/Atomic.hpp>
+#include <swirly/util/BinLog.hpp>
 #include <swirly/util/Log.hpp>
+#include <swirly/util/Trace.hpp>
+
+#include <vector>
 
 using namespace std;
 
@@ -59,24 +64,87 @@ class MultiPart {
     detail::AsyncWindow<StepN> window_;
 };
 
-void worker(MsgPipe& pipe, Journ& journ)
+void worker(MsgPipe& pipe, Journ& journ, size_t batchSize, Micros batchLatency,
+            AsyncJournStats& stats)
 {
+    using Clock = MonoClock;
+
     SWIRLY_NOTICE(logMsg() << "started async journal");
-    auto fn = [&journ](const auto& msg) {
+    vector<Msg> batch;
+    batch.reserve(batchSize);
+    auto fn = [&batch](const auto& msg) { batch.push_back(msg); };
+    while (pipe.read(fn)) {
+        // Drain whatever is already available, bounded by batch size and latency. A batch is never
+        // split part-way through a multi-part sequence, because the journal may commit each batch
+        // as a unit.
+        const auto start = Clock::now();
+        for (;;) {
+            if (moreOf(batch.back()) == More::Yes) {
+                if (!pipe.read(fn)) {
+                    break;
+                }
+            } else if (batch.size() >= batchSize || Clock::now() - start >= batchLatency
+                       || !pipe.tryRead(fn)) {
+                break;
+            }
+        }
+        const auto commitStart = Clock::now();
         try {
-            journ.update(msg);
+            if (batch.size() == 1) {
+                journ.update(batch.front());
+            } else {
+                journ.update(batch);
+            }
         } catch (const exception& e) {
             SWIRLY_ERROR(logMsg() << "failed to update journal: " << e.what());
         }
-    };
-    while (pipe.read(fn))
-        ;
-    SWIRLY_NOTICE(logMsg() << "stopped async journal");
+        stats.record(batch.size(), Clock::now() - commitStart, journ.seq());
+        batch.clear();
+    }
+    SWIRLY_NOTICE(logMsg() << "stopped async journal: " << stats);
 }
 } // anonymous
 
-AsyncJourn::AsyncJourn(Journ& journ, size_t pipeCapacity)
-    : pipe_{pipeCapacity}, thread_{worker, ref(pipe_), ref(journ)}
+void AsyncJournStats::record(size_t size, Nanos commitTime, uint64_t seq) noexcept
+{
+    // Published before the message count, so that a flush observes the sequence of the batch.
+    seq_.store(seq, memory_order_release);
+    singleWriterAdd(batches_, 1);
+    singleWriterAdd(msgs_, size, memory_order_release);
+    if (size > maxBatch_.load(memory_order_relaxed)) {
+        maxBatch_.store(size, memory_order_relaxed);
+    }
+    auto& bucket = buckets_[min<size_t>(63 - __builtin_clzll(size | 1), Buckets - 1)];
+    singleWriterAdd(bucket, 1);
+    const auto ns = commitTime.count();
+    singleWriterAdd(commitTime_, ns);
+    if (ns > maxCommitTime_.load(memory_order_relaxed)) {
+        maxCommitTime_.store(ns, memory_order_relaxed);
+    }
+}
+
+ostream& operator<<(ostream& os, const AsyncJournStats& stats)
+{
+    const auto batches = stats.batches();
+    os << "batches=" << batches << ",msgs=" << stats.msgs() << ",max_batch=" << stats.maxBatch()
+       << ",mean_commit_us="
+       << (batches > 0 ? chrono::duration_cast<Micros>(stats.commitTime()).count() / batches : 0)
+       << ",max_commit_us=" << chrono::duration_cast<Micros>(stats.maxCommitTime()).count()
+       << ",buckets=";
+    for (size_t i{0}; i < AsyncJournStats::Buckets; ++i) {
+        if (i > 0) {
+            os << '/';
+        }
+        os << stats.bucket(i);
+    }
+    return os;
+}
+
+AsyncJourn::AsyncJourn(Journ& journ, size_t pipeCapacity, PipeIdle pipeIdle, size_t batchSize,
+                       Micros batchLatency)
+    : pipe_{pipeCapacity, pipeIdle},
+      stats_{journ.seq()},
+      thread_{worker, ref(pipe_), ref(journ), max<size_t>(batchSize, 1), batchLatency, ref(stats_)}
 {
 }
 
@@ -94,6 +162,13 @@ AsyncJourn::~AsyncJourn() noexcept
     }
 }
 
+void AsyncJourn::flush() const noexcept
+{
+    while (stats_.msgs() < written_) {
+        this_thread::yield();
+    }
+}
+
 void AsyncJourn::createExec(ArrayView<ConstExecPtr> execs)
 {
     MultiPart<1> mp{*this, execs.size()};
@@ -113,10 +188,12 @@ void AsyncJourn::archiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified)
 void AsyncJourn::doReset()
 {
     pipe_.write([](Msg& msg) { msg.type = MsgType::Reset; });
+    ++written_;
 }
 
 void AsyncJourn::doCreateMarket(Id64 id, Symbol instr, JDay settlDay, MarketState state)
 {
+    TraceScope ts{TraceStage::Journ};
     pipe_.write([id, &instr, settlDay, state](Msg& msg) {
         msg.type = MsgType::CreateMarket;
         auto& body = msg.createMarket;
@@ -125,20 +202,31 @@ void AsyncJourn::doCreateMarket(Id64 id, Symbol instr, JDay settlDay, MarketStat
         body.settlDay = settlDay;
         body.state = state;
     });
+    ++written_;
 }
 
 void AsyncJourn::doUpdateMarket(Id64 id, MarketState state)
 {
+    TraceScope ts{TraceStage::Journ};
     pipe_.write([&id, state](Msg& msg) {
         msg.type = MsgType::UpdateMarket;
         auto& body = msg.updateMarket;
         body.id = id;
         body.state = state;
     });
+    ++written_;
 }
 
 void AsyncJourn::doCreateExec(const Exec& exec, More more)
 {
+    TraceScope ts{TraceStage::Journ};
+    SWIRLY_BINLOG(LogInfo,
+                  "exec: accnt={},market_id={},id={},order_id={},state={},side={},lots={},ticks={},"
+                  "resd_lots={},exec_lots={},last_lots={},last_ticks={},match_id={},liq_ind={},"
+                  "cpty={}",
+                  exec.accnt(), exec.marketId(), exec.id(), exec.orderId(), exec.state(),
+                  exec.side(), exec.lots(), exec.ticks(), exec.resdLots(), exec.execLots(),
+                  exec.lastLots(), exec.lastTicks(), exec.matchId(), exec.liqInd(), exec.cpty());
     pipe_.write([&exec, more](Msg& msg) {
         msg.type = MsgType::CreateExec;
         auto& body = msg.createExec;
@@ -161,14 +249,17 @@ void AsyncJourn::doCreateExec(const Exec& exec, More more)
         body.minLots = exec.minLots();
         body.matchId = exec.matchId();
         body.liqInd = exec.liqInd();
+        body.tif = exec.tif();
         setCString(body.cpty, exec.cpty());
         body.created = msSinceEpoch(exec.created());
         body.more = more;
     });
+    ++written_;
 }
 
 void AsyncJourn::doArchiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified, More more)
 {
+    TraceScope ts{TraceStage::Journ};
     assert(ids.size() <= MaxIds);
     pipe_.write([&marketId, ids, modified, more](Msg& msg) {
         msg.type = MsgType::ArchiveTrade;
@@ -187,6 +278,7 @@ void AsyncJourn::doArchiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modifie
         body.modified = msSinceEpoch(modified);
         body.more = more;
     });
+    ++written_;
 }
 
 } // swirly
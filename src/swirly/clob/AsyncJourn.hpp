@@ -20,6 +20,9 @@
 #include <swirly/fin/Msg.hpp>
 
 #include <swirly/util/Array.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <atomic>
 
 namespace swirly {
 
@@ -58,9 +61,80 @@ class AsyncWindow {
 
 } // detail
 
+/**
+ * Batch counters maintained by the journal thread. The counters may be read from other threads.
+ */
+class SWIRLY_API AsyncJournStats {
+  public:
+    /**
+     * Number of batch-size buckets. Bucket i counts batches of size [2^i, 2^(i+1)), and the last
+     * bucket counts all larger batches.
+     */
+    enum : std::size_t { Buckets = 8 };
+
+    explicit AsyncJournStats(std::uint64_t seq = 0) noexcept : seq_{seq} {}
+    ~AsyncJournStats() noexcept = default;
+
+    // Copy.
+    AsyncJournStats(const AsyncJournStats&) = delete;
+    AsyncJournStats& operator=(const AsyncJournStats&) = delete;
+
+    // Move.
+    AsyncJournStats(AsyncJournStats&&) = delete;
+    AsyncJournStats& operator=(AsyncJournStats&&) = delete;
+
+    std::uint64_t batches() const noexcept { return batches_.load(std::memory_order_relaxed); }
+    /**
+     * @return the number of messages processed by the journal thread. The acquire ordering ensures
+     * that the journal sequence number is at least as recent as the count.
+     */
+    std::uint64_t msgs() const noexcept { return msgs_.load(std::memory_order_acquire); }
+    /**
+     * @return the sequence number of the underlying journal after the last batch.
+     */
+    std::uint64_t seq() const noexcept { return seq_.load(std::memory_order_acquire); }
+    std::uint64_t maxBatch() const noexcept { return maxBatch_.load(std::memory_order_relaxed); }
+    std::uint64_t bucket(std::size_t i) const noexcept
+    {
+        return buckets_[i].load(std::memory_order_relaxed);
+    }
+    /**
+     * Total time spent committing batches to the journal.
+     */
+    Nanos commitTime() const noexcept
+    {
+        return Nanos{commitTime_.load(std::memory_order_relaxed)};
+    }
+    Nanos maxCommitTime() const noexcept
+    {
+        return Nanos{maxCommitTime_.load(std::memory_order_relaxed)};
+    }
+    /**
+     * Record batch and publish the sequence number of the underlying journal after the batch. Must
+     * only be called from the journal thread.
+     */
+    void record(std::size_t size, Nanos commitTime, std::uint64_t seq) noexcept;
+
+  private:
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> msgs_{0};
+    std::atomic<std::uint64_t> maxBatch_{0};
+    std::atomic<std::uint64_t> buckets_[Buckets]{};
+    std::atomic<std::int64_t> commitTime_{0};
+    std::atomic<std::int64_t> maxCommitTime_{0};
+    std::atomic<std::uint64_t> seq_;
+};
+
+SWIRLY_API std::ostream& operator<<(std::ostream& os, const AsyncJournStats& stats);
+
 class SWIRLY_API AsyncJourn {
   public:
-    AsyncJourn(Journ& journ, std::size_t pipeCapacity);
+    /**
+     * The journal thread drains up to batchSize messages, or as many as it can within
+     * batchLatency of the first, and commits them as a single batch.
+     */
+    AsyncJourn(Journ& journ, std::size_t pipeCapacity, PipeIdle pipeIdle = PipeIdle::Park,
+               std::size_t batchSize = 1 << 6, Micros batchLatency = 1ms);
     ~AsyncJourn() noexcept;
 
     // Copy.
@@ -71,6 +145,32 @@ class SWIRLY_API AsyncJourn {
     AsyncJourn(AsyncJourn&&) = delete;
     AsyncJourn& operator=(AsyncJourn&&) = delete;
 
+    const AsyncJournStats& stats() const noexcept { return stats_; }
+    /**
+     * @return the number of messages waiting for the journal thread.
+     */
+    std::size_t depth() const noexcept { return pipe_.size(); }
+    std::size_t capacity() const noexcept { return pipe_.capacity(); }
+    /**
+     * @return the number of times that the engine waited for space in a full pipe.
+     */
+    std::uint64_t stalls() const noexcept { return pipe_.stalls(); }
+    /**
+     * @return the total time that the engine waited for space in a full pipe.
+     */
+    Nanos stallTime() const noexcept { return pipe_.stallTime(); }
+    /**
+     * @return the sequence number of the underlying journal, as published by the journal thread
+     * after its last batch. Messages that the journal failed to write are not counted, so after
+     * flush() this is the sequence number of the last message actually journaled.
+     */
+    std::uint64_t seq() const noexcept { return stats_.seq(); }
+
+    /**
+     * Block until the journal thread has processed all messages written to the pipe.
+     */
+    void flush() const noexcept;
+
     /**
      * Reset multi-part sequence.
      */
@@ -118,7 +218,9 @@ class SWIRLY_API AsyncJourn {
 
     void doArchiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified, More more);
 
+    std::uint64_t written_{0};
     MsgPipe pipe_;
+    AsyncJournStats stats_;
     std::thread thread_;
 };
 
@@ -26,7 +26,10 @@
 
 #include <swirly/unit/Test.hpp>
 
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 using namespace std;
 using namespace swirly;
@@ -78,6 +81,46 @@ struct TestJourn : Journ {
     queue<Msg> msgs_;
 };
 
+struct BatchJourn : TestJourn {
+    vector<size_t> batches() const
+    {
+        lock_guard<mutex> lock{mutex_};
+        return batches_;
+    }
+
+  protected:
+    void doUpdateBatch(ArrayView<Msg> msgs) override
+    {
+        {
+            lock_guard<mutex> lock{mutex_};
+            batches_.push_back(msgs.size());
+        }
+        TestJourn::doUpdateBatch(msgs);
+    }
+
+  private:
+    mutable mutex mutex_;
+    vector<size_t> batches_;
+};
+
+/**
+ * Numbered journal that fails to write messages that close a market.
+ */
+struct SeqJourn : Journ {
+  protected:
+    void doUpdate(const Msg& msg) override
+    {
+        if (msg.type == MsgType::UpdateMarket && msg.updateMarket.state == 0) {
+            throw runtime_error{"update failed"};
+        }
+        ++seq_;
+    }
+    uint64_t doSeq() const noexcept override { return seq_; }
+
+  private:
+    uint64_t seq_{10};
+};
+
 struct AsyncJournFixture {
     AsyncJournFixture() : asyncJourn{journ, 1 << 10} {}
     TestJourn journ;
@@ -156,6 +199,21 @@ SWIRLY_TEST_CASE(AsyncWindow)
     }
 }
 
+SWIRLY_TEST_CASE(AsyncJournSeq)
+{
+    SeqJourn journ;
+    AsyncJourn asyncJourn{journ, 1 << 10};
+    SWIRLY_CHECK(asyncJourn.seq() == 10);
+
+    asyncJourn.updateMarket(MarketId, 0x1);
+    asyncJourn.updateMarket(MarketId, 0x0);
+    asyncJourn.updateMarket(MarketId, 0x1);
+    asyncJourn.flush();
+
+    // The failed message is not counted.
+    SWIRLY_CHECK(asyncJourn.seq() == 12);
+}
+
 SWIRLY_FIXTURE_TEST_CASE(AsyncJournCreateMarket, AsyncJournFixture)
 {
     asyncJourn.createMarket(MarketId, "EURUSD"_sv, SettlDay, 0x1);
@@ -280,3 +338,38 @@ SWIRLY_FIXTURE_TEST_CASE(AsyncJournArchiveTrade, AsyncJournFixture)
         }
     }
 }
+
+SWIRLY_TEST_CASE(AsyncJournBatch)
+{
+    vector<Id64> ids;
+    ids.reserve(3 * MaxIds);
+
+    Id64 id{};
+    generate_n(back_insert_iterator<decltype(ids)>(ids), ids.capacity(), [&id]() { return ++id; });
+
+    BatchJourn journ;
+    {
+        // Batch size of one, but multi-part sequences must not be split.
+        AsyncJourn asyncJourn{journ, 1 << 10, PipeIdle::Park, 1};
+        asyncJourn.archiveTrade(MarketId, ids, Now);
+        asyncJourn.updateMarket(MarketId, 0x1);
+
+        for (int i{0}; i < 4; ++i) {
+            Msg msg;
+            SWIRLY_CHECK(journ.pop(msg));
+        }
+        const auto& stats = asyncJourn.stats();
+        for (int i{0}; i < 1000 && stats.msgs() < 4; ++i) {
+            this_thread::sleep_for(1ms);
+        }
+        SWIRLY_CHECK(stats.batches() == 2);
+        SWIRLY_CHECK(stats.msgs() == 4);
+        SWIRLY_CHECK(stats.maxBatch() == 3);
+        SWIRLY_CHECK(stats.bucket(0) == 1);
+        SWIRLY_CHECK(stats.bucket(1) == 1);
+    }
+    // Single messages bypass the batch path.
+    const auto batches = journ.batches();
+    SWIRLY_CHECK(batches.size() == 1);
+    SWIRLY_CHECK(batches[0] == 3);
+}
@@ -24,9 +24,12 @@
 #include <swirly/fin/Exception.hpp>
 #include <swirly/fin/Journ.hpp>
 #include <swirly/fin/Model.hpp>
+#include <swirly/fin/Snap.hpp>
 
 #include <swirly/util/Date.hpp>
 #include <swirly/util/Finally.hpp>
+#include <swirly/util/Log.hpp>
+#include <swirly/util/Trace.hpp>
 
 #include "Match.hxx"
 
@@ -48,6 +51,35 @@ Ticks spread(const Order& takerOrder, const Order& makerOrder, Direct direct) no
         : takerOrder.ticks() - makerOrder.ticks();
 }
 
+/**
+ * @return true if the levels that cross with the taker's price hold enough lots to fill it in full.
+ */
+bool canFill(const Market& market, Side side, Lots lots, Ticks ticks) noexcept
+{
+    Direct direct;
+    const MarketSide* marketSide;
+    if (side == Side::Buy) {
+        direct = Direct::Paid;
+        marketSide = &market.offerSide();
+    } else {
+        assert(side == Side::Sell);
+        direct = Direct::Given;
+        marketSide = &market.bidSide();
+    }
+    auto sumLots = 0_lts;
+    for (const auto& level : marketSide->levels()) {
+        // Only consider levels while prices cross.
+        if ((direct == Direct::Paid ? level.ticks() - ticks : ticks - level.ticks()) > 0_tks) {
+            break;
+        }
+        sumLots += level.lots();
+        if (sumLots >= lots) {
+            return true;
+        }
+    }
+    return false;
+}
+
 template <typename ValueT>
 inline auto& constCast(const ValueT& ref)
 {
@@ -58,26 +90,65 @@ inline auto& constCast(const ValueT& ref)
 
 struct Serv::Impl {
 
-    Impl(Journ& journ, size_t pipeCapacity, size_t maxExecs) noexcept
-        : journ_{journ, pipeCapacity}, maxExecs_{maxExecs}
+    Impl(Journ& journ, size_t pipeCapacity, size_t maxExecs, PipeIdle pipeIdle, size_t batchSize,
+         Micros batchLatency) noexcept
+        : journ_{journ, pipeCapacity, pipeIdle, batchSize, batchLatency}, maxExecs_{maxExecs}
     {
         matches_.reserve(8);
         execs_.reserve(1 + 16);
     }
 
-    void load(const Model& model, Time now)
+    /**
+     * Load shards from the model. Reference data is read for each shard, but all other rows are
+     * read once, and each row is routed to the shard that owns its market. A null shard discards
+     * the rows that it would own.
+     */
+    static void load(const Model& model, Time now, ArrayView<Impl*> shards)
     {
-        const auto busDay = busDay_(now);
-        model.readAsset([& assets = assets_](auto ptr) { assets.insert(move(ptr)); });
-        model.readInstr([& instrs = instrs_](auto ptr) { instrs.insert(move(ptr)); });
-        model.readAccnt(now, [this, &model](auto symbol) {
-            auto& accnt = this->accnt(symbol);
-            model.readExec(symbol, accnt.execs().capacity(),
-                           [&accnt](auto ptr) { accnt.pushExecBack(ptr); });
+        const auto owner = [shards](Id64 marketId) {
+            return shards[shardOf(marketId, shards.size())];
+        };
+        const auto* first = *find_if(shards.begin(), shards.end(), [](auto* impl) { return impl; });
+        const auto busDay = first->busDay_(now);
+        model.prefetch(now, first->maxExecs_);
+        for (auto* impl : shards) {
+            if (impl) {
+                model.readAsset([& assets = impl->assets_](auto ptr) { assets.insert(move(ptr)); });
+                model.readInstr([& instrs = impl->instrs_](auto ptr) { instrs.insert(move(ptr)); });
+            }
+        }
+        model.readAccnt(now, [shards](auto symbol) {
+            for (auto* impl : shards) {
+                if (impl) {
+                    impl->accnt(symbol);
+                }
+            }
+        });
+        // Execs are grouped by account, so the account lookup is only repeated when it changes.
+        vector<Accnt*> accnts(shards.size(), nullptr);
+        model.readAllExec(now, first->maxExecs_, [shards, &accnts](auto ptr) {
+            const auto i = shardOf(ptr->marketId(), shards.size());
+            auto* const impl = shards[i];
+            if (!impl) {
+                return;
+            }
+            auto*& accnt = accnts[i];
+            if (!accnt || accnt->symbol() != ptr->accnt()) {
+                accnt = &impl->accnt(ptr->accnt());
+            }
+            accnt->pushExecBack(ptr);
+        });
+        model.readMarket([&owner](MarketPtr ptr) {
+            if (auto* const impl = owner(ptr->id())) {
+                impl->markets_.insert(ptr);
+            }
         });
-        model.readMarket([& markets = markets_](MarketPtr ptr) { markets.insert(ptr); });
-        model.readOrder([this](auto ptr) {
-            auto& accnt = this->accnt(ptr->accnt());
+        model.readOrder([&owner](auto ptr) {
+            auto* const impl = owner(ptr->marketId());
+            if (!impl) {
+                return;
+            }
+            auto& accnt = impl->accnt(ptr->accnt());
             accnt.insertOrder(ptr);
             bool success{false};
             auto finally = makeFinally([&]() {
@@ -85,21 +156,36 @@ struct Serv::Impl {
                     accnt.removeOrder(*ptr);
                 }
             });
-            auto it = this->markets_.find(ptr->marketId());
-            assert(it != this->markets_.end());
+            auto it = impl->markets_.find(ptr->marketId());
+            assert(it != impl->markets_.end());
             it->insertOrder(ptr);
             success = true;
         });
-        model.readTrade([this](auto ptr) {
-            auto& accnt = this->accnt(ptr->accnt());
-            accnt.insertTrade(ptr);
+        model.readTrade([&owner](auto ptr) {
+            if (auto* const impl = owner(ptr->marketId())) {
+                auto& accnt = impl->accnt(ptr->accnt());
+                accnt.insertTrade(ptr);
+            }
         });
-        model.readPosn(busDay, [this](auto ptr) {
-            auto& accnt = this->accnt(ptr->accnt());
-            accnt.insertPosn(ptr);
+        model.readPosn(busDay, [&owner](auto ptr) {
+            if (auto* const impl = owner(ptr->marketId())) {
+                auto& accnt = impl->accnt(ptr->accnt());
+                accnt.insertPosn(ptr);
+            }
         });
+        for (auto* impl : shards) {
+            if (impl) {
+                // Market removal is not journaled, so markets removed by a previous end-of-day run
+                // are removed again here.
+                impl->removeClosedMarkets(busDay);
+            }
+        }
     }
 
+    const ServStats& stats() const noexcept { return stats_; }
+
+    const AsyncJourn& journ() const noexcept { return journ_; }
+
     const AssetSet& assets() const noexcept { return assets_; }
 
     const Instr& instr(Symbol symbol) const
@@ -180,7 +266,7 @@ struct Serv::Impl {
     }
 
     void createOrder(Accnt& accnt, Market& market, string_view ref, Side side, Lots lots,
-                     Ticks ticks, Lots minLots, Time now, Response& resp)
+                     Ticks ticks, Lots minLots, TimeInForce tif, Time now, Response& resp)
     {
         // N.B. we only check for duplicates in the refIdx; no unique constraint exists in the database,
         // and order-refs can be reused so long as only one order is live in the system at any given
@@ -197,9 +283,14 @@ struct Serv::Impl {
         if (lots == 0_lts || lots < minLots) {
             throw InvalidLotsException{errMsg() << "invalid lots '" << lots << '\''};
         }
+        // Walk the price levels before generating any execs.
+        if (tif == TimeInForce::Fok && !canFill(market, side, lots, ticks)) {
+            throw LiquidityException{errMsg() << "insufficient liquidity for '" << lots
+                                              << "' lots"};
+        }
         const auto id = market.allocId();
         auto order = Order::make(accnt.symbol(), market.id(), market.instr(), market.settlDay(), id,
-                                 ref, side, lots, ticks, minLots, now);
+                                 ref, side, lots, ticks, minLots, now, tif);
         auto exec = newExec(*order, id, now);
 
         resp.insertOrder(order);
@@ -226,16 +317,22 @@ struct Serv::Impl {
         }
 
         // Place incomplete order in market.
-        if (!order->done()) {
+        const auto resting = !order->done() && tif == TimeInForce::Gtc;
+        ExecPtr cancelExec;
+        if (resting) {
             // This may fail if level cannot be allocated.
             market.insertOrder(order);
+        } else if (!order->done()) {
+            // Unsolicited cancellation of the unfilled quantity, which is journaled with the other
+            // execs, so that the order never rests in the market.
+            cancelExec = newCancel(*order, market.allocId(), now);
+            resp.insertExec(cancelExec);
+            execs_.push_back(cancelExec);
         }
         {
-            // TODO: IOC orders would need an additional revision for the unsolicited cancellation of any
-            // unfilled quantity.
             bool success{false};
-            auto finally = makeFinally([&market, &order, &success]() {
-                if (!success && !order->done()) {
+            auto finally = makeFinally([&market, &order, resting, &success]() {
+                if (!success && resting) {
                     // Undo market insertion.
                     market.removeOrder(*order);
                 }
@@ -247,7 +344,7 @@ struct Serv::Impl {
 
         // Commit phase.
 
-        if (!order->done()) {
+        if (resting) {
             accnt.insertOrder(order);
         }
         accnt.pushExecFront(exec);
@@ -258,6 +355,134 @@ struct Serv::Impl {
             commitMatches(accnt, market, now);
             posn->addTrade(order->side(), order->execLots(), order->execCost());
         }
+        if (cancelExec) {
+            order->cancel(now);
+            accnt.pushExecFront(cancelExec);
+            stats_.addCancels(1);
+        }
+        stats_.addOrders(1);
+        stats_.addMatches(matches_.size());
+    }
+
+    void createOrders(Accnt& accnt, Market& market, ArrayView<OrderSpec> specs, Time now,
+                      Response& resp)
+    {
+        const auto busDay = busDay_(now);
+        if (market.settlDay() != 0_jd && market.settlDay() < busDay) {
+            throw MarketClosedException{errMsg() << "market for '" << market.instr() << "' on "
+                                                 << jdToIso(market.settlDay()) << " has closed"};
+        }
+        for (size_t i{0}; i < specs.size(); ++i) {
+            const auto& spec = specs[i];
+            if (!spec.ref.empty()) {
+                const auto* const first = specs.begin();
+                const auto* const last = first + i;
+                if (accnt.exists(spec.ref) || any_of(first, last, [&spec](const auto& prev) {
+                        return prev.ref == spec.ref;
+                    })) {
+                    throw RefAlreadyExistsException{errMsg() << "order '" << spec.ref
+                                                             << "' already exists"};
+                }
+            }
+            if (spec.lots == 0_lts || spec.lots < spec.minLots) {
+                throw InvalidLotsException{errMsg() << "invalid lots '" << spec.lots << '\''};
+            }
+        }
+
+        resp.setMarket(&market);
+
+        // Ensure that matches are cleared when scope exits.
+        auto finally = makeFinally([this]() {
+            this->matches_.clear();
+            this->execs_.clear();
+        });
+        PosnPtr posn;
+        size_t orders{0}, matches{0}, cancels{0};
+        const auto journal = [this, &orders, &matches, &cancels]() {
+            if (!this->execs_.empty()) {
+                this->journ_.createExec(this->execs_);
+            }
+            this->stats_.addOrders(orders);
+            this->stats_.addMatches(matches);
+            this->stats_.addCancels(cancels);
+        };
+        try {
+            for (const auto& spec : specs) {
+                const auto mark = execs_.size();
+                bool success{false};
+                auto finally = makeFinally([this, mark, &success]() {
+                    this->matches_.clear();
+                    if (!success) {
+                        // Discard the execs of the failed order.
+                        this->execs_.erase(this->execs_.begin() + mark, this->execs_.end());
+                    }
+                });
+
+                // Depth is checked against the market as updated by earlier orders in the batch. A
+                // FOK order that cannot be filled in full is killed without matching, so that the
+                // remainder of the batch is unaffected.
+                const auto killed = spec.tif == TimeInForce::Fok
+                    && !canFill(market, spec.side, spec.lots, spec.ticks);
+                const auto id = market.allocId();
+                auto order = Order::make(accnt.symbol(), market.id(), market.instr(),
+                                         market.settlDay(), id, spec.ref, spec.side, spec.lots,
+                                         spec.ticks, spec.minLots, now, spec.tif);
+                auto exec = newExec(*order, id, now);
+
+                resp.insertOrder(order);
+                resp.insertExec(exec);
+
+                execs_.push_back(exec);
+                if (!killed) {
+                    // Order fields are updated on match.
+                    matchOrders(accnt, market, *order, now, resp);
+                }
+
+                if (!matches_.empty() && !posn) {
+                    // Avoid allocating position when there are no matches.
+                    posn = accnt.posn(market.id(), market.instr(), market.settlDay());
+                    resp.setPosn(posn);
+                }
+
+                // Place incomplete order in market.
+                const auto resting = !order->done() && spec.tif == TimeInForce::Gtc;
+                ExecPtr cancelExec;
+                if (resting) {
+                    // This may fail if level cannot be allocated.
+                    market.insertOrder(order);
+                } else if (!order->done()) {
+                    // Unsolicited cancellation of the unfilled quantity.
+                    cancelExec = newCancel(*order, market.allocId(), now);
+                    resp.insertExec(cancelExec);
+                    execs_.push_back(cancelExec);
+                }
+
+                // Commit phase. The journal is written once the batch is complete.
+
+                if (resting) {
+                    accnt.insertOrder(order);
+                }
+                accnt.pushExecFront(exec);
+
+                if (!matches_.empty()) {
+                    commitMatches(accnt, market, now);
+                    posn->addTrade(order->side(), order->execLots(), order->execCost());
+                }
+                if (cancelExec) {
+                    order->cancel(now);
+                    accnt.pushExecFront(cancelExec);
+                    ++cancels;
+                }
+                ++orders;
+                matches += matches_.size();
+                success = true;
+            }
+        } catch (...) {
+            // Orders committed before the failure must still be journaled.
+            journal();
+            throw;
+        }
+        journal();
     }
 
     void reviseOrder(Accnt& accnt, Market& market, Order& order, Lots lots, Time now,
@@ -325,6 +550,7 @@ struct Serv::Impl {
             market.reviseOrder(*it, lots, now);
             accnt.pushExecFront(exec);
         }
+        stats_.addRevises(resp.execs().size());
     }
 
     void cancelOrder(Accnt& accnt, Market& market, Order& order, Time now, Response& resp)
@@ -380,16 +606,75 @@ struct Serv::Impl {
             accnt.removeOrder(*it);
             accnt.pushExecFront(exec);
         }
+        stats_.addCancels(resp.execs().size());
     }
 
     void cancelOrder(Accnt& accnt, Time now)
     {
-        // FIXME: Not implemented.
+        // Ensure that execs are cleared when scope exits.
+        auto finally = makeFinally([this]() { this->execs_.clear(); });
+        for (auto& order : accnt.orders()) {
+            if (order.done()) {
+                continue;
+            }
+            // Must succeed because order exists.
+            auto it = markets_.find(order.marketId());
+            assert(it != markets_.end());
+            auto exec = newExec(order, it->allocId(), now);
+            exec->cancel();
+            execs_.push_back(exec);
+        }
+        if (execs_.empty()) {
+            return;
+        }
+
+        journ_.createExec(execs_);
+
+        // Commit phase.
+
+        for (const auto& exec : execs_) {
+            auto it = accnt.orders().find(exec->marketId(), exec->orderId());
+            assert(it != accnt.orders().end());
+            auto mit = markets_.find(exec->marketId());
+            assert(mit != markets_.end());
+            mit->cancelOrder(*it, now);
+            accnt.removeOrder(*it);
+            accnt.pushExecFront(exec);
+        }
+        stats_.addCancels(execs_.size());
     }
 
     void cancelOrder(Market& market, Time now)
     {
-        // FIXME: Not implemented.
+        // Ensure that execs are cleared when scope exits.
+        auto finally = makeFinally([this]() { this->execs_.clear(); });
+        for (auto* side : {&market.bidSide(), &market.offerSide()}) {
+            for (const auto& order : side->orders()) {
+                auto exec = newExec(order, market.allocId(), now);
+                exec->cancel();
+                execs_.push_back(exec);
+            }
+        }
+        if (execs_.empty()) {
+            return;
+        }
+
+        journ_.createExec(execs_);
+
+        // Commit phase.
+
+        market.cancelOrders(now);
+        for (const auto& exec : execs_) {
+            // Must succeed because order exists.
+            auto ait = accnts_.find(exec->accnt());
+            assert(ait != accnts_.end());
+            auto& accnt = *ait;
+            auto it = accnt.orders().find(market.id(), exec->orderId());
+            assert(it != accnt.orders().end());
+            accnt.removeOrder(*it);
+            accnt.pushExecFront(exec);
+        }
+        stats_.addCancels(execs_.size());
     }
 
     TradePair createTrade(Accnt& accnt, Market& market, string_view ref, Side side, Lots lots,
@@ -461,14 +746,128 @@ struct Serv::Impl {
         }
     }
 
-    void expireEndOfDay(Time now)
+    bool expireEndOfDay(Time now, size_t limit)
+    {
+        const auto busDay = busDay_(now);
+        // Ensure that execs are cleared when scope exits.
+        auto finally = makeFinally([this]() { this->execs_.clear(); });
+        bool done{true};
+        for (auto& market : markets_) {
+            if (!done) {
+                break;
+            }
+            if (market.settlDay() == 0_jd || market.settlDay() >= busDay) {
+                // Market is open.
+                continue;
+            }
+            for (auto* side : {&market.bidSide(), &market.offerSide()}) {
+                for (const auto& order : side->orders()) {
+                    if (execs_.size() == limit) {
+                        done = false;
+                        break;
+                    }
+                    auto exec = newExec(order, market.allocId(), now);
+                    exec->cancel();
+                    execs_.push_back(exec);
+                }
+            }
+        }
+        if (execs_.empty()) {
+            return done;
+        }
+
+        journ_.createExec(execs_);
+
+        // Commit phase.
+
+        for (const auto& exec : execs_) {
+            // Must succeed because order exists.
+            auto ait = accnts_.find(exec->accnt());
+            assert(ait != accnts_.end());
+            auto& accnt = *ait;
+            auto it = accnt.orders().find(exec->marketId(), exec->orderId());
+            assert(it != accnt.orders().end());
+            auto mit = markets_.find(exec->marketId());
+            assert(mit != markets_.end());
+            mit->cancelOrder(*it, now);
+            accnt.removeOrder(*it);
+            accnt.pushExecFront(exec);
+        }
+        stats_.addCancels(execs_.size());
+        return done;
+    }
+
+    bool settlEndOfDay(Time now, size_t limit)
     {
-        // FIXME: Not implemented.
+        const auto busDay = busDay_(now);
+        size_t n{0};
+
+        // Roll positions for closed markets into the instrument's position with no settlement
+        // day. The roll is not journaled, because the same roll is applied when positions are
+        // loaded from the model. The accounts are visited in order, so that a run may be resumed
+        // from the cursor. Rolled positions are removed from the account, so a run that stops
+        // part-way through an account resumes at the same account.
+        auto it = accnts_.findHint(settlCursor_).first;
+        for (; it != accnts_.end(); ++it) {
+            auto& accnt = *it;
+            auto& posns = accnt.posns();
+            for (auto pit = posns.begin(); pit != posns.end();) {
+                auto& posn = *pit++;
+                if (posn.settlDay() == 0_jd || posn.settlDay() >= busDay) {
+                    // Market is open.
+                    continue;
+                }
+                if (n >= limit) {
+                    settlCursor_ = accnt.symbol();
+                    return false;
+                }
+                auto rolled = accnt.posn(posn.marketId() & Id64{~0xffff}, posn.instr(), 0_jd);
+                rolled->add(posn);
+                accnt.removePosn(posn);
+                ++n;
+            }
+        }
+        settlCursor_.clear();
+
+        removeClosedMarkets(busDay);
+        return true;
     }
 
-    void settlEndOfDay(Time now)
+    uint64_t snapshot(const char* path, Time now)
     {
-        // FIXME: Not implemented.
+        journ_.flush();
+        const auto seq = journ_.seq();
+
+        SnapWriter writer{path, seq, now};
+        for (const auto& asset : assets_) {
+            writer.write(asset);
+        }
+        for (const auto& instr : instrs_) {
+            writer.write(instr);
+        }
+        for (const auto& market : markets_) {
+            writer.write(market);
+        }
+        for (const auto& accnt : accnts_) {
+            writer.writeAccnt(accnt.symbol());
+            // Most recent first.
+            for (const auto& exec : accnt.execs()) {
+                writer.writeExec(*exec);
+            }
+            for (const auto& order : accnt.orders()) {
+                writer.write(order);
+            }
+            for (const auto& trade : accnt.trades()) {
+                writer.writeTrade(trade);
+            }
+            for (const auto& posn : accnt.posns()) {
+                writer.write(posn);
+            }
+        }
+        writer.commit();
+        SWIRLY_INFO(logMsg() << "wrote snapshot: path=" << path << ",seq=" << seq
+                             << ",records=" << writer.records());
+        return seq;
     }
 
   private:
@@ -478,7 +877,33 @@ struct Serv::Impl {
                           order.id(), order.ref(), order.state(), order.side(), order.lots(),
                           order.ticks(), order.resdLots(), order.execLots(), order.execCost(),
                           order.lastLots(), order.lastTicks(), order.minLots(), 0_id64,
-                          LiqInd::None, Symbol{}, created);
+                          LiqInd::None, Symbol{}, created, order.tif());
+    }
+
+    ExecPtr newCancel(const Order& order, Id64 id, Time created) const
+    {
+        auto exec = newExec(order, id, created);
+        exec->cancel();
+        return exec;
+    }
+
+    /**
+     * Remove markets that closed before the business day once their orders have expired.
+     */
+    void removeClosedMarkets(JDay busDay) noexcept
+    {
+        for (auto it = markets_.begin(); it != markets_.end();) {
+            auto& market = *it++;
+            if (market.settlDay() == 0_jd || market.settlDay() >= busDay) {
+                // Market is open.
+                continue;
+            }
+            if (market.bidSide().orders().begin() != market.bidSide().orders().end()
+                || market.offerSide().orders().begin() != market.offerSide().orders().end()) {
+                continue;
+            }
+            markets_.remove(market);
+        }
     }
 
     /**
@@ -656,6 +1081,7 @@ struct Serv::Impl {
 
         market.reviseOrder(order, lots, now);
         accnt.pushExecFront(exec);
+        stats_.addRevises(1);
     }
     void doCancelOrder(Accnt& accnt, Market& market, Order& order, Time now, Response& resp)
     {
@@ -673,6 +1099,7 @@ struct Serv::Impl {
         market.cancelOrder(order, now);
         accnt.removeOrder(order);
         accnt.pushExecFront(exec);
+        stats_.addCancels(1);
     }
 
     void doArchiveTrade(Accnt& accnt, const Exec& trade, Time now)
@@ -693,10 +1120,14 @@ struct Serv::Impl {
     mutable AccntSet accnts_;
     vector<Match> matches_;
     vector<ConstExecPtr> execs_;
+    // Next account to be settled by a partial end-of-day run.
+    Symbol settlCursor_;
+    ServStats stats_;
 };
 
-Serv::Serv(Journ& journ, size_t pipeCapacity, size_t maxExecs)
-    : impl_{make_unique<Impl>(journ, pipeCapacity, maxExecs)}
+Serv::Serv(Journ& journ, size_t pipeCapacity, size_t maxExecs, PipeIdle pipeIdle,
+           size_t batchSize, Micros batchLatency)
+    : impl_{make_unique<Impl>(journ, pipeCapacity, maxExecs, pipeIdle, batchSize, batchLatency)}
 {
 }
 
@@ -706,9 +1137,31 @@ Serv::Serv(Serv&&) = default;
 
 Serv& Serv::operator=(Serv&&) = default;
 
-void Serv::load(const Model& model, Time now)
+void Serv::load(const Model& model, Time now, size_t shard, size_t shards)
+{
+    vector<Impl*> impls(shards, nullptr);
+    impls[shard] = impl_.get();
+    Impl::load(model, now, impls);
+}
+
+void Serv::load(const Model& model, Time now, ArrayView<Serv*> shards)
 {
-    impl_->load(model, now);
+    vector<Impl*> impls;
+    impls.reserve(shards.size());
+    for (auto* serv : shards) {
+        impls.push_back(serv->impl_.get());
+    }
+    Impl::load(model, now, impls);
+}
+
+const ServStats& Serv::stats() const noexcept
+{
+    return impl_->stats();
+}
+
+const AsyncJourn& Serv::journ() const noexcept
+{
+    return impl_->journ();
 }
 
 const AssetSet& Serv::assets() const noexcept
@@ -752,66 +1205,85 @@ void Serv::updateMarket(const Market& market, MarketState state, Time now)
 }
 
 void Serv::createOrder(const Accnt& accnt, const Market& market, string_view ref, Side side,
-                       Lots lots, Ticks ticks, Lots minLots, Time now, Response& resp)
+                       Lots lots, Ticks ticks, Lots minLots, TimeInForce tif, Time now,
+                       Response& resp)
 {
-    impl_->createOrder(constCast(accnt), constCast(market), ref, side, lots, ticks, minLots, now,
-                       resp);
+    TraceScope ts{TraceStage::Match};
+    impl_->createOrder(constCast(accnt), constCast(market), ref, side, lots, ticks, minLots, tif,
+                       now, resp);
+}
+
+void Serv::createOrders(const Accnt& accnt, const Market& market, ArrayView<OrderSpec> specs,
+                        Time now, Response& resp)
+{
+    TraceScope ts{TraceStage::Match};
+    impl_->createOrders(constCast(accnt), constCast(market), specs, now, resp);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, const Order& order, Lots lots,
                        Time now, Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->reviseOrder(constCast(accnt), constCast(market), constCast(order), lots, now, resp);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, Id64 id, Lots lots, Time now,
                        Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->reviseOrder(constCast(accnt), constCast(market), id, lots, now, resp);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, string_view ref, Lots lots,
                        Time now, Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->reviseOrder(constCast(accnt), constCast(market), ref, lots, now, resp);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, ArrayView<Id64> ids, Lots lots,
                        Time now, Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->reviseOrder(constCast(accnt), constCast(market), ids, lots, now, resp);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, const Order& order, Time now,
                        Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(accnt), constCast(market), constCast(order), now, resp);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, Id64 id, Time now, Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(accnt), constCast(market), id, now, resp);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, string_view ref, Time now,
                        Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(accnt), constCast(market), ref, now, resp);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, ArrayView<Id64> ids, Time now,
                        Response& resp)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(accnt), constCast(market), ids, now, resp);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, Time now)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(accnt), now);
 }
 
 void Serv::cancelOrder(const Market& market, Time now)
 {
+    TraceScope ts{TraceStage::Match};
     impl_->cancelOrder(constCast(market), now);
 }
 
@@ -837,14 +1309,22 @@ void Serv::archiveTrade(const Accnt& accnt, Id64 marketId, ArrayView<Id64> ids,
     impl_->archiveTrade(constCast(accnt), marketId, ids, now);
 }
 
-void Serv::expireEndOfDay(Time now)
+bool Serv::expireEndOfDay(Time now, size_t limit)
+{
+    assert(limit > 0);
+    TraceScope ts{TraceStage::Match};
+    return impl_->expireEndOfDay(now, limit);
+}
+
+bool Serv::settlEndOfDay(Time now, size_t limit)
 {
-    impl_->expireEndOfDay(now);
+    assert(limit > 0);
+    return impl_->settlEndOfDay(now, limit);
 }
 
-void Serv::settlEndOfDay(Time now)
+uint64_t Serv::snapshot(const char* path, Time now)
 {
-    impl_->settlEndOfDay(now);
+    return impl_->snapshot(path, now);
 }
 
 } // swirly
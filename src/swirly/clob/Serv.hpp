@@ -22,10 +22,17 @@
 #include <swirly/fin/Market.hpp>
 
 #include <swirly/util/Array.hpp>
+#include <swirly/util/Atomic.hpp>
+#include <swirly/util/SpscPipe.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <atomic>
+#include <limits>
 
 namespace swirly {
 
 class Accnt;
+class AsyncJourn;
 class Journ;
 class Market;
 class Model;
@@ -33,9 +40,56 @@ class Response;
 
 using TradePair = std::pair<ConstExecPtr, ConstExecPtr>;
 
+/**
+ * Order parameters for batch order entry.
+ */
+struct OrderSpec {
+    std::string_view ref;
+    Side side;
+    Lots lots;
+    Ticks ticks;
+    Lots minLots;
+    TimeInForce tif{TimeInForce::Gtc};
+};
+
+/**
+ * Order counters maintained by the engine thread. The counters may be read from other threads.
+ */
+class SWIRLY_API ServStats {
+  public:
+    ServStats() noexcept = default;
+    ~ServStats() noexcept = default;
+
+    // Copy.
+    ServStats(const ServStats&) = delete;
+    ServStats& operator=(const ServStats&) = delete;
+
+    // Move.
+    ServStats(ServStats&&) = delete;
+    ServStats& operator=(ServStats&&) = delete;
+
+    std::uint64_t orders() const noexcept { return orders_.load(std::memory_order_relaxed); }
+    std::uint64_t revises() const noexcept { return revises_.load(std::memory_order_relaxed); }
+    std::uint64_t cancels() const noexcept { return cancels_.load(std::memory_order_relaxed); }
+    std::uint64_t matches() const noexcept { return matches_.load(std::memory_order_relaxed); }
+
+    void addOrders(std::size_t n) noexcept { singleWriterAdd(orders_, n); }
+    void addRevises(std::size_t n) noexcept { singleWriterAdd(revises_, n); }
+    void addCancels(std::size_t n) noexcept { singleWriterAdd(cancels_, n); }
+    void addMatches(std::size_t n) noexcept { singleWriterAdd(matches_, n); }
+
+  private:
+    std::atomic<std::uint64_t> orders_{0};
+    std::atomic<std::uint64_t> revises_{0};
+    std::atomic<std::uint64_t> cancels_{0};
+    std::atomic<std::uint64_t> matches_{0};
+};
+
 class SWIRLY_API Serv {
   public:
-    Serv(Journ& journ, std::size_t pipeCapacity, std::size_t maxExecs);
+    Serv(Journ& journ, std::size_t pipeCapacity, std::size_t maxExecs,
+         PipeIdle pipeIdle = PipeIdle::Park, std::size_t batchSize = 1 << 6,
+         Micros batchLatency = 1ms);
 
     ~Serv() noexcept;
 
@@ -47,7 +101,30 @@ class SWIRLY_API Serv {
     Serv(Serv&&);
     Serv& operator=(Serv&&);
 
-    void load(const Model& model, Time now);
+    /**
+     * Load reference data and accounts, together with the markets owned by the shard, and the
+     * orders, execs, trades and positions in those markets.
+     *
+     * @param model
+     *            The model.
+     * @param now
+     *            The current time.
+     * @param shard
+     *            The shard index.
+     * @param shards
+     *            The number of shards.
+     */
+    void load(const Model& model, Time now, std::size_t shard = 0, std::size_t shards = 1);
+    /**
+     * Load all shards from a single read of the model. Reference data and accounts are loaded
+     * into every shard, and each market, together with its orders, execs, trades and positions,
+     * is loaded into the shard at its index.
+     */
+    static void load(const Model& model, Time now, ArrayView<Serv*> shards);
+
+    const ServStats& stats() const noexcept;
+
+    const AsyncJourn& journ() const noexcept;
 
     const AssetSet& assets() const noexcept;
 
@@ -65,8 +142,27 @@ class SWIRLY_API Serv {
 
     void updateMarket(const Market& market, MarketState state, Time now);
 
+    /**
+     * Create an order and match it against the market. The unfilled quantity of an IOC order is
+     * cancelled without resting in the market. A FOK order that cannot be filled in full is
+     * rejected before any execs are generated.
+     */
     void createOrder(const Accnt& accnt, const Market& market, std::string_view ref, Side side,
-                     Lots lots, Ticks ticks, Lots minLots, Time now, Response& resp);
+                     Lots lots, Ticks ticks, Lots minLots, TimeInForce tif, Time now,
+                     Response& resp);
+
+    /**
+     * Create a batch of orders in the same market. The orders are matched one after another, so
+     * that later orders may match earlier ones, and the execs of all orders are journaled as a
+     * single multi-part transaction.
+     *
+     * The batch is validated before any order is matched. If an order subsequently fails, then the
+     * orders before it remain in effect and are journaled, and the exception is rethrown. A FOK
+     * order that cannot be filled in full is not a failure: it is killed with an unsolicited
+     * cancel, and the remainder of the batch proceeds.
+     */
+    void createOrders(const Accnt& accnt, const Market& market, ArrayView<OrderSpec> specs,
+                      Time now, Response& resp);
 
     void reviseOrder(const Accnt& accnt, const Market& market, const Order& order, Lots lots,
                      Time now, Response& resp);
@@ -101,6 +197,15 @@ class SWIRLY_API Serv {
      */
     void cancelOrder(const Accnt& accnt, Time now);
 
+    /**
+     * Cancels all orders in the market, for all accounts. The cancellations are journaled as a
+     * single multi-part transaction.
+     *
+     * @param market
+     *            The market.
+     * @param now
+     *            The current time.
+     */
     void cancelOrder(const Market& market, Time now);
 
     TradePair createTrade(const Accnt& accnt, const Market& market, std::string_view ref, Side side,
@@ -113,14 +218,42 @@ class SWIRLY_API Serv {
     void archiveTrade(const Accnt& accnt, Id64 marketId, ArrayView<Id64> ids, Time now);
 
     /**
-     * This method may partially fail.
+     * Expire orders in markets that closed before the current business day. The orders are
+     * cancelled in chunks of at most limit orders, and each chunk is journaled as a single
+     * transaction. This method may partially fail.
+     *
+     * @param now
+     *            The current time.
+     * @param limit
+     *            The maximum number of orders to expire.
+     *
+     * @return true if there are no more orders to expire.
+     */
+    bool expireEndOfDay(Time now, std::size_t limit = std::numeric_limits<std::size_t>::max());
+
+    /**
+     * Roll positions for markets that closed before the current business day, and remove closed
+     * markets whose orders have expired. Positions are rolled in chunks of at most limit
+     * positions, and a partial run is resumed by the next call. Neither the roll nor the removal
+     * is journaled; both are repeated when the engine is loaded from the model.
      *
      * @param now
      *            The current time.
+     * @param limit
+     *            The maximum number of positions to roll.
+     *
+     * @return true if the run is complete.
      */
-    void expireEndOfDay(Time now);
+    bool settlEndOfDay(Time now, std::size_t limit = std::numeric_limits<std::size_t>::max());
 
-    void settlEndOfDay(Time now);
+    /**
+     * Write a snapshot of engine state to path. The snapshot is tagged with the sequence number of
+     * the last journal message. This method blocks until the journal thread has caught up, so that
+     * the snapshot never runs ahead of the journal.
+     *
+     * @return the journal sequence number of the snapshot.
+     */
+    uint64_t snapshot(const char* path, Time now);
 
   private:
     struct Impl;
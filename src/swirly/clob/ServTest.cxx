@@ -46,12 +46,38 @@ class SWIRLY_API TestModel : public swirly::TestModel {
     }
 };
 
+class CountingModel : public TestModel {
+  public:
+    int markets() const noexcept { return markets_; }
+
+  protected:
+    void doReadMarket(const ModelCallback<MarketPtr>& cb) const override
+    {
+        ++markets_;
+        TestModel::doReadMarket(cb);
+    }
+
+  private:
+    mutable int markets_{0};
+};
+
 struct ServFixture {
     ServFixture() : serv{journ, 1 << 10, 1 << 4} { serv.load(TestModel{}, Now); }
     TestJourn journ;
     Serv serv;
 };
 
+struct ShardFixture {
+    ShardFixture() : first{journ, 1 << 10, 1 << 4}, second{journ, 1 << 10, 1 << 4}
+    {
+        first.load(TestModel{}, Now, 0, 2);
+        second.load(TestModel{}, Now, 1, 2);
+    }
+    TestJourn journ;
+    Serv first;
+    Serv second;
+};
+
 } // anonymous
 
 SWIRLY_FIXTURE_TEST_CASE(ServAssets, ServFixture)
@@ -104,6 +130,32 @@ SWIRLY_FIXTURE_TEST_CASE(ServMarkets, ServFixture)
     SWIRLY_CHECK(it->state() == 0x1);
 }
 
+SWIRLY_FIXTURE_TEST_CASE(ServShardMarkets, ShardFixture)
+{
+    // EURUSD has instrument id 1, so its markets are owned by the second of two shards.
+    SWIRLY_CHECK(first.markets().begin() == first.markets().end());
+    SWIRLY_CHECK(distance(first.instrs().begin(), first.instrs().end()) == 21);
+    SWIRLY_CHECK(second.markets().find(MarketId) != second.markets().end());
+}
+
+SWIRLY_TEST_CASE(ServLoadShards)
+{
+    TestJourn journ;
+    Serv first{journ, 1 << 10, 1 << 4};
+    Serv second{journ, 1 << 10, 1 << 4};
+    Serv* const shards[] = {&first, &second};
+
+    CountingModel model;
+    Serv::load(model, Now, shards);
+
+    // Markets are read once and routed to the shard that owns them.
+    SWIRLY_CHECK(model.markets() == 1);
+    SWIRLY_CHECK(first.markets().begin() == first.markets().end());
+    SWIRLY_CHECK(distance(first.instrs().begin(), first.instrs().end()) == 21);
+    SWIRLY_CHECK(distance(second.instrs().begin(), second.instrs().end()) == 21);
+    SWIRLY_CHECK(second.markets().find(MarketId) != second.markets().end());
+}
+
 SWIRLY_FIXTURE_TEST_CASE(ServMarket, ServFixture)
 {
     // Not found.
@@ -165,7 +217,8 @@ SWIRLY_FIXTURE_TEST_CASE(ServCreateOrder, ServFixture)
     auto& market = serv.market(marketId);
 
     Response resp;
-    serv.createOrder(accnt, market, ""_sv, Side::Buy, 5_lts, 12345_tks, 1_lts, Now, resp);
+    serv.createOrder(accnt, market, ""_sv, Side::Buy, 5_lts, 12345_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
 
     SWIRLY_CHECK(resp.orders().size() == 1);
     SWIRLY_CHECK(resp.execs().size() == 1);
@@ -190,3 +243,337 @@ SWIRLY_FIXTURE_TEST_CASE(ServCreateOrder, ServFixture)
     SWIRLY_CHECK(order->created() == Now);
     SWIRLY_CHECK(order->modified() == Now);
 }
+
+SWIRLY_FIXTURE_TEST_CASE(ServCreateOrders, ServFixture)
+{
+    auto& accnt = serv.accnt("MARAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    // Duplicate ref within batch.
+    {
+        const OrderSpec specs[] = {{"foo"_sv, Side::Buy, 5_lts, 12345_tks, 1_lts},
+                                   {"foo"_sv, Side::Sell, 3_lts, 12345_tks, 1_lts}};
+        Response resp;
+        SWIRLY_CHECK_THROW(serv.createOrders(accnt, market, specs, Now, resp),
+                           RefAlreadyExistsException);
+        SWIRLY_CHECK(resp.orders().empty());
+    }
+
+    // The second order matches the first.
+    const OrderSpec specs[] = {{"foo"_sv, Side::Buy, 5_lts, 12345_tks, 1_lts},
+                               {"bar"_sv, Side::Sell, 3_lts, 12345_tks, 1_lts}};
+    Response resp;
+    serv.createOrders(accnt, market, specs, Now, resp);
+
+    // The first order is also reported as the maker of the self-cross.
+    SWIRLY_CHECK(resp.orders().size() == 3);
+    SWIRLY_CHECK(resp.orders()[2] == resp.orders()[0]);
+    SWIRLY_CHECK(resp.posn() != nullptr);
+
+    ConstOrderPtr first{resp.orders()[0]};
+    SWIRLY_CHECK(first->id() == 1_id64);
+    SWIRLY_CHECK(first->ref() == "foo"_sv);
+    SWIRLY_CHECK(first->state() == State::Trade);
+    SWIRLY_CHECK(first->resdLots() == 2_lts);
+    SWIRLY_CHECK(first->execLots() == 3_lts);
+
+    ConstOrderPtr second{resp.orders()[1]};
+    SWIRLY_CHECK(second->id() == 2_id64);
+    SWIRLY_CHECK(second->ref() == "bar"_sv);
+    SWIRLY_CHECK(second->done());
+    SWIRLY_CHECK(second->execLots() == 3_lts);
+
+    SWIRLY_CHECK(serv.stats().orders() == 2U);
+    SWIRLY_CHECK(serv.stats().matches() == 1U);
+
+    // Ref already exists in account.
+    SWIRLY_CHECK_THROW(serv.createOrders(accnt, market, specs, Now, resp),
+                       RefAlreadyExistsException);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServCreateIocOrder, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 3_lts, 12345_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12345_tks, 1_lts,
+                     TimeInForce::Ioc, Now, resp);
+
+    // New, trade and unsolicited cancel of the unfilled quantity.
+    SWIRLY_CHECK(resp.execs().size() == 3);
+    SWIRLY_CHECK(resp.execs()[0]->state() == State::New);
+    SWIRLY_CHECK(resp.execs()[1]->state() == State::Trade);
+    SWIRLY_CHECK(resp.execs()[2]->state() == State::Cancel);
+    SWIRLY_CHECK(resp.execs()[2]->tif() == TimeInForce::Ioc);
+
+    ConstOrderPtr order{resp.orders()[0]};
+    SWIRLY_CHECK(order->tif() == TimeInForce::Ioc);
+    SWIRLY_CHECK(order->state() == State::Cancel);
+    SWIRLY_CHECK(order->resdLots() == 0_lts);
+    SWIRLY_CHECK(order->execLots() == 3_lts);
+
+    // The order never rested in the market.
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(market.offerSide().levels().empty());
+    SWIRLY_CHECK(marayl.orders().begin() == marayl.orders().end());
+    SWIRLY_CHECK(marayl.execs().front()->state() == State::Cancel);
+
+    SWIRLY_CHECK(serv.stats().orders() == 2U);
+    SWIRLY_CHECK(serv.stats().matches() == 1U);
+    SWIRLY_CHECK(serv.stats().cancels() == 1U);
+
+    // Nothing to match.
+    resp.clear();
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts,
+                     TimeInForce::Ioc, Now, resp);
+    SWIRLY_CHECK(resp.execs().size() == 2);
+    SWIRLY_CHECK(resp.execs()[1]->state() == State::Cancel);
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(serv.stats().cancels() == 2U);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServCreateFokOrder, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 3_lts, 12345_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 3_lts, 12346_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+
+    // Insufficient depth at any price.
+    SWIRLY_CHECK_THROW(serv.createOrder(marayl, market, ""_sv, Side::Buy, 7_lts, 12346_tks,
+                                        1_lts, TimeInForce::Fok, Now, resp),
+                       LiquidityException);
+    // Insufficient depth at the limit price.
+    SWIRLY_CHECK_THROW(serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12345_tks,
+                                        1_lts, TimeInForce::Fok, Now, resp),
+                       LiquidityException);
+    SWIRLY_CHECK(resp.execs().empty());
+    SWIRLY_CHECK(marayl.execs().empty());
+    SWIRLY_CHECK(serv.stats().orders() == 2U);
+
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12346_tks, 1_lts,
+                     TimeInForce::Fok, Now, resp);
+
+    // New and two trades.
+    SWIRLY_CHECK(resp.execs().size() == 3);
+    ConstOrderPtr order{resp.orders()[0]};
+    SWIRLY_CHECK(order->tif() == TimeInForce::Fok);
+    SWIRLY_CHECK(order->state() == State::Trade);
+    SWIRLY_CHECK(order->done());
+    SWIRLY_CHECK(order->execLots() == 5_lts);
+
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(market.offerSide().levels().begin()->lots() == 1_lts);
+    SWIRLY_CHECK(serv.stats().matches() == 2U);
+    SWIRLY_CHECK(serv.stats().cancels() == 0U);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServCreateOrdersFok, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 3_lts, 12345_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+
+    // The first order takes the available depth, so the second cannot be filled.
+    const OrderSpec specs[] = {{"foo"_sv, Side::Buy, 2_lts, 12345_tks, 1_lts},
+                               {"bar"_sv, Side::Buy, 2_lts, 12345_tks, 1_lts, TimeInForce::Fok}};
+    serv.createOrders(marayl, market, specs, Now, resp);
+
+    // New and trade for the first order; new and unsolicited cancel for the second.
+    SWIRLY_CHECK(resp.execs().size() == 4);
+    SWIRLY_CHECK(resp.execs()[0]->state() == State::New);
+    SWIRLY_CHECK(resp.execs()[1]->state() == State::Trade);
+    SWIRLY_CHECK(resp.execs()[2]->state() == State::New);
+    SWIRLY_CHECK(resp.execs()[3]->state() == State::Cancel);
+    SWIRLY_CHECK(resp.execs()[3]->tif() == TimeInForce::Fok);
+
+    ConstOrderPtr first{resp.orders()[0]};
+    SWIRLY_CHECK(first->ref() == "foo"_sv);
+    SWIRLY_CHECK(first->done());
+    SWIRLY_CHECK(first->execLots() == 2_lts);
+
+    ConstOrderPtr second{resp.orders().back()};
+    SWIRLY_CHECK(second->ref() == "bar"_sv);
+    SWIRLY_CHECK(second->state() == State::Cancel);
+    SWIRLY_CHECK(second->execLots() == 0_lts);
+
+    // The remaining depth is untouched by the killed order.
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(market.offerSide().levels().begin()->lots() == 1_lts);
+    SWIRLY_CHECK(marayl.orders().begin() == marayl.orders().end());
+    SWIRLY_CHECK(marayl.execs().front()->state() == State::Cancel);
+
+    SWIRLY_CHECK(serv.stats().orders() == 3U);
+    SWIRLY_CHECK(serv.stats().matches() == 1U);
+    SWIRLY_CHECK(serv.stats().cancels() == 1U);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServCancelAccntOrders, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& eurusd = serv.market(MarketId);
+    auto& usdjpy = serv.createMarket(serv.instr("USDJPY"_sv), SettlDay, 0x1, Now);
+
+    Response resp;
+    serv.createOrder(marayl, eurusd, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(marayl, usdjpy, ""_sv, Side::Sell, 5_lts, 12346_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(gosayl, eurusd, ""_sv, Side::Buy, 5_lts, 12343_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+
+    serv.cancelOrder(marayl, Now);
+
+    SWIRLY_CHECK(marayl.orders().begin() == marayl.orders().end());
+    SWIRLY_CHECK(distance(gosayl.orders().begin(), gosayl.orders().end()) == 1);
+    SWIRLY_CHECK(usdjpy.offerSide().levels().empty());
+    SWIRLY_CHECK(eurusd.bidSide().levels().begin()->ticks() == 12343_tks);
+    SWIRLY_CHECK(marayl.execs().front()->state() == State::Cancel);
+    SWIRLY_CHECK(serv.stats().cancels() == 2U);
+
+    // Nothing to cancel.
+    serv.cancelOrder(marayl, Now);
+    SWIRLY_CHECK(serv.stats().cancels() == 2U);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServCancelMarketOrders, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 5_lts, 12346_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+
+    serv.cancelOrder(market, Now);
+
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(market.offerSide().levels().empty());
+    SWIRLY_CHECK(marayl.orders().begin() == marayl.orders().end());
+    SWIRLY_CHECK(gosayl.orders().begin() == gosayl.orders().end());
+    SWIRLY_CHECK(marayl.execs().front()->state() == State::Cancel);
+    SWIRLY_CHECK(gosayl.execs().front()->state() == State::Cancel);
+    SWIRLY_CHECK(serv.stats().cancels() == 2U);
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServEndOfDay, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12343_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+    serv.createOrder(gosayl, market, ""_sv, Side::Sell, 3_lts, 12344_tks, 1_lts,
+                     TimeInForce::Gtc, Now, resp);
+    resp.clear();
+
+    // Market is still open.
+    SWIRLY_CHECK(serv.expireEndOfDay(Now, 1));
+    SWIRLY_CHECK(serv.settlEndOfDay(Now, 1));
+    SWIRLY_CHECK(distance(marayl.orders().begin(), marayl.orders().end()) == 2);
+
+    // Market closed before the business day.
+    const auto Later = jdToTime(SettlDay + 1_jd);
+
+    SWIRLY_CHECK(!serv.expireEndOfDay(Later, 1));
+    SWIRLY_CHECK(serv.stats().cancels() == 1U);
+    SWIRLY_CHECK(serv.expireEndOfDay(Later, 1));
+    SWIRLY_CHECK(serv.stats().cancels() == 2U);
+    SWIRLY_CHECK(marayl.orders().begin() == marayl.orders().end());
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+
+    // One position is rolled for each account.
+    SWIRLY_CHECK(!serv.settlEndOfDay(Later, 1));
+    SWIRLY_CHECK(gosayl.posns().begin()->settlDay() == 0_jd);
+    SWIRLY_CHECK(marayl.posns().begin()->settlDay() == SettlDay);
+    SWIRLY_CHECK(serv.settlEndOfDay(Later, 1));
+
+    SWIRLY_CHECK(distance(marayl.posns().begin(), marayl.posns().end()) == 1);
+    const auto& posn = *marayl.posns().begin();
+    SWIRLY_CHECK(posn.marketId() == (MarketId & Id64{~0xffff}));
+    SWIRLY_CHECK(posn.settlDay() == 0_jd);
+    SWIRLY_CHECK(posn.buyLots() == 3_lts);
+    SWIRLY_CHECK(posn.buyCost() == cost(3_lts, 12344_tks));
+
+    // Market is removed once its orders have expired.
+    SWIRLY_CHECK_THROW(serv.market(MarketId), MarketNotFoundException);
+    SWIRLY_CHECK(serv.markets().begin() == serv.markets().end());
+}
+
+SWIRLY_FIXTURE_TEST_CASE(ServSettlEndOfDay, ServFixture)
+{
+    auto& marayl = serv.accnt("MARAYL"_sv);
+    auto& gosayl = serv.accnt("GOSAYL"_sv);
+    const auto& instr = serv.instr("EURUSD"_sv);
+
+    // Two positions in each account.
+    for (const auto settlDay : {SettlDay, SettlDay + 1_jd}) {
+        const auto& market = settlDay == SettlDay ? serv.market(MarketId)
+                                                  : serv.createMarket(instr, settlDay, 0x1, Now);
+        Response resp;
+        serv.createOrder(gosayl, market, ""_sv, Side::Sell, 1_lts, 12345_tks, 1_lts,
+                         TimeInForce::Gtc, Now, resp);
+        resp.clear();
+        serv.createOrder(marayl, market, ""_sv, Side::Buy, 1_lts, 12345_tks, 1_lts,
+                         TimeInForce::Gtc, Now, resp);
+    }
+    SWIRLY_CHECK(distance(marayl.posns().begin(), marayl.posns().end()) == 2);
+
+    // Markets are still open on their settlement day.
+    SWIRLY_CHECK(serv.settlEndOfDay(jdToTime(SettlDay)));
+    SWIRLY_CHECK(distance(marayl.posns().begin(), marayl.posns().end()) == 2);
+    SWIRLY_CHECK(distance(serv.markets().begin(), serv.markets().end()) == 2);
+
+    const auto Later = jdToTime(SettlDay + 2_jd);
+    const auto dated = [](const Accnt& accnt) {
+        return count_if(accnt.posns().begin(), accnt.posns().end(),
+                        [](const auto& posn) { return posn.settlDay() != 0_jd; });
+    };
+
+    // The limit applies within an account.
+    SWIRLY_CHECK(!serv.settlEndOfDay(Later, 1));
+    SWIRLY_CHECK(dated(gosayl) == 1);
+    SWIRLY_CHECK(!serv.settlEndOfDay(Later, 1));
+    SWIRLY_CHECK(dated(gosayl) == 0);
+    SWIRLY_CHECK(dated(marayl) == 2);
+    SWIRLY_CHECK(!serv.settlEndOfDay(Later, 1));
+    SWIRLY_CHECK(dated(marayl) == 1);
+    SWIRLY_CHECK(serv.settlEndOfDay(Later, 1));
+    SWIRLY_CHECK(dated(marayl) == 0);
+
+    SWIRLY_CHECK(distance(marayl.posns().begin(), marayl.posns().end()) == 1);
+    const auto& posn = *marayl.posns().begin();
+    SWIRLY_CHECK(posn.settlDay() == 0_jd);
+    SWIRLY_CHECK(posn.buyLots() == 2_lts);
+    SWIRLY_CHECK(serv.markets().begin() == serv.markets().end());
+}
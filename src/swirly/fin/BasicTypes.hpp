@@ -197,6 +197,42 @@ inline std::ostream& operator<<(std::ostream& os, Side side)
     return os << enumString(side);
 }
 
+/**
+ * Time-in-force. The underlying type is narrow, so that it fits in the journal's message layout.
+ */
+enum class TimeInForce : std::uint8_t {
+    /**
+     * Good-till-cancel. Any unfilled quantity rests in the order-book.
+     */
+    Gtc = 1,
+    /**
+     * Immediate-or-cancel. Any unfilled quantity is cancelled without resting in the order-book.
+     */
+    Ioc,
+    /**
+     * Fill-or-kill. The order is rejected unless it can be filled in full immediately.
+     */
+    Fok
+};
+
+inline const char* enumString(TimeInForce tif) noexcept
+{
+    switch (tif) {
+    case TimeInForce::Gtc:
+        return "GTC";
+    case TimeInForce::Ioc:
+        return "IOC";
+    case TimeInForce::Fok:
+        return "FOK";
+    }
+    std::terminate();
+}
+
+inline std::ostream& operator<<(std::ostream& os, TimeInForce tif)
+{
+    return os << enumString(tif);
+}
+
 /**
  * Order states.
  * @image html OrderState.png
@@ -42,6 +42,11 @@ SWIRLY_TEST_CASE(Side)
     SWIRLY_CHECK(strcmp(enumString(Side::Buy), "BUY") == 0);
 }
 
+SWIRLY_TEST_CASE(TimeInForce)
+{
+    SWIRLY_CHECK(strcmp(enumString(TimeInForce::Ioc), "IOC") == 0);
+}
+
 SWIRLY_TEST_CASE(State)
 {
     SWIRLY_CHECK(strcmp(enumString(State::New), "NEW") == 0);
@@ -0,0 +1,309 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "BinJourn.hpp"
+
+#include <swirly/util/Conf.hpp>
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/Log.hpp>
+#include <swirly/util/Math.hpp>
+
+#include <cstdio> // snprintf()
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h> // open()
+#include <unistd.h> // fdatasync()
+
+#include <sys/stat.h> // mkdir()
+
+using namespace std;
+
+namespace swirly {
+namespace {
+
+constexpr char Magic[] = "SWIRLYJ";
+static_assert(sizeof(Magic) == sizeof(BinJournHeader::magic), "invalid magic size");
+constexpr uint32_t Version{2};
+
+string segmentPath(const string& dir, uint64_t segment)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "/%08llu.journ", static_cast<unsigned long long>(segment));
+    return dir + buf;
+}
+
+bool exists(const string& path) noexcept
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+uint64_t lastSegment(const string& dir) noexcept
+{
+    uint64_t segment{0};
+    while (exists(segmentPath(dir, segment + 1))) {
+        ++segment;
+    }
+    return segment;
+}
+
+size_t pageSize() noexcept
+{
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+void checkHeader(const BinJournHeader& header, const string& path, uint64_t segment)
+{
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+        || header.recordSize != sizeof(BinJournRecord) || header.segment != segment) {
+        throw Exception{errMsg() << "invalid journal segment: " << path};
+    }
+}
+
+} // anonymous
+
+JournSync toJournSync(string_view sv, JournSync dfl) noexcept
+{
+    if (iequals(sv, "none"_sv)) {
+        return JournSync::None;
+    }
+    if (iequals(sv, "async"_sv)) {
+        return JournSync::Async;
+    }
+    if (iequals(sv, "sync"_sv)) {
+        return JournSync::Sync;
+    }
+    if (iequals(sv, "datasync"_sv)) {
+        return JournSync::DataSync;
+    }
+    return dfl;
+}
+
+BinJourn::BinJourn(const char* dir, size_t segmentSize, JournSync sync)
+    : dir_{dir},
+      segmentSize_{ceil(max<size_t>(segmentSize, 1), pageSize()) * pageSize()},
+      sync_{sync}
+{
+    if (mkdir(dir, 0777) < 0 && errno != EEXIST) {
+        throw system_error{errno, system_category(), "mkdir failed"};
+    }
+    const auto segment = lastSegment(dir_);
+    if (segment == 0) {
+        open(1, true);
+    } else {
+        open(segment, false);
+    }
+    SWIRLY_INFO(logMsg() << "opened binary journal: dir=" << dir_ << ",segment=" << segment_
+                         << ",seq=" << seq_);
+}
+
+BinJourn::BinJourn(const Conf& conf)
+    : BinJourn{conf.get("binary_journ", "journ"),
+               conf.get<size_t>("binary_journ_segment_size", 1 << 26),
+               toJournSync(conf.get("binary_journ_sync", "async"))}
+{
+}
+
+BinJourn::~BinJourn() noexcept
+{
+    try {
+        sync();
+    } catch (const exception& e) {
+        SWIRLY_ERROR(logMsg() << "failed to sync journal: " << e.what());
+    }
+}
+
+void BinJourn::doUpdate(const Msg& msg)
+{
+    append(msg);
+    sync();
+}
+
+void BinJourn::doUpdateBatch(ArrayView<Msg> msgs)
+{
+    for (const auto& msg : msgs) {
+        append(msg);
+    }
+    // Group commit: a single sync covers the whole batch.
+    sync();
+}
+
+uint64_t BinJourn::doSeq() const noexcept
+{
+    return seq_;
+}
+
+void BinJourn::open(uint64_t segment, bool create)
+{
+    const auto path = segmentPath(dir_, segment);
+
+    File file;
+    size_t len;
+    if (create) {
+        // New segments are initialised under a temporary name, which may be left over from a
+        // previous crash.
+        file = openFile((path + ".tmp").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+        len = segmentSize_;
+        // Preallocate, so that writes through the mapping cannot fail with SIGBUS.
+        reserve(file.get(), len);
+    } else {
+        // Existing segments retain their original size.
+        file = openFile(path.c_str(), O_RDWR);
+        len = size(file.get());
+        if (len < sizeof(BinJournHeader)) {
+            throw Exception{errMsg() << "invalid journal segment: " << path};
+        }
+    }
+    auto memMap = openMemMap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, file.get(), 0);
+
+    auto* const header = static_cast<BinJournHeader*>(memMap.get().data());
+    auto* const first = reinterpret_cast<BinJournRecord*>(header);
+    if (create) {
+        memcpy(header->magic, Magic, sizeof(Magic));
+        header->version = Version;
+        header->recordSize = sizeof(BinJournRecord);
+        header->segment = segment;
+        header->firstSeq = seq_ + 1;
+        publish(file.get(), path);
+    } else {
+        checkHeader(*header, path, segment);
+        seq_ = header->firstSeq - 1;
+    }
+
+    auto* pos = first + 1;
+    auto* const end = first + len / sizeof(BinJournRecord);
+    // Find end of journal.
+    for (; pos != end && pos->seq != 0; ++pos) {
+        if (pos->seq != seq_ + 1) {
+            throw Exception{errMsg() << "invalid journal sequence: " << path};
+        }
+        seq_ = pos->seq;
+    }
+
+    file_ = move(file);
+    memMap_ = move(memMap);
+    begin_ = first + 1;
+    end_ = end;
+    pos_ = pos;
+    unsynced_ = pos;
+    segment_ = segment;
+}
+
+void BinJourn::publish(FileHandle h, const string& path)
+{
+    // The header is made durable before the segment is linked under its final name, so that a
+    // crash never leaves a segment without a valid header.
+    if (fdatasync(h.get()) < 0) {
+        throw system_error{errno, system_category(), "fdatasync failed"};
+    }
+    const auto tmp = path + ".tmp";
+    // Unlike rename(), link() fails if the segment already exists.
+    if (link(tmp.c_str(), path.c_str()) < 0) {
+        throw system_error{errno, system_category(), "link failed"};
+    }
+    unlink(tmp.c_str());
+    if (sync_ != JournSync::None) {
+        const auto dir = openFile(dir_.c_str(), O_RDONLY);
+        if (fsync(dir.get().get()) < 0) {
+            throw system_error{errno, system_category(), "fsync failed"};
+        }
+    }
+}
+
+void BinJourn::append(const Msg& msg)
+{
+    if (pos_ == end_) {
+        // Roll to next segment.
+        sync();
+        open(segment_ + 1, true);
+        SWIRLY_INFO(logMsg() << "rolled binary journal: segment=" << segment_ << ",seq=" << seq_);
+    }
+    auto& rec = *pos_;
+    rec.reserved = 0;
+    memcpy(&rec.msg, &msg, sizeof(msg));
+    // Publish the sequence number last, so that a concurrent reader never sees a partial record.
+    __atomic_store_n(&rec.seq, seq_ + 1, __ATOMIC_RELEASE);
+    ++seq_;
+    ++pos_;
+}
+
+void BinJourn::sync()
+{
+    if (unsynced_ == pos_) {
+        return;
+    }
+    switch (sync_) {
+    case JournSync::None:
+        break;
+    case JournSync::Async:
+    case JournSync::Sync: {
+        // The msync() address must be page-aligned.
+        auto* const base = static_cast<char*>(memMap_.get().data());
+        auto* from = reinterpret_cast<char*>(unsynced_);
+        from = base + (from - base) / pageSize() * pageSize();
+        auto* const to = reinterpret_cast<char*>(pos_);
+        if (msync(from, to - from, sync_ == JournSync::Async ? MS_ASYNC : MS_SYNC) < 0) {
+            throw system_error{errno, system_category(), "msync failed"};
+        }
+    } break;
+    case JournSync::DataSync:
+        if (fdatasync(file_.get().get()) < 0) {
+            throw system_error{errno, system_category(), "fdatasync failed"};
+        }
+        break;
+    }
+    unsynced_ = pos_;
+}
+
+uint64_t readBinJourn(const char* dir, uint64_t fromSeq, const BinJournCallback& cb)
+{
+    const string dirStr{dir};
+    uint64_t last{0};
+    for (uint64_t segment{1};; ++segment) {
+        const auto path = segmentPath(dirStr, segment);
+        if (!exists(path)) {
+            break;
+        }
+        const auto file = openFile(path.c_str(), O_RDONLY);
+        const auto len = size(file.get());
+        if (len < sizeof(BinJournHeader)) {
+            throw Exception{errMsg() << "invalid journal segment: " << path};
+        }
+        const auto memMap = openMemMap(nullptr, len, PROT_READ, MAP_SHARED, file.get(), 0);
+
+        const auto* const header = static_cast<const BinJournHeader*>(memMap.get().data());
+        checkHeader(*header, path, segment);
+
+        const auto* const first = reinterpret_cast<const BinJournRecord*>(header);
+        const auto* const end = first + len / sizeof(BinJournRecord);
+        for (const auto* it = first + 1; it != end; ++it) {
+            const auto seq = __atomic_load_n(&it->seq, __ATOMIC_ACQUIRE);
+            if (seq == 0) {
+                // End of journal.
+                return last;
+            }
+            if (seq >= fromSeq) {
+                cb(seq, it->msg);
+                last = seq;
+            }
+        }
+    }
+    return last;
+}
+
+} // swirly
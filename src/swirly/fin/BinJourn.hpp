@@ -0,0 +1,182 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_FIN_BINJOURN_HPP
+#define SWIRLY_FIN_BINJOURN_HPP
+
+#include <swirly/fin/Journ.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/util/MemMap.hpp>
+
+#include <functional>
+#include <string>
+
+namespace swirly {
+
+/**
+ * Durability policy applied by the binary journal at the end of each update.
+ */
+enum class JournSync {
+    /**
+     * Leave write-back to the operating system.
+     */
+    None,
+    /**
+     * Schedule write-back of dirty pages with msync(MS_ASYNC).
+     */
+    Async,
+    /**
+     * Wait for write-back of dirty pages with msync(MS_SYNC).
+     */
+    Sync,
+    /**
+     * Wait for write-back of file data with fdatasync().
+     */
+    DataSync
+};
+
+inline const char* enumString(JournSync sync) noexcept
+{
+    switch (sync) {
+    case JournSync::None:
+        return "NONE";
+    case JournSync::Async:
+        return "ASYNC";
+    case JournSync::Sync:
+        return "SYNC";
+    case JournSync::DataSync:
+        return "DATASYNC";
+    }
+    std::terminate();
+}
+
+inline std::ostream& operator<<(std::ostream& os, JournSync sync)
+{
+    return os << enumString(sync);
+}
+
+/**
+ * Parse sync policy. The comparison is case-insensitive.
+ *
+ * @return the default value if the string is not recognised.
+ */
+SWIRLY_API JournSync toJournSync(std::string_view sv, JournSync dfl = JournSync::Async) noexcept;
+
+/**
+ * Fixed-size record appended to a binary journal segment. Sequence numbers start at one and are
+ * contiguous across segments. A zero sequence number marks the end of the journal, because
+ * segments are zero-filled when allocated.
+ */
+struct BinJournRecord {
+    uint64_t seq;
+    uint64_t reserved;
+    Msg msg;
+};
+static_assert(std::is_pod<BinJournRecord>::value);
+static_assert(sizeof(BinJournRecord) == 256, "must be specific size");
+
+/**
+ * Segment header. The header occupies the first record slot, so that records remain aligned.
+ */
+struct BinJournHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t segment;
+    uint64_t firstSeq;
+    char reserved[sizeof(BinJournRecord) - 32];
+};
+static_assert(std::is_pod<BinJournHeader>::value);
+static_assert(sizeof(BinJournHeader) == sizeof(BinJournRecord), "must be specific size");
+
+/**
+ * Append-only journal of fixed-layout Msg records. Records are written to preallocated,
+ * memory-mapped segment files, which are named by segment number within the journal directory.
+ * A new segment is started when the current segment is full. Multi-part and reset semantics are
+ * not interpreted here; they are preserved in the record stream for consumers such as the import
+ * tool.
+ */
+class SWIRLY_API BinJourn : public Journ {
+  public:
+    BinJourn(const char* dir, std::size_t segmentSize, JournSync sync);
+    explicit BinJourn(const Conf& conf);
+    ~BinJourn() noexcept override;
+
+    // Copy.
+    BinJourn(const BinJourn&) = delete;
+    BinJourn& operator=(const BinJourn&) = delete;
+
+    // Move.
+    BinJourn(BinJourn&&) = delete;
+    BinJourn& operator=(BinJourn&&) = delete;
+
+    /**
+     * @return the current segment number.
+     */
+    uint64_t segment() const noexcept { return segment_; }
+
+  protected:
+    void doUpdate(const Msg& msg) override;
+
+    void doUpdateBatch(ArrayView<Msg> msgs) override;
+
+    /**
+     * @return the sequence number of the last record written.
+     */
+    uint64_t doSeq() const noexcept override;
+
+  private:
+    void open(uint64_t segment, bool create);
+    /**
+     * Link a new segment, whose header has been written under a temporary name, to its final
+     * path.
+     */
+    void publish(FileHandle h, const std::string& path);
+
+    void append(const Msg& msg);
+
+    void sync();
+
+    const std::string dir_;
+    const std::size_t segmentSize_;
+    const JournSync sync_;
+    File file_;
+    MemMap memMap_;
+    BinJournRecord* begin_{nullptr};
+    BinJournRecord* end_{nullptr};
+    BinJournRecord* pos_{nullptr};
+    // Start of records that have not yet been synced.
+    BinJournRecord* unsynced_{nullptr};
+    uint64_t segment_{0};
+    uint64_t seq_{0};
+};
+
+using BinJournCallback = std::function<void(uint64_t seq, const Msg& msg)>;
+
+/**
+ * Read binary journal records in sequence order.
+ *
+ * @param dir Journal directory.
+ * @param fromSeq Records with lower sequence numbers are skipped.
+ * @param cb Callback invoked for each record.
+ * @return the sequence number of the last record read, or zero if no records were read.
+ */
+SWIRLY_API uint64_t readBinJourn(const char* dir, uint64_t fromSeq, const BinJournCallback& cb);
+
+} // swirly
+
+#endif // SWIRLY_FIN_BINJOURN_HPP
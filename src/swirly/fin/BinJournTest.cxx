@@ -0,0 +1,135 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "BinJourn.hpp"
+
+#include <swirly/unit/TempDir.hpp>
+#include <swirly/unit/Test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h> // open()
+#include <unistd.h> // ftruncate(), sysconf()
+
+using namespace std;
+using namespace swirly;
+using swirly::test::TempDir;
+
+namespace {
+
+Msg makeMsg(int64_t id)
+{
+    Msg msg;
+    msg.type = MsgType::UpdateMarket;
+    msg.updateMarket.id = Id64{id};
+    msg.updateMarket.state = 0;
+    return msg;
+}
+
+vector<int64_t> readIds(const char* dir, uint64_t fromSeq)
+{
+    vector<int64_t> ids;
+    readBinJourn(dir, fromSeq, [&ids](uint64_t seq, const Msg& msg) {
+        ids.push_back(msg.updateMarket.id.count());
+    });
+    return ids;
+}
+
+} // anonymous
+
+SWIRLY_TEST_CASE(JournSync)
+{
+    SWIRLY_CHECK(toJournSync("none"_sv) == JournSync::None);
+    SWIRLY_CHECK(toJournSync("ASYNC"_sv) == JournSync::Async);
+    SWIRLY_CHECK(toJournSync("Sync"_sv) == JournSync::Sync);
+    SWIRLY_CHECK(toJournSync("datasync"_sv) == JournSync::DataSync);
+    SWIRLY_CHECK(toJournSync("fsync"_sv, JournSync::None) == JournSync::None);
+}
+
+SWIRLY_TEST_CASE(BinJourn)
+{
+    TempDir dir;
+    // Segment size is rounded up to one page, and the header occupies the first record slot.
+    const size_t perSegment = sysconf(_SC_PAGESIZE) / sizeof(BinJournRecord) - 1;
+    const size_t total{2 * perSegment + 1};
+    {
+        BinJourn journ{dir.path(), 1, JournSync::Sync};
+        SWIRLY_CHECK(journ.seq() == 0);
+        SWIRLY_CHECK(journ.segment() == 1);
+        for (size_t i{1}; i <= perSegment + 5; ++i) {
+            journ.update(makeMsg(i));
+        }
+        SWIRLY_CHECK(journ.seq() == perSegment + 5);
+        SWIRLY_CHECK(journ.segment() == 2);
+    }
+    {
+        // Reopen and resume at the end of the journal.
+        BinJourn journ{dir.path(), 1, JournSync::DataSync};
+        SWIRLY_CHECK(journ.seq() == perSegment + 5);
+        SWIRLY_CHECK(journ.segment() == 2);
+        vector<Msg> msgs;
+        for (size_t i{perSegment + 6}; i <= total; ++i) {
+            msgs.push_back(makeMsg(i));
+        }
+        journ.update(msgs);
+        SWIRLY_CHECK(journ.seq() == total);
+        SWIRLY_CHECK(journ.segment() == 3);
+    }
+    auto ids = readIds(dir.path(), 1);
+    SWIRLY_CHECK(ids.size() == total);
+    for (size_t i{0}; i < ids.size(); ++i) {
+        SWIRLY_CHECK(ids[i] == static_cast<int64_t>(i + 1));
+    }
+    ids = readIds(dir.path(), 17);
+    SWIRLY_CHECK(ids.size() == total - 16);
+    SWIRLY_CHECK(ids.front() == 17);
+    SWIRLY_CHECK(readIds(dir.path(), total + 1).empty());
+}
+
+SWIRLY_TEST_CASE(BinJournCrash)
+{
+    TempDir dir;
+    const size_t perSegment = sysconf(_SC_PAGESIZE) / sizeof(BinJournRecord) - 1;
+    {
+        BinJourn journ{dir.path(), 1, JournSync::Async};
+        for (size_t i{1}; i <= perSegment; ++i) {
+            journ.update(makeMsg(i));
+        }
+        SWIRLY_CHECK(journ.segment() == 1);
+    }
+    // Crash after the next segment was preallocated, but before its header was written.
+    {
+        const auto path = dir.file("00000002.journ.tmp");
+        const int fd{open(path.c_str(), O_RDWR | O_CREAT, 0666)};
+        SWIRLY_CHECK(fd >= 0);
+        SWIRLY_CHECK(ftruncate(fd, sysconf(_SC_PAGESIZE)) == 0);
+        close(fd);
+    }
+    {
+        // The partial segment is ignored, and replaced when the journal rolls.
+        BinJourn journ{dir.path(), 1, JournSync::Async};
+        SWIRLY_CHECK(journ.seq() == perSegment);
+        SWIRLY_CHECK(journ.segment() == 1);
+        journ.update(makeMsg(perSegment + 1));
+        SWIRLY_CHECK(journ.segment() == 2);
+    }
+    {
+        BinJourn journ{dir.path(), 1, JournSync::Async};
+        SWIRLY_CHECK(journ.seq() == perSegment + 1);
+    }
+    SWIRLY_CHECK(readIds(dir.path(), 1).size() == perSegment + 1);
+}
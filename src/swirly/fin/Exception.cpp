@@ -56,6 +56,8 @@ InvalidTicksException::~InvalidTicksException() noexcept = default;
 
 TooLateException::~TooLateException() noexcept = default;
 
+LiquidityException::~LiquidityException() noexcept = default;
+
 ForbiddenException::~ForbiddenException() noexcept = default;
 
 int ForbiddenException::httpStatus() const noexcept
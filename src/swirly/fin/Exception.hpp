@@ -162,6 +162,23 @@ class SWIRLY_API TooLateException : public BadRequestException {
     TooLateException& operator=(TooLateException&&) noexcept = default;
 };
 
+/**
+ * The order cannot be filled in full from the liquidity available in the market.
+ */
+class SWIRLY_API LiquidityException : public BadRequestException {
+  public:
+    explicit LiquidityException(std::string_view what) noexcept : BadRequestException{what} {}
+    ~LiquidityException() noexcept override;
+
+    // Copy.
+    LiquidityException(const LiquidityException&) noexcept = default;
+    LiquidityException& operator=(const LiquidityException&) noexcept = default;
+
+    // Move.
+    LiquidityException(LiquidityException&&) noexcept = default;
+    LiquidityException& operator=(LiquidityException&&) noexcept = default;
+};
+
 /**
  * The server understood the request, but is refusing to fulfill it. Authorization will not help and
  * the request SHOULD NOT be repeated. If the request method was not HEAD and the server wishes to
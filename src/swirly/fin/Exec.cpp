@@ -93,7 +93,7 @@ ExecPtr Exec::opposite(Id64 id) const
     assert(!cpty_.empty());
     return make(cpty_, marketId_, instr_, settlDay_, id, orderId_, +ref_, state_,
                 swirly::opposite(side_), lots_, ticks_, resdLots_, execLots_, execCost_, lastLots_,
-                lastTicks_, minLots_, matchId_, swirly::opposite(liqInd_), accnt_, created_);
+                lastTicks_, minLots_, matchId_, swirly::opposite(liqInd_), accnt_, created_, tif_);
 }
 
 void Exec::trade(Lots sumLots, Cost sumCost, Lots lastLots, Ticks lastTicks, Id64 matchId,
@@ -34,8 +34,9 @@ class SWIRLY_API Exec : public RefCounted<Exec>, public Request, public MemAlloc
     Exec(Symbol accnt, Id64 marketId, Symbol instr, JDay settlDay, Id64 id, Id64 orderId,
          std::string_view ref, State state, Side side, Lots lots, Ticks ticks, Lots resdLots,
          Lots execLots, Cost execCost, Lots lastLots, Ticks lastTicks, Lots minLots, Id64 matchId,
-         LiqInd liqInd, Symbol cpty, Time created) noexcept
+         LiqInd liqInd, Symbol cpty, Time created, TimeInForce tif = TimeInForce::Gtc) noexcept
         : Request{accnt, marketId, instr, settlDay, id, ref, side, lots, created},
+          tif_{tif},
           orderId_{orderId},
           state_{state},
           ticks_{ticks},
@@ -69,6 +70,7 @@ class SWIRLY_API Exec : public RefCounted<Exec>, public Request, public MemAlloc
 
     void toJson(std::ostream& os) const;
 
+    auto tif() const noexcept { return tif_; }
     auto orderId() const noexcept { return orderId_; }
     auto state() const noexcept { return state_; }
     auto ticks() const noexcept { return ticks_; }
@@ -107,6 +109,7 @@ class SWIRLY_API Exec : public RefCounted<Exec>, public Request, public MemAlloc
     boost::intrusive::set_member_hook<> idHook_;
 
   private:
+    const TimeInForce tif_;
     const Id64 orderId_;
     State state_;
     const Ticks ticks_;
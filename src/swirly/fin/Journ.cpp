@@ -16,10 +16,30 @@
  */
 #include "Journ.hpp"
 
+#include "Msg.hpp"
+
+#include <swirly/util/Log.hpp>
+
 using namespace std;
 
 namespace swirly {
 
 Journ::~Journ() noexcept = default;
 
+void Journ::doUpdateBatch(ArrayView<Msg> msgs)
+{
+    for (const auto& msg : msgs) {
+        try {
+            doUpdate(msg);
+        } catch (const exception& e) {
+            SWIRLY_ERROR(logMsg() << "failed to update journal: " << e.what());
+        }
+    }
+}
+
+uint64_t Journ::doSeq() const noexcept
+{
+    return 0;
+}
+
 } // swirly
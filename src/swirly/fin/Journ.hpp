@@ -17,6 +17,7 @@
 #ifndef SWIRLY_FIN_JOURN_HPP
 #define SWIRLY_FIN_JOURN_HPP
 
+#include <swirly/util/Array.hpp>
 #include <swirly/util/Defs.hpp>
 
 #include <memory>
@@ -41,8 +42,29 @@ class SWIRLY_API Journ {
 
     void update(const Msg& msg) { doUpdate(msg); }
 
+    /**
+     * Update journal with a batch of messages. Batches never end part-way through a multi-part
+     * sequence. A failure is logged against the offending message, so that the remaining messages
+     * in the batch are still journaled.
+     */
+    void update(ArrayView<Msg> msgs) { doUpdateBatch(msgs); }
+
+    /**
+     * @return the sequence number of the last message journaled, or zero if the backend does not
+     * number its messages.
+     */
+    uint64_t seq() const noexcept { return doSeq(); }
+
   protected:
     virtual void doUpdate(const Msg& msg) = 0;
+
+    /**
+     * The default implementation applies each message in turn. Backends override this to commit
+     * the batch as a single unit.
+     */
+    virtual void doUpdateBatch(ArrayView<Msg> msgs);
+
+    virtual uint64_t doSeq() const noexcept;
 };
 
 /**
@@ -49,9 +49,18 @@ void Level::subOrder(const Order& order) noexcept
     --count_;
 }
 
+LevelSet::LevelSet(size_t ladderTicks)
+{
+    if (ladderTicks > 0) {
+        // Round up to a whole number of bitmap words.
+        ladderTicks = (ladderTicks + WordBits - 1) & ~(WordBits - 1);
+        ladder_ = make_unique<Ladder>(ladderTicks);
+    }
+}
+
 LevelSet::~LevelSet() noexcept
 {
-    set_.clear_and_dispose([](Level* ptr) { delete ptr; });
+    clear();
 }
 
 LevelSet::LevelSet(LevelSet&&) = default;
@@ -60,27 +69,61 @@ LevelSet& LevelSet::operator=(LevelSet&&) = default;
 
 LevelSet::Iterator LevelSet::insert(ValuePtr value) noexcept
 {
-    Iterator it;
+    const auto key = value->key();
+    if (ladder_ && prepareLadder(key)) {
+        const auto i = index(key);
+        if (ladder_->slots[i] == nullptr) {
+            // Take ownership if inserted.
+            setSlot(i, value.release());
+        }
+        return {this, ladder_->slots[i]};
+    }
+    Set::iterator it;
     bool inserted;
     tie(it, inserted) = set_.insert(*value);
     if (inserted) {
         // Take ownership if inserted.
         value.release();
     }
-    return it;
+    return {this, &*it};
 }
 
 LevelSet::Iterator LevelSet::insertHint(ConstIterator hint, ValuePtr value) noexcept
 {
-    auto it = set_.insert(hint, *value);
+    const auto key = value->key();
+    if (ladder_ && prepareLadder(key)) {
+        const auto i = index(key);
+        assert(ladder_->slots[i] == nullptr);
+        // Take ownership.
+        setSlot(i, value.release());
+        return {this, ladder_->slots[i]};
+    }
+    // The hint is only meaningful if it refers to a position in the tree.
+    auto pos = set_.cend();
+    if (hint.level_ != nullptr && hint.level_->keyHook_.is_linked()) {
+        pos = Set::s_iterator_to(*hint.level_);
+    }
+    auto it = set_.insert(pos, *value);
     // Take ownership.
     value.release();
-    return it;
+    return {this, &*it};
 }
 
 LevelSet::Iterator LevelSet::insertOrReplace(ValuePtr value) noexcept
 {
-    Iterator it;
+    const auto key = value->key();
+    if (ladder_ && prepareLadder(key)) {
+        const auto i = index(key);
+        if (ladder_->slots[i] != nullptr) {
+            // Replace if exists.
+            ValuePtr prev{ladder_->slots[i]};
+            resetSlot(i);
+        }
+        // Take ownership.
+        setSlot(i, value.release());
+        return {this, ladder_->slots[i]};
+    }
+    Set::iterator it;
     bool inserted;
     tie(it, inserted) = set_.insert(*value);
     if (!inserted) {
@@ -91,12 +134,172 @@ LevelSet::Iterator LevelSet::insertOrReplace(ValuePtr value) noexcept
     }
     // Take ownership.
     value.release();
-    return it;
+    return {this, &*it};
+}
+
+void LevelSet::clear() noexcept
+{
+    if (ladder_) {
+        for (auto i = findSlot(0); i < ladder_->slots.size(); i = findSlot(i + 1)) {
+            delete ladder_->slots[i];
+            resetSlot(i);
+        }
+    }
+    set_.clear_and_dispose([](Level* ptr) { delete ptr; });
 }
 
 void LevelSet::remove(const Level& level) noexcept
 {
-    set_.erase_and_dispose(Set::s_iterator_to(level), [](Level* ptr) { delete ptr; });
+    if (level.keyHook_.is_linked()) {
+        set_.erase_and_dispose(Set::s_iterator_to(level), [](Level* ptr) { delete ptr; });
+        return;
+    }
+    assert(inLadder(level.key()));
+    const auto i = index(level.key());
+    assert(ladder_->slots[i] == &level);
+    resetSlot(i);
+    delete &level;
+    if (ladder_->count == 0 && !set_.empty()) {
+        // Pull deeper levels from the tree into the empty ladder.
+        reanchor(set_.begin()->key() - headroom());
+    }
+}
+
+size_t LevelSet::findSlot(size_t pos) const noexcept
+{
+    const auto n = ladder_->slots.size();
+    if (pos >= n) {
+        return n;
+    }
+    auto wi = pos / WordBits;
+    // Mask-out bits before pos in the first word.
+    auto word = ladder_->bits[wi] & (~uint64_t{0} << (pos % WordBits));
+    for (;;) {
+        if (word != 0) {
+            return wi * WordBits + __builtin_ctzll(word);
+        }
+        if (++wi == ladder_->bits.size()) {
+            break;
+        }
+        word = ladder_->bits[wi];
+    }
+    return n;
+}
+
+Level* LevelSet::first() const noexcept
+{
+    if (ladder_ && ladder_->count > 0) {
+        return ladder_->slots[findSlot(0)];
+    }
+    return !set_.empty() ? const_cast<Level*>(&*set_.begin()) : nullptr;
+}
+
+Level* LevelSet::next(const Level& level) const noexcept
+{
+    if (level.keyHook_.is_linked()) {
+        auto it = Set::s_iterator_to(level);
+        return ++it != set_.end() ? const_cast<Level*>(&*it) : nullptr;
+    }
+    // Ladder levels precede tree levels.
+    const auto i = findSlot(index(level.key()) + 1);
+    if (i < ladder_->slots.size()) {
+        return ladder_->slots[i];
+    }
+    return !set_.empty() ? const_cast<Level*>(&*set_.begin()) : nullptr;
+}
+
+Level* LevelSet::find(LevelKey key) const noexcept
+{
+    if (inLadder(key)) {
+        return ladder_->slots[index(key)];
+    }
+    auto it = set_.find(key, KeyValueCompare());
+    return it != set_.end() ? const_cast<Level*>(&*it) : nullptr;
+}
+
+pair<LevelSet::ConstIterator, bool> LevelSet::findHint(LevelKey key) const noexcept
+{
+    if (inLadder(key)) {
+        const auto* level = ladder_->slots[index(key)];
+        return {{this, level}, level != nullptr};
+    }
+    const auto comp = KeyValueCompare();
+    auto it = set_.lower_bound(key, comp);
+    if (it == set_.end()) {
+        return {end(), false};
+    }
+    return {{this, &*it}, !comp(key, *it)};
+}
+
+void LevelSet::reanchor(LevelKey anchor) noexcept
+{
+    auto& slots = ladder_->slots;
+    const auto n = static_cast<LevelKey>(slots.size());
+    const auto delta = anchor - ladder_->anchor;
+    if (delta > 0) {
+        // Anchor moves towards deeper prices. The vacated slots at the front must be empty.
+        assert(ladder_->count == 0 || findSlot(0) >= static_cast<size_t>(min(delta, n)));
+        if (delta < n) {
+            copy(slots.begin() + delta, slots.end(), slots.begin());
+            fill(slots.end() - delta, slots.end(), nullptr);
+        } else {
+            fill(slots.begin(), slots.end(), nullptr);
+        }
+    } else if (delta < 0) {
+        // Anchor moves towards better prices. Levels beyond the far end are moved to the tree.
+        const auto d = -delta;
+        for (auto i = findSlot(d < n ? n - d : 0); i < slots.size(); i = findSlot(i + 1)) {
+            set_.insert(*slots[i]);
+        }
+        if (d < n) {
+            copy_backward(slots.begin(), slots.end() - d, slots.end());
+            fill(slots.begin(), slots.begin() + d, nullptr);
+        } else {
+            fill(slots.begin(), slots.end(), nullptr);
+        }
+    }
+    ladder_->anchor = anchor;
+
+    // Rebuild bitmap from slots.
+    fill(ladder_->bits.begin(), ladder_->bits.end(), 0);
+    ladder_->count = 0;
+    for (size_t i{0}; i < slots.size(); ++i) {
+        if (slots[i] != nullptr) {
+            setSlot(i, slots[i]);
+        }
+    }
+    // Tree levels are ordered by key, so pull from the front while they fall within the ladder.
+    while (!set_.empty() && set_.begin()->key() < anchor + n) {
+        auto& level = *set_.begin();
+        assert(level.key() >= anchor);
+        set_.erase(set_.begin());
+        setSlot(index(level.key()), &level);
+    }
+}
+
+bool LevelSet::prepareLadder(LevelKey key) noexcept
+{
+    const auto n = static_cast<LevelKey>(ladder_->slots.size());
+    if (ladder_->count == 0 && set_.empty()) {
+        ladder_->anchor = key - headroom();
+        return true;
+    }
+    if (key < ladder_->anchor) {
+        // New best level above the ladder.
+        reanchor(key - headroom());
+        return true;
+    }
+    if (key < ladder_->anchor + n) {
+        return true;
+    }
+    // Beyond the far end of the ladder. Slide the ladder forward if the touch has moved away from
+    // the anchor far enough to accommodate the new level.
+    const auto anchor = first()->key() - headroom();
+    if (anchor > ladder_->anchor && key < anchor + n) {
+        reanchor(anchor);
+        return true;
+    }
+    return false;
 }
 
 } // swirly
@@ -23,6 +23,9 @@
 
 #include <boost/intrusive/set.hpp>
 
+#include <iterator>
+#include <vector>
+
 namespace swirly {
 
 using LevelKey = Ticks::ValueType;
@@ -87,6 +90,16 @@ class SWIRLY_API Level : public Comparable<Level>, public MemAlloc {
     int count_;
 };
 
+/**
+ * Ordered set of price levels.
+ *
+ * By default, levels are held in an intrusive red-black tree, which is suitable for sparse books.
+ * Alternatively, a set may be constructed with a price ladder: a contiguous array of level slots
+ * indexed by key offset from a moving anchor, together with a bitmap of occupied slots. The ladder
+ * gives constant-time insertion and removal for levels near the touch. Levels that fall beyond the
+ * far end of the ladder are held in the tree, so that iteration order is always the ladder followed
+ * by the tree.
+ */
 class SWIRLY_API LevelSet {
     struct ValueCompare {
         bool operator()(const Level& lhs, const Level& rhs) const noexcept
@@ -106,11 +119,69 @@ class SWIRLY_API LevelSet {
         = boost::intrusive::set<Level, ConstantTimeSizeOption, CompareOption, MemberHookOption>;
     using ValuePtr = std::unique_ptr<Level>;
 
+    template <typename ValueT>
+    class BasicIterator {
+        friend class LevelSet;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Level;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueT*;
+        using reference = ValueT&;
+
+        BasicIterator() noexcept = default;
+        // Conversion from mutable to const iterator.
+        template <typename RhsT>
+        BasicIterator(const BasicIterator<RhsT>& rhs) noexcept : set_{rhs.set_}, level_{rhs.level_}
+        {
+        }
+
+        reference operator*() const noexcept { return *level_; }
+        pointer operator->() const noexcept { return level_; }
+        BasicIterator& operator++() noexcept
+        {
+            level_ = set_->next(*level_);
+            return *this;
+        }
+        BasicIterator operator++(int) noexcept
+        {
+            auto prev = *this;
+            ++*this;
+            return prev;
+        }
+        template <typename RhsT>
+        bool operator==(const BasicIterator<RhsT>& rhs) const noexcept
+        {
+            return level_ == rhs.level_;
+        }
+        template <typename RhsT>
+        bool operator!=(const BasicIterator<RhsT>& rhs) const noexcept
+        {
+            return level_ != rhs.level_;
+        }
+
+      private:
+        template <typename>
+        friend class BasicIterator;
+
+        BasicIterator(const LevelSet* set, ValueT* level) noexcept : set_{set}, level_{level} {}
+
+        const LevelSet* set_{nullptr};
+        // Null when end.
+        ValueT* level_{nullptr};
+    };
+
   public:
-    using Iterator = typename Set::iterator;
-    using ConstIterator = typename Set::const_iterator;
+    using Iterator = BasicIterator<Level>;
+    using ConstIterator = BasicIterator<const Level>;
 
-    LevelSet() = default;
+    LevelSet() noexcept = default;
+    /**
+     * Construct level set with a price ladder of the specified number of ticks. A value of zero
+     * disables the ladder, so that all levels are held in the tree.
+     */
+    explicit LevelSet(std::size_t ladderTicks);
     ~LevelSet() noexcept;
 
     // Copy.
@@ -121,38 +192,39 @@ class SWIRLY_API LevelSet {
     LevelSet(LevelSet&&);
     LevelSet& operator=(LevelSet&&);
 
+    /**
+     * @return the number of slots in the price ladder, or zero if the ladder is disabled.
+     */
+    std::size_t ladderTicks() const noexcept { return ladder_ ? ladder_->slots.size() : 0; }
+    bool empty() const noexcept { return (!ladder_ || ladder_->count == 0) && set_.empty(); }
+
     // Begin.
-    ConstIterator begin() const noexcept { return set_.begin(); }
-    ConstIterator cbegin() const noexcept { return set_.cbegin(); }
-    Iterator begin() noexcept { return set_.begin(); }
+    ConstIterator begin() const noexcept { return {this, first()}; }
+    ConstIterator cbegin() const noexcept { return {this, first()}; }
+    Iterator begin() noexcept { return {this, first()}; }
 
     // End.
-    ConstIterator end() const noexcept { return set_.end(); }
-    ConstIterator cend() const noexcept { return set_.cend(); }
-    Iterator end() noexcept { return set_.end(); }
+    ConstIterator end() const noexcept { return {this, nullptr}; }
+    ConstIterator cend() const noexcept { return {this, nullptr}; }
+    Iterator end() noexcept { return {this, nullptr}; }
 
     // Find.
     ConstIterator find(Side side, Ticks ticks) const noexcept
     {
-        return set_.find(detail::composeKey(side, ticks), KeyValueCompare());
+        return {this, find(detail::composeKey(side, ticks))};
     }
     Iterator find(Side side, Ticks ticks) noexcept
     {
-        return set_.find(detail::composeKey(side, ticks), KeyValueCompare());
+        return {this, find(detail::composeKey(side, ticks))};
     }
     std::pair<ConstIterator, bool> findHint(Side side, Ticks ticks) const noexcept
     {
-        const auto key = detail::composeKey(side, ticks);
-        const auto comp = KeyValueCompare();
-        auto it = set_.lower_bound(key, comp);
-        return std::make_pair(it, it != set_.end() && !comp(key, *it));
+        return findHint(detail::composeKey(side, ticks));
     }
     std::pair<Iterator, bool> findHint(Side side, Ticks ticks) noexcept
     {
-        const auto key = detail::composeKey(side, ticks);
-        const auto comp = KeyValueCompare();
-        auto it = set_.lower_bound(key, comp);
-        return std::make_pair(it, it != set_.end() && !comp(key, *it));
+        const auto ret = findHint(detail::composeKey(side, ticks));
+        return {{this, const_cast<Level*>(ret.first.level_)}, ret.second};
     }
     Iterator insert(ValuePtr value) noexcept;
 
@@ -162,6 +234,11 @@ class SWIRLY_API LevelSet {
 
     void remove(const Level& level) noexcept;
 
+    /**
+     * Remove all levels.
+     */
+    void clear() noexcept;
+
     template <typename... ArgsT>
     Iterator emplace(ArgsT&&... args)
     {
@@ -179,6 +256,68 @@ class SWIRLY_API LevelSet {
     }
 
   private:
+    enum : std::size_t { WordBits = 64 };
+
+    struct Ladder {
+        explicit Ladder(std::size_t n) : slots(n), bits(n / WordBits) {}
+        std::vector<Level*> slots;
+        std::vector<uint64_t> bits;
+        std::size_t count{0};
+        LevelKey anchor{0};
+    };
+
+    bool inLadder(LevelKey key) const noexcept
+    {
+        return ladder_
+            && (key >= ladder_->anchor
+                && key < ladder_->anchor + static_cast<LevelKey>(ladder_->slots.size()));
+    }
+    std::size_t index(LevelKey key) const noexcept { return key - ladder_->anchor; }
+    /**
+     * Headroom above the best level when the anchor is moved.
+     */
+    LevelKey headroom() const noexcept { return ladder_->slots.size() / 4; }
+    /**
+     * @return the index of the first occupied slot at or after pos, or the number of slots if none.
+     */
+    std::size_t findSlot(std::size_t pos) const noexcept;
+
+    void setSlot(std::size_t i, Level* level) noexcept
+    {
+        ladder_->slots[i] = level;
+        ladder_->bits[i / WordBits] |= uint64_t{1} << (i % WordBits);
+        ++ladder_->count;
+    }
+    void resetSlot(std::size_t i) noexcept
+    {
+        ladder_->slots[i] = nullptr;
+        ladder_->bits[i / WordBits] &= ~(uint64_t{1} << (i % WordBits));
+        --ladder_->count;
+    }
+    Level* first() const noexcept;
+
+    Level* next(const Level& level) const noexcept;
+
+    Level* find(LevelKey key) const noexcept;
+
+    std::pair<ConstIterator, bool> findHint(LevelKey key) const noexcept;
+
+    /**
+     * Move the ladder's anchor. Levels that fall beyond the far end of the ladder are moved to the
+     * tree, and tree levels that fall within the ladder are moved to the ladder. The new anchor must
+     * not be greater than the best level.
+     */
+    void reanchor(LevelKey anchor) noexcept;
+
+    /**
+     * Prepare the ladder for a new level with the specified key.
+     *
+     * @return true if the level should be placed in the ladder.
+     */
+    bool prepareLadder(LevelKey key) noexcept;
+
+    // Null if the ladder is disabled.
+    std::unique_ptr<Ladder> ladder_;
     Set set_;
 };
 
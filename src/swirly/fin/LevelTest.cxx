@@ -20,6 +20,8 @@
 
 #include <swirly/unit/Test.hpp>
 
+#include <vector>
+
 using namespace std;
 using namespace swirly;
 
@@ -44,3 +46,71 @@ SWIRLY_TEST_CASE(LevelSet)
     SWIRLY_CHECK(&level3 != &level1);
     SWIRLY_CHECK(level3.key() == -12345);
 }
+
+SWIRLY_TEST_CASE(LevelSetLadder)
+{
+    auto makeOrder = [](Side side, Ticks ticks) {
+        return Order::make("MARAYL"_sv, 1_id64, "EURUSD"_sv, 0_jd, 1_id64, ""_sv, side, 10_lts,
+                           ticks, 0_lts, Time{});
+    };
+    auto keys = [](const LevelSet& s) {
+        vector<LevelKey> v;
+        for (const auto& level : s) {
+            v.push_back(level.key());
+        }
+        return v;
+    };
+
+    // Ladder of 64 ticks with 16 ticks headroom.
+    LevelSet s{64};
+    SWIRLY_CHECK(s.ladderTicks() == 64);
+    SWIRLY_CHECK(s.empty());
+    SWIRLY_CHECK(s.begin() == s.end());
+
+    const auto o1 = makeOrder(Side::Sell, 12345_tks);
+    const auto o2 = makeOrder(Side::Sell, 12350_tks);
+    const auto o3 = makeOrder(Side::Sell, 12340_tks);
+    const auto o4 = makeOrder(Side::Sell, 12500_tks);
+    const auto o5 = makeOrder(Side::Sell, 12200_tks);
+
+    Level& level1{*s.emplace(*o1)};
+    SWIRLY_CHECK(s.find(Side::Sell, 12345_tks) != s.end());
+    SWIRLY_CHECK(s.find(Side::Sell, 12346_tks) == s.end());
+
+    // Duplicate.
+    SWIRLY_CHECK(&*s.emplace(*o1) == &level1);
+
+    s.emplace(*o2);
+    // Better price within headroom.
+    s.emplace(*o3);
+    SWIRLY_CHECK(keys(s) == (vector<LevelKey>{12340, 12345, 12350}));
+
+    // Beyond the far end of the ladder.
+    s.emplace(*o4);
+    SWIRLY_CHECK(keys(s) == (vector<LevelKey>{12340, 12345, 12350, 12500}));
+
+    // Better price beyond the headroom moves the anchor and pushes deeper levels into the tree.
+    Level& level5{*s.emplace(*o5)};
+    SWIRLY_CHECK(keys(s) == (vector<LevelKey>{12200, 12340, 12345, 12350, 12500}));
+    SWIRLY_CHECK(&*s.find(Side::Sell, 12345_tks) == &level1);
+
+    // Removing the only ladder level pulls tree levels back into the ladder.
+    s.remove(level5);
+    SWIRLY_CHECK(keys(s) == (vector<LevelKey>{12340, 12345, 12350, 12500}));
+
+    // Replace.
+    Level& level6{*s.emplaceOrReplace(*o1)};
+    SWIRLY_CHECK(&level6 != &level1);
+    SWIRLY_CHECK(keys(s) == (vector<LevelKey>{12340, 12345, 12350, 12500}));
+
+    // Buy-side keys are negated, so that the best bid comes first.
+    const auto o7 = makeOrder(Side::Buy, 12345_tks);
+    const auto o8 = makeOrder(Side::Buy, 12340_tks);
+    const auto o9 = makeOrder(Side::Buy, 12350_tks);
+
+    LevelSet b{64};
+    b.emplace(*o7);
+    b.emplace(*o8);
+    b.emplace(*o9);
+    SWIRLY_CHECK(b.begin()->ticks() == 12350_tks);
+}
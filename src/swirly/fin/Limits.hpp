@@ -23,6 +23,10 @@
 #define SWIRLY_MAX_LEVELS 3
 #endif // SWIRLY_MAX_LEVELS
 
+#ifndef SWIRLY_LADDER_TICKS
+#define SWIRLY_LADDER_TICKS 0
+#endif // SWIRLY_LADDER_TICKS
+
 namespace swirly {
 
 /**
@@ -35,6 +39,12 @@ constexpr std::size_t MaxDisplay{64};
  */
 constexpr std::size_t MaxLevels{SWIRLY_MAX_LEVELS};
 
+/**
+ * Number of price-ladder slots per market side. Zero disables the ladder, so that price levels are
+ * held in a tree.
+ */
+constexpr std::size_t LadderTicks{SWIRLY_LADDER_TICKS};
+
 /**
  * Maximum reference characters.
  */
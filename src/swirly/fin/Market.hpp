@@ -74,12 +74,9 @@ class SWIRLY_API Market : public RefCounted<Market>, public Comparable<Market> {
     void setState(MarketState state) noexcept { state_ = state; }
     MarketSide& bidSide() noexcept { return bidSide_; }
     MarketSide& offerSide() noexcept { return offerSide_; }
-    void insertOrder(const OrderPtr& order) throw(std::bad_alloc)
-    {
-        side(order->side()).insertOrder(order);
-    }
+    void insertOrder(const OrderPtr& order) { side(order->side()).insertOrder(order); }
     void removeOrder(const Order& order) noexcept { side(order.side()).removeOrder(order); }
-    void createOrder(const OrderPtr& order, Time now) throw(std::bad_alloc)
+    void createOrder(const OrderPtr& order, Time now)
     {
         side(order->side()).createOrder(order, now);
     }
@@ -91,6 +88,14 @@ class SWIRLY_API Market : public RefCounted<Market>, public Comparable<Market> {
     {
         side(order.side()).cancelOrder(order, now);
     }
+    /**
+     * Cancel all orders on both sides of the market.
+     */
+    void cancelOrders(Time now) noexcept
+    {
+        bidSide_.cancelOrders(now);
+        offerSide_.cancelOrders(now);
+    }
     void takeOrder(Order& order, Lots lots, Time now) noexcept
     {
         side(order.side()).takeOrder(order, lots, now);
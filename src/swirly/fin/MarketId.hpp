@@ -32,6 +32,20 @@ constexpr Id64 toMarketId(Id32 instrId, IsoDate settlDate) noexcept
     return toMarketId(instrId, maybeIsoToJd(settlDate));
 }
 
+/**
+ * Markets are partitioned across engine shards by instrument, so that all settlement dates of an
+ * instrument are owned by the same shard.
+ */
+constexpr std::size_t shardOf(Id32 instrId, std::size_t shards) noexcept
+{
+    return static_cast<std::size_t>(instrId.count()) % shards;
+}
+
+constexpr std::size_t shardOf(Id64 marketId, std::size_t shards) noexcept
+{
+    return static_cast<std::size_t>(marketId.count() >> 16) % shards;
+}
+
 template <typename ValueT>
 struct MarketIdTraits {
     using Id = Id64;
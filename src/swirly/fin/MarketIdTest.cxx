@@ -25,3 +25,13 @@ SWIRLY_TEST_CASE(toMarketId)
     const auto id = toMarketId(171_id32, 2492719_jd);
     SWIRLY_CHECK(id == 0xabcdef_id64);
 }
+
+SWIRLY_TEST_CASE(ShardOf)
+{
+    SWIRLY_CHECK(shardOf(171_id32, 1) == 0);
+    SWIRLY_CHECK(shardOf(171_id32, 4) == 3);
+    // All settlement dates of an instrument are owned by the same shard.
+    SWIRLY_CHECK(shardOf(toMarketId(171_id32, 2492719_jd), 4) == 3);
+    SWIRLY_CHECK(shardOf(toMarketId(171_id32, 2492720_jd), 4) == 3);
+    SWIRLY_CHECK(shardOf(toMarketId(172_id32, 2492719_jd), 4) == 0);
+}
@@ -24,7 +24,7 @@ MarketSide::~MarketSide() noexcept = default;
 
 MarketSide::MarketSide(MarketSide&&) = default;
 
-void MarketSide::insertOrder(const OrderPtr& order) throw(bad_alloc)
+void MarketSide::insertOrder(const OrderPtr& order)
 {
     assert(order->level() == nullptr);
     assert(order->ticks() != 0_tks);
@@ -45,7 +45,18 @@ void MarketSide::insertOrder(const OrderPtr& order) throw(bad_alloc)
     }
 }
 
-LevelSet::Iterator MarketSide::insertLevel(const OrderPtr& order) throw(bad_alloc)
+void MarketSide::cancelOrders(Time now) noexcept
+{
+    for (auto& order : orders_) {
+        // No longer associated with side.
+        order.setLevel(nullptr);
+        order.cancel(now);
+    }
+    levels_.clear();
+    orders_.clear();
+}
+
+LevelSet::Iterator MarketSide::insertLevel(const OrderPtr& order)
 {
     LevelSet::Iterator it;
     bool found;
@@ -24,7 +24,11 @@ namespace swirly {
 
 class SWIRLY_API MarketSide {
   public:
-    MarketSide() = default;
+    MarketSide() : MarketSide{LadderTicks} {}
+    /**
+     * @param ladderTicks Number of price-ladder slots. Zero disables the ladder.
+     */
+    explicit MarketSide(std::size_t ladderTicks) : levels_{ladderTicks} {}
 
     ~MarketSide() noexcept;
 
@@ -46,7 +50,7 @@ class SWIRLY_API MarketSide {
      * assumes that level member is null. Assumes that order-id and reference are unique. This
      * function will only throw if a new level cannot be allocated.
      */
-    void insertOrder(const OrderPtr& order) throw(std::bad_alloc);
+    void insertOrder(const OrderPtr& order);
 
     /**
      * Remove order from side. Internal housekeeping aside, the state of the order is not affected
@@ -59,7 +63,7 @@ class SWIRLY_API MarketSide {
             removeOrder(*level, order);
         }
     }
-    void createOrder(const OrderPtr& order, Time now) throw(std::bad_alloc)
+    void createOrder(const OrderPtr& order, Time now)
     {
         order->create(now);
         insertOrder(order);
@@ -86,6 +90,10 @@ class SWIRLY_API MarketSide {
         }
         order.cancel(now);
     }
+    /**
+     * Cancel all orders. Levels are removed in bulk, rather than one order at a time.
+     */
+    void cancelOrders(Time now) noexcept;
     /**
      * Reduce residual lots by lots. If the resulting residual is zero, then the order is removed
      * from the side.
@@ -103,7 +111,7 @@ class SWIRLY_API MarketSide {
     /**
      * Insert level. This function will only throw if a new level cannot be allocated.
      */
-    LevelSet::Iterator insertLevel(const OrderPtr& order) throw(std::bad_alloc);
+    LevelSet::Iterator insertLevel(const OrderPtr& order);
 
     void removeOrder(Level& level, const Order& order) noexcept;
 
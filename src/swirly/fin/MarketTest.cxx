@@ -16,10 +16,15 @@
  */
 #include "Market.hpp"
 
+#include <swirly/fin/Order.hpp>
+
 #include <swirly/util/Date.hpp>
 
 #include <swirly/unit/Test.hpp>
 
+#include <iterator>
+
+using namespace std;
 using namespace swirly;
 
 SWIRLY_TEST_CASE(MarketToString)
@@ -63,3 +68,75 @@ SWIRLY_TEST_CASE(MarketToStringNull)
                  ",\"offerCount\":[null,null,null]"
                  "}");
 }
+
+SWIRLY_TEST_CASE(MarketCancelOrders)
+{
+    Market market{1_id64, "EURUSD"_sv, 0_jd, 0x01};
+
+    auto makeOrder = [](Id64 id, Side side, Ticks ticks) {
+        return Order::make("MARAYL"_sv, 1_id64, "EURUSD"_sv, 0_jd, id, ""_sv, side, 10_lts, ticks,
+                           0_lts, Time{});
+    };
+    // The last order is far enough from the others to be held outside of the price ladder, if the
+    // build enables one. See MarketSideCancelOrders for a side that always has a ladder.
+    const OrderPtr orders[] = {makeOrder(1_id64, Side::Buy, 12344_tks),
+                               makeOrder(2_id64, Side::Buy, 12344_tks),
+                               makeOrder(3_id64, Side::Sell, 12346_tks),
+                               makeOrder(4_id64, Side::Sell, 1234600_tks)};
+    for (const auto& order : orders) {
+        market.insertOrder(order);
+    }
+    SWIRLY_CHECK(!market.bidSide().levels().empty());
+    SWIRLY_CHECK(!market.offerSide().levels().empty());
+
+    market.cancelOrders(Time{});
+
+    SWIRLY_CHECK(market.bidSide().levels().empty());
+    SWIRLY_CHECK(market.offerSide().levels().empty());
+    SWIRLY_CHECK(market.bidSide().orders().begin() == market.bidSide().orders().end());
+    SWIRLY_CHECK(market.offerSide().orders().begin() == market.offerSide().orders().end());
+    for (const auto& order : orders) {
+        SWIRLY_CHECK(order->state() == State::Cancel);
+        SWIRLY_CHECK(order->done());
+        SWIRLY_CHECK(order->level() == nullptr);
+    }
+
+    // Levels may be reused after cancellation.
+    const auto order = makeOrder(5_id64, Side::Buy, 12345_tks);
+    market.insertOrder(order);
+    SWIRLY_CHECK(market.bidSide().levels().begin()->ticks() == 12345_tks);
+}
+
+SWIRLY_TEST_CASE(MarketSideCancelOrders)
+{
+    MarketSide side{16};
+
+    auto makeOrder = [](Id64 id, Ticks ticks) {
+        return Order::make("MARAYL"_sv, 1_id64, "EURUSD"_sv, 0_jd, id, ""_sv, Side::Buy, 10_lts,
+                           ticks, 0_lts, Time{});
+    };
+    // The last order is far enough from the others to be held outside of the price ladder.
+    const OrderPtr orders[] = {makeOrder(1_id64, 12344_tks), makeOrder(2_id64, 12344_tks),
+                               makeOrder(3_id64, 12343_tks), makeOrder(4_id64, 1234_tks)};
+    for (const auto& order : orders) {
+        side.insertOrder(order);
+    }
+    SWIRLY_CHECK(distance(side.levels().begin(), side.levels().end()) == 3);
+
+    side.cancelOrders(Time{});
+
+    SWIRLY_CHECK(side.levels().empty());
+    SWIRLY_CHECK(side.orders().begin() == side.orders().end());
+    for (const auto& order : orders) {
+        SWIRLY_CHECK(order->state() == State::Cancel);
+        SWIRLY_CHECK(order->level() == nullptr);
+    }
+
+    // Ladder slots and tree levels may be reused after cancellation.
+    const OrderPtr reused[] = {makeOrder(5_id64, 12344_tks), makeOrder(6_id64, 1234_tks)};
+    for (const auto& order : reused) {
+        side.insertOrder(order);
+    }
+    SWIRLY_CHECK(distance(side.levels().begin(), side.levels().end()) == 2);
+    SWIRLY_CHECK(side.levels().begin()->ticks() == 12344_tks);
+}
@@ -22,4 +22,13 @@ namespace swirly {
 
 Model::~Model() noexcept = default;
 
+void Model::doReadAllExec(Time now, size_t limit, const ModelCallback<ExecPtr>& cb) const
+{
+    readAccnt(now, [this, limit, &cb](auto symbol) { this->readExec(symbol, limit, cb); });
+}
+
+void Model::doPrefetch(Time now, size_t limit) const
+{
+}
+
 } // swirly
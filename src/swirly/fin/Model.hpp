@@ -54,8 +54,22 @@ class SWIRLY_API Model {
     {
         doReadExec(accnt, limit, cb);
     }
+    /**
+     * Read the most recent Execs for each of the accounts returned by readAccnt. Execs are grouped
+     * by account, most recent first.
+     */
+    void readAllExec(Time now, std::size_t limit, const ModelCallback<ExecPtr>& cb) const
+    {
+        doReadAllExec(now, limit, cb);
+    }
     void readTrade(const ModelCallback<ExecPtr>& cb) const { doReadTrade(cb); }
     void readPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const { doReadPosn(busDay, cb); }
+    /**
+     * Hint that the accounts, orders, trades and positions, and the Exec history for time now, are
+     * about to be read. The backend may fetch them concurrently. Callbacks are still invoked on the
+     * calling thread.
+     */
+    void prefetch(Time now, std::size_t limit) const { doPrefetch(now, limit); }
 
   protected:
     virtual void doReadAsset(const ModelCallback<AssetPtr>& cb) const = 0;
@@ -71,9 +85,19 @@ class SWIRLY_API Model {
     virtual void doReadExec(std::string_view accnt, std::size_t limit,
                             const ModelCallback<ExecPtr>& cb) const = 0;
 
+    /**
+     * The default implementation calls readExec for each account.
+     */
+    virtual void doReadAllExec(Time now, std::size_t limit, const ModelCallback<ExecPtr>& cb) const;
+
     virtual void doReadTrade(const ModelCallback<ExecPtr>& cb) const = 0;
 
     virtual void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const = 0;
+
+    /**
+     * The default implementation does nothing.
+     */
+    virtual void doPrefetch(Time now, std::size_t limit) const;
 };
 
 /**
@@ -21,7 +21,7 @@
 
 #include <swirly/util/BasicTypes.hpp>
 #include <swirly/util/Date.hpp>
-#include <swirly/util/Pipe.hpp>
+#include <swirly/util/SpscPipe.hpp>
 #include <swirly/util/Symbol.hpp>
 
 namespace swirly {
@@ -62,10 +62,12 @@ struct SWIRLY_PACKED CreateExecBody {
     Lots minLots;
     Id64 matchId;
     LiqInd liqInd;
+    TimeInForce tif;
     char cpty[MaxSymbol];
     // std::chrono::time_point is not pod.
     int64_t created;
     More more;
+    char reserved[2];
 };
 static_assert(std::is_pod<CreateExecBody>::value);
 
@@ -92,7 +94,23 @@ struct SWIRLY_PACKED Msg {
 static_assert(std::is_pod<Msg>::value);
 static_assert(sizeof(Msg) == 240, "must be specific size");
 
-using MsgPipe = Pipe<Msg>;
+/**
+ * @return More::Yes if the message is followed by further parts of the same sequence.
+ */
+inline More moreOf(const Msg& msg) noexcept
+{
+    switch (msg.type) {
+    case MsgType::CreateExec:
+        return msg.createExec.more;
+    case MsgType::ArchiveTrade:
+        return msg.archiveTrade.more;
+    default:
+        break;
+    }
+    return More::No;
+}
+
+using MsgPipe = SpscPipe<Msg>;
 
 } // swirly
 
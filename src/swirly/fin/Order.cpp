@@ -117,7 +117,7 @@ OrderRefSet::Iterator OrderRefSet::insertOrReplace(const ValuePtr& value) noexce
 
 OrderList::~OrderList() noexcept
 {
-    list_.clear_and_dispose([](const Order* ptr) { ptr->release(); });
+    clear();
 }
 
 OrderList::OrderList(OrderList&&) = default;
@@ -140,6 +140,11 @@ OrderList::Iterator OrderList::insertBefore(const OrderPtr& value, const Order&
     return it;
 }
 
+void OrderList::clear() noexcept
+{
+    list_.clear_and_dispose([](const Order* ptr) { ptr->release(); });
+}
+
 OrderList::ValuePtr OrderList::remove(const Order& ref) noexcept
 {
     ValuePtr value;
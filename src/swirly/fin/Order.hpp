@@ -36,8 +36,9 @@ class SWIRLY_API Order : public RefCounted<Order>, public Request, public MemAll
     Order(Symbol accnt, Id64 marketId, Symbol instr, JDay settlDay, Id64 id, std::string_view ref,
           State state, Side side, Lots lots, Ticks ticks, Lots resdLots, Lots execLots,
           Cost execCost, Lots lastLots, Ticks lastTicks, Lots minLots, Time created,
-          Time modified) noexcept
+          Time modified, TimeInForce tif = TimeInForce::Gtc) noexcept
         : Request{accnt, marketId, instr, settlDay, id, ref, side, lots, created},
+          tif_{tif},
           state_{state},
           ticks_{ticks},
           resdLots_{resdLots},
@@ -50,9 +51,11 @@ class SWIRLY_API Order : public RefCounted<Order>, public Request, public MemAll
     {
     }
     Order(Symbol accnt, Id64 marketId, Symbol instr, JDay settlDay, Id64 id, std::string_view ref,
-          Side side, Lots lots, Ticks ticks, Lots minLots, Time created) noexcept
+          Side side, Lots lots, Ticks ticks, Lots minLots, Time created,
+          TimeInForce tif = TimeInForce::Gtc) noexcept
         : Order{accnt, marketId, instr, settlDay, id,    ref,   State::New, side,    lots,
-                ticks, lots,     0_lts, 0_cst,    0_lts, 0_tks, minLots,    created, created}
+                ticks, lots,     0_lts, 0_cst,    0_lts, 0_tks, minLots,    created, created,
+                tif}
     {
     }
     ~Order() noexcept;
@@ -74,6 +77,7 @@ class SWIRLY_API Order : public RefCounted<Order>, public Request, public MemAll
     void toJson(std::ostream& os) const;
 
     auto* level() const noexcept { return level_; }
+    auto tif() const noexcept { return tif_; }
     auto state() const noexcept { return state_; }
     auto ticks() const noexcept { return ticks_; }
     auto resdLots() const noexcept { return resdLots_; }
@@ -137,6 +141,7 @@ class SWIRLY_API Order : public RefCounted<Order>, public Request, public MemAll
     // Internals.
     mutable Level* level_{nullptr};
 
+    const TimeInForce tif_;
     State state_;
     const Ticks ticks_;
     /**
@@ -309,6 +314,8 @@ class SWIRLY_API OrderList {
 
     ValuePtr remove(const Order& ref) noexcept;
 
+    void clear() noexcept;
+
   private:
     List list_;
 };
@@ -0,0 +1,742 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Snap.hpp"
+
+#include <swirly/fin/Asset.hpp>
+#include <swirly/fin/BinJourn.hpp>
+#include <swirly/fin/Exec.hpp>
+#include <swirly/fin/Instr.hpp>
+#include <swirly/fin/Market.hpp>
+#include <swirly/fin/MsgHandler.hpp>
+#include <swirly/fin/Order.hpp>
+#include <swirly/fin/Posn.hpp>
+
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/Log.hpp>
+#include <swirly/util/MemMap.hpp>
+
+#include <cstring>
+#include <deque>
+#include <map>
+#include <system_error>
+
+#include <fcntl.h> // open()
+#include <unistd.h> // fsync()
+
+using namespace std;
+
+namespace swirly {
+namespace {
+
+constexpr char Magic[] = "SWIRLYS";
+static_assert(sizeof(Magic) == sizeof(SnapHeader::magic), "invalid magic size");
+constexpr uint32_t Version{2};
+constexpr size_t BufSize{1 << 8};
+
+void writeAll(int fd, const void* data, size_t len)
+{
+    const auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        const auto ret = ::write(fd, p, len);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error{errno, system_category(), "write failed"};
+        }
+        p += ret;
+        len -= ret;
+    }
+}
+
+void syncDir(const string& path)
+{
+    const auto pos = path.find_last_of('/');
+    const string dir{pos == string::npos ? "." : pos == 0 ? "/" : path.substr(0, pos)};
+    const auto file = openFile(dir.c_str(), O_RDONLY);
+    if (fsync(file.get().get()) < 0) {
+        throw system_error{errno, system_category(), "fsync failed"};
+    }
+}
+
+template <size_t SizeN>
+inline Symbol toSymbol(const char (&val)[SizeN]) noexcept
+{
+    return toStringView(val);
+}
+
+inline Time toTime(int64_t ms) noexcept
+{
+    return swirly::toTime(Millis{ms});
+}
+
+void setBody(SnapAssetBody& body, const Asset& asset) noexcept
+{
+    body.id = asset.id();
+    setCString(body.symbol, asset.symbol());
+    setCString(body.display, asset.display());
+    body.type = asset.type();
+}
+
+void setBody(SnapInstrBody& body, const Instr& instr) noexcept
+{
+    body.id = instr.id();
+    setCString(body.symbol, instr.symbol());
+    setCString(body.display, instr.display());
+    setCString(body.baseAsset, instr.baseAsset());
+    setCString(body.termCcy, instr.termCcy());
+    body.lotNumer = instr.lotNumer();
+    body.lotDenom = instr.lotDenom();
+    body.tickNumer = instr.tickNumer();
+    body.tickDenom = instr.tickDenom();
+    body.pipDp = instr.pipDp();
+    body.minLots = instr.minLots();
+    body.maxLots = instr.maxLots();
+}
+
+void setBody(SnapMarketBody& body, const Market& market) noexcept
+{
+    body.id = market.id();
+    setCString(body.instr, market.instr());
+    body.settlDay = market.settlDay();
+    body.state = market.state();
+    body.lastLots = market.lastLots();
+    body.lastTicks = market.lastTicks();
+    body.lastTime = msSinceEpoch(market.lastTime());
+    body.maxId = market.maxId();
+}
+
+void setBody(SnapOrderBody& body, const Order& order) noexcept
+{
+    setCString(body.accnt, order.accnt());
+    body.marketId = order.marketId();
+    setCString(body.instr, order.instr());
+    body.settlDay = order.settlDay();
+    body.id = order.id();
+    setCString(body.ref, order.ref());
+    body.state = order.state();
+    body.side = order.side();
+    body.lots = order.lots();
+    body.ticks = order.ticks();
+    body.resdLots = order.resdLots();
+    body.execLots = order.execLots();
+    body.execCost = order.execCost();
+    body.lastLots = order.lastLots();
+    body.lastTicks = order.lastTicks();
+    body.minLots = order.minLots();
+    body.tif = order.tif();
+    body.created = msSinceEpoch(order.created());
+    body.modified = msSinceEpoch(order.modified());
+}
+
+void setBody(CreateExecBody& body, const Exec& exec) noexcept
+{
+    setCString(body.accnt, exec.accnt());
+    body.marketId = exec.marketId();
+    setCString(body.instr, exec.instr());
+    body.settlDay = exec.settlDay();
+    body.id = exec.id();
+    body.orderId = exec.orderId();
+    setCString(body.ref, exec.ref());
+    body.state = exec.state();
+    body.side = exec.side();
+    body.lots = exec.lots();
+    body.ticks = exec.ticks();
+    body.resdLots = exec.resdLots();
+    body.execLots = exec.execLots();
+    body.execCost = exec.execCost();
+    body.lastLots = exec.lastLots();
+    body.lastTicks = exec.lastTicks();
+    body.minLots = exec.minLots();
+    body.matchId = exec.matchId();
+    body.liqInd = exec.liqInd();
+    body.tif = exec.tif();
+    setCString(body.cpty, exec.cpty());
+    body.created = msSinceEpoch(exec.created());
+    body.more = More::No;
+}
+
+void setBody(SnapPosnBody& body, const Posn& posn) noexcept
+{
+    setCString(body.accnt, posn.accnt());
+    body.marketId = posn.marketId();
+    setCString(body.instr, posn.instr());
+    body.settlDay = posn.settlDay();
+    body.buyLots = posn.buyLots();
+    body.buyCost = posn.buyCost();
+    body.sellLots = posn.sellLots();
+    body.sellCost = posn.sellCost();
+}
+
+AssetPtr makeAsset(const SnapAssetBody& body)
+{
+    return Asset::make(body.id, toSymbol(body.symbol), toStringView(body.display), body.type);
+}
+
+InstrPtr makeInstr(const SnapInstrBody& body)
+{
+    return Instr::make(body.id, toSymbol(body.symbol), toStringView(body.display),
+                       toSymbol(body.baseAsset), toSymbol(body.termCcy), body.lotNumer,
+                       body.lotDenom, body.tickNumer, body.tickDenom, body.pipDp, body.minLots,
+                       body.maxLots);
+}
+
+MarketPtr makeMarket(const SnapMarketBody& body)
+{
+    return Market::make(body.id, toSymbol(body.instr), body.settlDay, body.state, body.lastLots,
+                        body.lastTicks, toTime(body.lastTime), body.maxId);
+}
+
+} // anonymous
+
+OrderPtr makeOrder(const SnapOrderBody& body)
+{
+    return Order::make(toSymbol(body.accnt), body.marketId, toSymbol(body.instr), body.settlDay,
+                       body.id, toStringView(body.ref), body.state, body.side, body.lots,
+                       body.ticks, body.resdLots, body.execLots, body.execCost, body.lastLots,
+                       body.lastTicks, body.minLots, toTime(body.created), toTime(body.modified),
+                       body.tif);
+}
+
+ExecPtr makeExec(const CreateExecBody& body)
+{
+    return Exec::make(toSymbol(body.accnt), body.marketId, toSymbol(body.instr), body.settlDay,
+                      body.id, body.orderId, toStringView(body.ref), body.state, body.side,
+                      body.lots, body.ticks, body.resdLots, body.execLots, body.execCost,
+                      body.lastLots, body.lastTicks, body.minLots, body.matchId, body.liqInd,
+                      toSymbol(body.cpty), toTime(body.created), body.tif);
+}
+
+SnapWriter::SnapWriter(const char* path, uint64_t seq, Time now)
+    : path_{path},
+      tmpPath_{path_ + ".tmp"},
+      file_{openFile(tmpPath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)}
+{
+    buf_.reserve(BufSize);
+    memset(&header_, 0, sizeof(header_));
+    memcpy(header_.magic, Magic, sizeof(Magic));
+    header_.version = Version;
+    header_.recordSize = sizeof(SnapRecord);
+    header_.seq = seq;
+    header_.created = msSinceEpoch(now);
+    // The record count is zero until commit.
+    writeAll(file_.get().get(), &header_, sizeof(header_));
+}
+
+SnapWriter::~SnapWriter() noexcept
+{
+    if (!committed_) {
+        file_.reset();
+        unlink(tmpPath_.c_str());
+    }
+}
+
+void SnapWriter::write(const Asset& asset)
+{
+    auto& rec = next();
+    rec.type = SnapType::Asset;
+    setBody(rec.asset, asset);
+}
+
+void SnapWriter::write(const Instr& instr)
+{
+    auto& rec = next();
+    rec.type = SnapType::Instr;
+    setBody(rec.instr, instr);
+}
+
+void SnapWriter::write(const Market& market)
+{
+    auto& rec = next();
+    rec.type = SnapType::Market;
+    setBody(rec.market, market);
+}
+
+void SnapWriter::writeAccnt(Symbol symbol)
+{
+    auto& rec = next();
+    rec.type = SnapType::Accnt;
+    setCString(rec.accnt.symbol, symbol);
+}
+
+void SnapWriter::write(const Order& order)
+{
+    auto& rec = next();
+    rec.type = SnapType::Order;
+    setBody(rec.order, order);
+}
+
+void SnapWriter::writeExec(const Exec& exec)
+{
+    auto& rec = next();
+    rec.type = SnapType::Exec;
+    setBody(rec.exec, exec);
+}
+
+void SnapWriter::writeTrade(const Exec& trade)
+{
+    auto& rec = next();
+    rec.type = SnapType::Trade;
+    setBody(rec.exec, trade);
+}
+
+void SnapWriter::write(const Posn& posn)
+{
+    auto& rec = next();
+    rec.type = SnapType::Posn;
+    setBody(rec.posn, posn);
+}
+
+void SnapWriter::commit()
+{
+    flush();
+    const auto fd = file_.get().get();
+    header_.records = records_;
+    if (pwrite(fd, &header_, sizeof(header_), 0) != sizeof(header_)) {
+        throw system_error{errno, system_category(), "pwrite failed"};
+    }
+    if (fsync(fd) < 0) {
+        throw system_error{errno, system_category(), "fsync failed"};
+    }
+    file_.reset();
+    if (rename(tmpPath_.c_str(), path_.c_str()) < 0) {
+        throw system_error{errno, system_category(), "rename failed"};
+    }
+    committed_ = true;
+    // Make the rename durable.
+    syncDir(path_);
+}
+
+SnapRecord& SnapWriter::next()
+{
+    if (buf_.size() == BufSize) {
+        flush();
+    }
+    buf_.emplace_back();
+    auto& rec = buf_.back();
+    memset(&rec, 0, sizeof(rec));
+    ++records_;
+    return rec;
+}
+
+void SnapWriter::flush()
+{
+    if (!buf_.empty()) {
+        writeAll(file_.get().get(), buf_.data(), buf_.size() * sizeof(SnapRecord));
+        buf_.clear();
+    }
+}
+
+struct SnapModel::Impl : BasicMsgHandler<Impl> {
+
+    using Key = pair<Id64, Id64>;
+    using PosnKey = pair<Symbol, Id64>;
+
+    explicit Impl(size_t maxExecs) noexcept : maxExecs{maxExecs} {}
+
+    void clear() noexcept
+    {
+        seq = 0;
+        assets.clear();
+        instrs.clear();
+        markets.clear();
+        accnts.clear();
+        orders.clear();
+        trades.clear();
+        posns.clear();
+    }
+
+    void insert(const SnapMarketBody& body) { markets[body.id] = body; }
+
+    void insert(const SnapOrderBody& body) { orders[Key{body.marketId, body.id}] = body; }
+
+    void pushExecBack(const CreateExecBody& body)
+    {
+        auto& execs = accnts[toSymbol(body.accnt)];
+        if (execs.size() < maxExecs) {
+            execs.push_back(body);
+        }
+    }
+
+    void pushExecFront(const CreateExecBody& body)
+    {
+        auto& execs = accnts[toSymbol(body.accnt)];
+        execs.push_front(body);
+        if (execs.size() > maxExecs) {
+            execs.pop_back();
+        }
+    }
+
+    void insertTrade(const CreateExecBody& body) { trades[Key{body.marketId, body.id}] = body; }
+
+    void insert(const SnapPosnBody& body)
+    {
+        posns[PosnKey{toSymbol(body.accnt), body.marketId}] = body;
+    }
+
+    void onReset() noexcept {}
+
+    void onCreateMarket(const CreateMarketBody& body)
+    {
+        SnapMarketBody market;
+        memset(&market, 0, sizeof(market));
+        market.id = body.id;
+        memcpy(market.instr, body.instr, sizeof(market.instr));
+        market.settlDay = body.settlDay;
+        market.state = body.state;
+        insert(market);
+    }
+
+    void onUpdateMarket(const UpdateMarketBody& body)
+    {
+        auto it = markets.find(body.id);
+        if (it != markets.end()) {
+            it->second.state = body.state;
+        }
+    }
+
+    void onCreateExec(const CreateExecBody& body)
+    {
+        if (body.orderId != 0_id64) {
+            if (body.state == State::New) {
+                SnapOrderBody order{};
+                memcpy(order.accnt, body.accnt, sizeof(order.accnt));
+                order.marketId = body.marketId;
+                memcpy(order.instr, body.instr, sizeof(order.instr));
+                order.settlDay = body.settlDay;
+                order.id = body.orderId;
+                memcpy(order.ref, body.ref, sizeof(order.ref));
+                order.state = body.state;
+                order.side = body.side;
+                order.lots = body.lots;
+                order.ticks = body.ticks;
+                order.resdLots = body.resdLots;
+                order.execLots = body.execLots;
+                order.execCost = body.execCost;
+                order.lastLots = body.lastLots;
+                order.lastTicks = body.lastTicks;
+                order.minLots = body.minLots;
+                order.tif = body.tif;
+                order.created = body.created;
+                order.modified = body.created;
+                insert(order);
+            } else {
+                auto it = orders.find(Key{body.marketId, body.orderId});
+                if (it != orders.end()) {
+                    auto& order = it->second;
+                    order.state = body.state;
+                    order.lots = body.lots;
+                    order.resdLots = body.resdLots;
+                    order.execLots = body.execLots;
+                    order.execCost = body.execCost;
+                    order.lastLots = body.lastLots;
+                    order.lastTicks = body.lastTicks;
+                    order.modified = body.created;
+                }
+            }
+        }
+        auto it = markets.find(body.marketId);
+        if (it != markets.end()) {
+            auto& market = it->second;
+            if (body.state == State::Trade) {
+                market.lastLots = body.lastLots;
+                market.lastTicks = body.lastTicks;
+                market.lastTime = body.created;
+            }
+            market.maxId = max(market.maxId, body.id);
+        }
+        if (body.state == State::Trade) {
+            insertTrade(body);
+            auto& posn = posns[PosnKey{toSymbol(body.accnt), body.marketId}];
+            if (posn.accnt[0] == '\0') {
+                memcpy(posn.accnt, body.accnt, sizeof(posn.accnt));
+                posn.marketId = body.marketId;
+                memcpy(posn.instr, body.instr, sizeof(posn.instr));
+                posn.settlDay = body.settlDay;
+            }
+            const auto cost = swirly::cost(body.lastLots, body.lastTicks);
+            if (body.side == Side::Buy) {
+                posn.buyLots += body.lastLots;
+                posn.buyCost += cost;
+            } else {
+                posn.sellLots += body.lastLots;
+                posn.sellCost += cost;
+            }
+        }
+        pushExecFront(body);
+    }
+
+    void onArchiveTrade(const ArchiveTradeBody& body)
+    {
+        for (const auto id : body.ids) {
+            if (id == 0_id64) {
+                break;
+            }
+            trades.erase(Key{body.marketId, id});
+        }
+    }
+
+    const size_t maxExecs;
+    uint64_t seq{0};
+    vector<SnapAssetBody> assets;
+    vector<SnapInstrBody> instrs;
+    map<Id64, SnapMarketBody> markets;
+    // Exec history for each account, most recent first.
+    map<Symbol, deque<CreateExecBody>> accnts;
+    map<Key, SnapOrderBody> orders;
+    map<Key, CreateExecBody> trades;
+    map<PosnKey, SnapPosnBody> posns;
+};
+
+SnapModel::SnapModel(size_t maxExecs) : impl_{make_unique<Impl>(maxExecs)}
+{
+}
+
+SnapModel::~SnapModel() noexcept = default;
+
+SnapModel::SnapModel(SnapModel&&) = default;
+
+SnapModel& SnapModel::operator=(SnapModel&&) = default;
+
+uint64_t SnapModel::seq() const noexcept
+{
+    return impl_->seq;
+}
+
+bool SnapModel::loadSnap(const char* path)
+{
+    const auto fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+        throw system_error{errno, system_category(), "open failed"};
+    }
+    const File file{fd};
+    const auto len = size(file.get());
+    if (len < sizeof(SnapHeader)) {
+        throw Exception{errMsg() << "invalid snapshot: " << path};
+    }
+    const auto memMap = openMemMap(nullptr, len, PROT_READ, MAP_SHARED, file.get(), 0);
+
+    const auto* const header = static_cast<const SnapHeader*>(memMap.get().data());
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version
+        || header->recordSize != sizeof(SnapRecord)
+        || len != sizeof(SnapHeader) + header->records * sizeof(SnapRecord)) {
+        throw Exception{errMsg() << "invalid snapshot: " << path};
+    }
+
+    auto& impl = *impl_;
+    impl.clear();
+    const auto* const first = reinterpret_cast<const SnapRecord*>(header + 1);
+    const auto* const last = first + header->records;
+    for (const auto* it = first; it != last; ++it) {
+        switch (it->type) {
+        case SnapType::Asset:
+            impl.assets.push_back(it->asset);
+            break;
+        case SnapType::Instr:
+            impl.instrs.push_back(it->instr);
+            break;
+        case SnapType::Market:
+            impl.insert(it->market);
+            break;
+        case SnapType::Accnt:
+            impl.accnts[toSymbol(it->accnt.symbol)];
+            break;
+        case SnapType::Order:
+            impl.insert(it->order);
+            break;
+        case SnapType::Exec:
+            impl.pushExecBack(it->exec);
+            break;
+        case SnapType::Trade:
+            impl.insertTrade(it->exec);
+            break;
+        case SnapType::Posn:
+            impl.insert(it->posn);
+            break;
+        default:
+            throw Exception{errMsg() << "invalid snapshot record: " << path};
+        }
+    }
+    impl.seq = header->seq;
+    SWIRLY_INFO(logMsg() << "loaded snapshot: path=" << path << ",seq=" << impl.seq
+                         << ",records=" << header->records);
+    return true;
+}
+
+void SnapModel::loadModel(const Model& model, Time now)
+{
+    auto& impl = *impl_;
+    impl.clear();
+    model.readAsset([&impl](auto ptr) {
+        impl.assets.emplace_back();
+        setBody(impl.assets.back(), *ptr);
+    });
+    model.readInstr([&impl](auto ptr) {
+        impl.instrs.emplace_back();
+        setBody(impl.instrs.back(), *ptr);
+    });
+    model.readMarket([&impl](auto ptr) {
+        SnapMarketBody body;
+        setBody(body, *ptr);
+        impl.insert(body);
+    });
+    model.readAccnt(now, [&impl, &model](auto symbol) {
+        impl.accnts[symbol];
+        model.readExec(symbol, impl.maxExecs, [&impl](auto ptr) {
+            CreateExecBody body;
+            setBody(body, *ptr);
+            impl.pushExecBack(body);
+        });
+    });
+    model.readOrder([&impl](auto ptr) {
+        SnapOrderBody body;
+        setBody(body, *ptr);
+        impl.insert(body);
+    });
+    model.readTrade([&impl](auto ptr) {
+        CreateExecBody body;
+        setBody(body, *ptr);
+        impl.insertTrade(body);
+    });
+    // Positions are collapsed by business day when read from this model.
+    model.readPosn(0_jd, [&impl](auto ptr) {
+        SnapPosnBody body;
+        setBody(body, *ptr);
+        impl.insert(body);
+    });
+}
+
+uint64_t SnapModel::replay(const char* dir)
+{
+    auto& impl = *impl_;
+    const auto from = impl.seq;
+    // Multi-part sequences are applied as a unit, or discarded on reset.
+    vector<Msg> pending;
+    readBinJourn(dir, from + 1, [&impl, &pending](uint64_t seq, const Msg& msg) {
+        impl.seq = seq;
+        if (msg.type == MsgType::Reset) {
+            pending.clear();
+            return;
+        }
+        pending.push_back(msg);
+        if (moreOf(msg) == More::No) {
+            for (const auto& msg : pending) {
+                impl.dispatch(msg);
+            }
+            pending.clear();
+        }
+    });
+    if (!pending.empty()) {
+        SWIRLY_WARNING(logMsg() << "discarded incomplete multi-part sequence: msgs="
+                                << pending.size());
+    }
+    SWIRLY_INFO(logMsg() << "replayed binary journal: from=" << from << ",to=" << impl.seq);
+    return impl.seq;
+}
+
+void SnapModel::doReadAsset(const ModelCallback<AssetPtr>& cb) const
+{
+    for (const auto& body : impl_->assets) {
+        cb(makeAsset(body));
+    }
+}
+
+void SnapModel::doReadInstr(const ModelCallback<InstrPtr>& cb) const
+{
+    for (const auto& body : impl_->instrs) {
+        cb(makeInstr(body));
+    }
+}
+
+void SnapModel::doReadAccnt(Time now, const ModelCallback<string_view>& cb) const
+{
+    for (const auto& entry : impl_->accnts) {
+        cb(+entry.first);
+    }
+}
+
+void SnapModel::doReadMarket(const ModelCallback<MarketPtr>& cb) const
+{
+    for (const auto& entry : impl_->markets) {
+        cb(makeMarket(entry.second));
+    }
+}
+
+void SnapModel::doReadOrder(const ModelCallback<OrderPtr>& cb) const
+{
+    for (const auto& entry : impl_->orders) {
+        const auto& body = entry.second;
+        if (body.resdLots > 0_lts) {
+            cb(makeOrder(body));
+        }
+    }
+}
+
+void SnapModel::doReadExec(string_view accnt, size_t limit, const ModelCallback<ExecPtr>& cb) const
+{
+    const auto it = impl_->accnts.find(Symbol{accnt});
+    if (it == impl_->accnts.end()) {
+        return;
+    }
+    const auto& execs = it->second;
+    for (size_t i{0}; i < min(limit, execs.size()); ++i) {
+        cb(makeExec(execs[i]));
+    }
+}
+
+void SnapModel::doReadTrade(const ModelCallback<ExecPtr>& cb) const
+{
+    for (const auto& entry : impl_->trades) {
+        cb(makeExec(entry.second));
+    }
+}
+
+void SnapModel::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
+{
+    PosnSet ps;
+    PosnSet::Iterator it;
+
+    for (const auto& entry : impl_->posns) {
+        const auto& body = entry.second;
+        auto marketId = body.marketId;
+        auto settlDay = body.settlDay;
+
+        // Positions for settled markets are rolled, as they are by Serv::settlEndOfDay().
+        if (settlDay != 0_jd && settlDay <= busDay) {
+            marketId &= Id64{~0xffff};
+            settlDay = 0_jd;
+        }
+
+        const auto accnt = toSymbol(body.accnt);
+        bool found;
+        tie(it, found) = ps.findHint(accnt, marketId);
+        if (!found) {
+            it = ps.insertHint(it, Posn::make(accnt, marketId, toSymbol(body.instr), settlDay));
+        }
+        it->addBuy(body.buyLots, body.buyCost);
+        it->addSell(body.sellLots, body.sellCost);
+    }
+
+    for (it = ps.begin(); it != ps.end();) {
+        cb(ps.remove(it++));
+    }
+}
+
+} // swirly
@@ -0,0 +1,285 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_FIN_SNAP_HPP
+#define SWIRLY_FIN_SNAP_HPP
+
+#include <swirly/fin/Limits.hpp>
+#include <swirly/fin/Model.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/util/File.hpp>
+
+#include <string>
+#include <vector>
+
+namespace swirly {
+
+enum class SnapType : int { Asset, Instr, Market, Accnt, Order, Exec, Trade, Posn };
+
+struct SWIRLY_PACKED SnapAssetBody {
+    Id32 id;
+    char symbol[MaxSymbol];
+    char display[MaxDisplay];
+    AssetType type;
+};
+static_assert(std::is_pod<SnapAssetBody>::value);
+
+struct SWIRLY_PACKED SnapInstrBody {
+    Id32 id;
+    char symbol[MaxSymbol];
+    char display[MaxDisplay];
+    char baseAsset[MaxSymbol];
+    char termCcy[MaxSymbol];
+    int lotNumer;
+    int lotDenom;
+    int tickNumer;
+    int tickDenom;
+    int pipDp;
+    Lots minLots;
+    Lots maxLots;
+};
+static_assert(std::is_pod<SnapInstrBody>::value);
+
+struct SWIRLY_PACKED SnapMarketBody {
+    Id64 id;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    MarketState state;
+    Lots lastLots;
+    Ticks lastTicks;
+    // std::chrono::time_point is not pod.
+    int64_t lastTime;
+    Id64 maxId;
+};
+static_assert(std::is_pod<SnapMarketBody>::value);
+
+struct SWIRLY_PACKED SnapAccntBody {
+    char symbol[MaxSymbol];
+};
+static_assert(std::is_pod<SnapAccntBody>::value);
+
+struct SWIRLY_PACKED SnapOrderBody {
+    char accnt[MaxSymbol];
+    Id64 marketId;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    Id64 id;
+    char ref[MaxRef];
+    State state;
+    Side side;
+    Lots lots;
+    Ticks ticks;
+    Lots resdLots;
+    Lots execLots;
+    Cost execCost;
+    Lots lastLots;
+    Ticks lastTicks;
+    Lots minLots;
+    TimeInForce tif;
+    // std::chrono::time_point is not pod.
+    int64_t created;
+    int64_t modified;
+};
+static_assert(std::is_pod<SnapOrderBody>::value);
+
+struct SWIRLY_PACKED SnapPosnBody {
+    char accnt[MaxSymbol];
+    Id64 marketId;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    Lots buyLots;
+    Cost buyCost;
+    Lots sellLots;
+    Cost sellCost;
+};
+static_assert(std::is_pod<SnapPosnBody>::value);
+
+/**
+ * Fixed-size snapshot record. Executions and trades share the journal's CreateExecBody layout.
+ * Executions are written in account order, most recent first.
+ */
+struct SWIRLY_PACKED SnapRecord {
+    SnapType type;
+    union SWIRLY_PACKED {
+        SnapAssetBody asset;
+        SnapInstrBody instr;
+        SnapMarketBody market;
+        SnapAccntBody accnt;
+        SnapOrderBody order;
+        CreateExecBody exec;
+        SnapPosnBody posn;
+    };
+};
+static_assert(std::is_pod<SnapRecord>::value);
+static_assert(sizeof(SnapRecord) == 240, "must be specific size");
+
+/**
+ * Make Order from snapshot record body.
+ */
+SWIRLY_API OrderPtr makeOrder(const SnapOrderBody& body);
+
+/**
+ * Make Exec from journal or snapshot record body.
+ */
+SWIRLY_API ExecPtr makeExec(const CreateExecBody& body);
+
+/**
+ * Snapshot file header. The record count is written last, so that a truncated snapshot is
+ * detected on load.
+ */
+struct SnapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    /**
+     * Sequence number of the last journal record reflected in the snapshot.
+     */
+    uint64_t seq;
+    int64_t created;
+    uint64_t records;
+    char reserved[24];
+};
+static_assert(std::is_pod<SnapHeader>::value);
+static_assert(sizeof(SnapHeader) == 64, "must be specific size");
+
+/**
+ * Writes a snapshot to a temporary file, which atomically replaces the target path on commit.
+ * The temporary file is removed if the writer is destroyed before commit.
+ */
+class SWIRLY_API SnapWriter {
+  public:
+    SnapWriter(const char* path, uint64_t seq, Time now);
+    ~SnapWriter() noexcept;
+
+    // Copy.
+    SnapWriter(const SnapWriter&) = delete;
+    SnapWriter& operator=(const SnapWriter&) = delete;
+
+    // Move.
+    SnapWriter(SnapWriter&&) = delete;
+    SnapWriter& operator=(SnapWriter&&) = delete;
+
+    uint64_t records() const noexcept { return records_; }
+
+    void write(const Asset& asset);
+
+    void write(const Instr& instr);
+
+    void write(const Market& market);
+
+    void writeAccnt(Symbol symbol);
+
+    void write(const Order& order);
+
+    void writeExec(const Exec& exec);
+
+    void writeTrade(const Exec& trade);
+
+    void write(const Posn& posn);
+
+    /**
+     * Flush, sync and rename the snapshot into place.
+     */
+    void commit();
+
+  private:
+    SnapRecord& next();
+
+    void flush();
+
+    const std::string path_;
+    const std::string tmpPath_;
+    File file_;
+    std::vector<SnapRecord> buf_;
+    SnapHeader header_;
+    uint64_t records_{0};
+    bool committed_{false};
+};
+
+/**
+ * Model that restores engine state from a snapshot, or from another model, and then rolls it
+ * forward by applying the binary journal records that follow the snapshot's sequence number. The
+ * journal is applied with the same semantics as the sqlite journal's triggers.
+ */
+class SWIRLY_API SnapModel : public Model {
+  public:
+    /**
+     * @param maxExecs Max Exec history retained per account.
+     */
+    explicit SnapModel(std::size_t maxExecs);
+    ~SnapModel() noexcept override;
+
+    // Copy.
+    SnapModel(const SnapModel&) = delete;
+    SnapModel& operator=(const SnapModel&) = delete;
+
+    // Move.
+    SnapModel(SnapModel&&);
+    SnapModel& operator=(SnapModel&&);
+
+    /**
+     * @return the sequence number of the last journal record reflected in the model.
+     */
+    uint64_t seq() const noexcept;
+
+    /**
+     * Load state from snapshot file.
+     *
+     * @return false if the file does not exist.
+     */
+    bool loadSnap(const char* path);
+
+    /**
+     * Load state from model. The model is assumed to reflect all records preceding the journal, so
+     * the sequence number is zero.
+     */
+    void loadModel(const Model& model, Time now);
+
+    /**
+     * Apply binary journal records following the current sequence number. An incomplete
+     * multi-part sequence at the end of the journal is discarded.
+     *
+     * @return the new sequence number.
+     */
+    uint64_t replay(const char* dir);
+
+  protected:
+    void doReadAsset(const ModelCallback<AssetPtr>& cb) const override;
+
+    void doReadInstr(const ModelCallback<InstrPtr>& cb) const override;
+
+    void doReadAccnt(Time now, const ModelCallback<std::string_view>& cb) const override;
+
+    void doReadMarket(const ModelCallback<MarketPtr>& cb) const override;
+
+    void doReadOrder(const ModelCallback<OrderPtr>& cb) const override;
+
+    void doReadExec(std::string_view accnt, std::size_t limit,
+                    const ModelCallback<ExecPtr>& cb) const override;
+
+    void doReadTrade(const ModelCallback<ExecPtr>& cb) const override;
+
+    void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const override;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // swirly
+
+#endif // SWIRLY_FIN_SNAP_HPP
@@ -0,0 +1,262 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Snap.hpp"
+
+#include <swirly/fin/BinJourn.hpp>
+#include <swirly/fin/Exec.hpp>
+#include <swirly/fin/Market.hpp>
+#include <swirly/fin/MarketId.hpp>
+#include <swirly/fin/Order.hpp>
+#include <swirly/fin/Posn.hpp>
+
+#include <swirly/unit/TempDir.hpp>
+#include <swirly/unit/Test.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+using swirly::test::TempDir;
+
+namespace {
+
+constexpr auto SettlDay = 2457000_jd;
+constexpr auto MarketId = toMarketId(1_id32, SettlDay);
+
+Msg makeReset()
+{
+    Msg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MsgType::Reset;
+    return msg;
+}
+
+Msg makeCreateMarket()
+{
+    Msg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MsgType::CreateMarket;
+    auto& body = msg.createMarket;
+    body.id = MarketId;
+    setCString(body.instr, "EURUSD"_sv);
+    body.settlDay = SettlDay;
+    return msg;
+}
+
+Msg makeCreateExec(string_view accnt, Id64 id, Id64 orderId, State state, Side side,
+                   Lots resdLots, Lots lastLots, More more, TimeInForce tif = TimeInForce::Gtc)
+{
+    Msg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MsgType::CreateExec;
+    auto& body = msg.createExec;
+    setCString(body.accnt, accnt);
+    body.marketId = MarketId;
+    setCString(body.instr, "EURUSD"_sv);
+    body.settlDay = SettlDay;
+    body.id = id;
+    body.orderId = orderId;
+    body.state = state;
+    body.side = side;
+    body.lots = 10_lts;
+    body.ticks = 12345_tks;
+    body.resdLots = resdLots;
+    body.execLots = 10_lts - resdLots;
+    body.execCost = cost(10_lts - resdLots, 12345_tks);
+    body.lastLots = lastLots;
+    body.lastTicks = lastLots != 0_lts ? 12345_tks : 0_tks;
+    body.minLots = 1_lts;
+    body.tif = tif;
+    body.created = 1388534400000;
+    body.more = more;
+    return msg;
+}
+
+template <typename ValueT>
+vector<ValueT> readAll(void (Model::*fn)(const ModelCallback<ValueT>&) const, const Model& model)
+{
+    vector<ValueT> v;
+    (model.*fn)([&v](auto ptr) { v.push_back(std::move(ptr)); });
+    return v;
+}
+
+} // anonymous
+
+SWIRLY_TEST_CASE(SnapReplay)
+{
+    TempDir dir;
+    {
+        BinJourn journ{dir.path(), 1 << 16, JournSync::None};
+        journ.update(makeCreateMarket());
+        journ.update(makeCreateExec("MARAYL"_sv, 1_id64, 1_id64, State::New, Side::Buy, 10_lts,
+                                    0_lts, More::No));
+        // Trade and its counter-party are journaled as a multi-part sequence.
+        vector<Msg> msgs{
+            makeCreateExec("MARAYL"_sv, 2_id64, 1_id64, State::Trade, Side::Buy, 7_lts, 3_lts,
+                           More::Yes),
+            makeCreateExec("GOSAYL"_sv, 3_id64, 0_id64, State::Trade, Side::Sell, 0_lts, 3_lts,
+                           More::No)};
+        journ.update(msgs);
+        // Incomplete sequences are discarded on reset.
+        journ.update(makeCreateExec("MARAYL"_sv, 4_id64, 1_id64, State::Cancel, Side::Buy, 0_lts,
+                                    0_lts, More::Yes));
+        journ.update(makeReset());
+    }
+
+    SnapModel model{2};
+    SWIRLY_CHECK(model.replay(dir.path()) == 6);
+    SWIRLY_CHECK(model.seq() == 6);
+
+    const auto markets = readAll(&Model::readMarket, model);
+    SWIRLY_CHECK(markets.size() == 1);
+    SWIRLY_CHECK(markets[0]->maxId() == 3_id64);
+    SWIRLY_CHECK(markets[0]->lastLots() == 3_lts);
+    SWIRLY_CHECK(markets[0]->lastTicks() == 12345_tks);
+
+    const auto orders = readAll(&Model::readOrder, model);
+    SWIRLY_CHECK(orders.size() == 1);
+    SWIRLY_CHECK(orders[0]->state() == State::Trade);
+    SWIRLY_CHECK(orders[0]->resdLots() == 7_lts);
+    SWIRLY_CHECK(orders[0]->execLots() == 3_lts);
+
+    SWIRLY_CHECK(readAll(&Model::readTrade, model).size() == 2);
+
+    vector<ExecPtr> execs;
+    model.readExec("MARAYL"_sv, 16, [&execs](auto ptr) { execs.push_back(ptr); });
+    SWIRLY_CHECK(execs.size() == 2);
+    // Most recent first.
+    SWIRLY_CHECK(execs[0]->id() == 2_id64);
+
+    vector<PosnPtr> posns;
+    model.readPosn(SettlDay - 1_jd, [&posns](auto ptr) { posns.push_back(ptr); });
+    SWIRLY_CHECK(posns.size() == 2);
+    SWIRLY_CHECK(posns[0]->accnt() == "GOSAYL"_sv);
+    SWIRLY_CHECK(posns[0]->sellLots() == 3_lts);
+    SWIRLY_CHECK(posns[1]->buyLots() == 3_lts);
+    SWIRLY_CHECK(posns[1]->buyCost() == cost(3_lts, 12345_tks));
+}
+
+SWIRLY_TEST_CASE(SnapRoundTrip)
+{
+    TempDir dir;
+    const auto path = dir.file("snap");
+
+    SnapModel model{2};
+    SWIRLY_CHECK(!model.loadSnap(path.c_str()));
+    {
+        BinJourn journ{dir.path(), 1 << 16, JournSync::None};
+        journ.update(makeCreateMarket());
+        journ.update(makeCreateExec("MARAYL"_sv, 1_id64, 1_id64, State::New, Side::Buy, 10_lts,
+                                    0_lts, More::No));
+    }
+    model.replay(dir.path());
+    {
+        SnapWriter writer{path.c_str(), model.seq(), Time{}};
+        for (const auto& market : readAll(&Model::readMarket, model)) {
+            writer.write(*market);
+        }
+        writer.writeAccnt("MARAYL"_sv);
+        model.readExec("MARAYL"_sv, 16, [&writer](auto ptr) { writer.writeExec(*ptr); });
+        for (const auto& order : readAll(&Model::readOrder, model)) {
+            writer.write(*order);
+        }
+        // Not committed.
+    }
+    SWIRLY_CHECK(!model.loadSnap(path.c_str()));
+    {
+        SnapWriter writer{path.c_str(), model.seq(), Time{}};
+        for (const auto& market : readAll(&Model::readMarket, model)) {
+            writer.write(*market);
+        }
+        writer.writeAccnt("MARAYL"_sv);
+        model.readExec("MARAYL"_sv, 16, [&writer](auto ptr) { writer.writeExec(*ptr); });
+        for (const auto& order : readAll(&Model::readOrder, model)) {
+            writer.write(*order);
+        }
+        SWIRLY_CHECK(writer.records() == 4);
+        writer.commit();
+    }
+
+    SnapModel snap{2};
+    SWIRLY_CHECK(snap.loadSnap(path.c_str()));
+    SWIRLY_CHECK(snap.seq() == 2);
+    // Nothing to replay.
+    SWIRLY_CHECK(snap.replay(dir.path()) == 2);
+
+    const auto markets = readAll(&Model::readMarket, snap);
+    SWIRLY_CHECK(markets.size() == 1);
+    SWIRLY_CHECK(markets[0]->id() == MarketId);
+    SWIRLY_CHECK(markets[0]->maxId() == 1_id64);
+
+    const auto orders = readAll(&Model::readOrder, snap);
+    SWIRLY_CHECK(orders.size() == 1);
+    SWIRLY_CHECK(orders[0]->accnt() == "MARAYL"_sv);
+    SWIRLY_CHECK(orders[0]->ticks() == 12345_tks);
+    SWIRLY_CHECK(orders[0]->resdLots() == 10_lts);
+
+    vector<string> accnts;
+    snap.readAccnt(Time{},
+                   [&accnts](auto symbol) { accnts.emplace_back(symbol.data(), symbol.size()); });
+    SWIRLY_CHECK(accnts.size() == 1);
+    SWIRLY_CHECK(accnts[0] == "MARAYL");
+}
+
+SWIRLY_TEST_CASE(SnapTail)
+{
+    TempDir dir;
+    const auto path = dir.file("snap");
+
+    SnapModel model{2};
+    {
+        BinJourn journ{dir.path(), 1 << 16, JournSync::None};
+        journ.update(makeCreateMarket());
+        journ.update(makeCreateExec("MARAYL"_sv, 1_id64, 1_id64, State::New, Side::Buy, 10_lts,
+                                    0_lts, More::No));
+    }
+    model.replay(dir.path());
+    {
+        SnapWriter writer{path.c_str(), model.seq(), Time{}};
+        for (const auto& market : readAll(&Model::readMarket, model)) {
+            writer.write(*market);
+        }
+        for (const auto& order : readAll(&Model::readOrder, model)) {
+            writer.write(*order);
+        }
+        writer.commit();
+    }
+    // Journal tail after the snapshot.
+    {
+        BinJourn journ{dir.path(), 1 << 16, JournSync::None};
+        journ.update(makeCreateExec("GOSAYL"_sv, 2_id64, 2_id64, State::New, Side::Sell, 10_lts,
+                                    0_lts, More::No, TimeInForce::Ioc));
+    }
+
+    SnapModel snap{2};
+    SWIRLY_CHECK(snap.loadSnap(path.c_str()));
+    SWIRLY_CHECK(snap.replay(dir.path()) == 3);
+
+    const auto orders = readAll(&Model::readOrder, snap);
+    SWIRLY_CHECK(orders.size() == 2);
+    // From the snapshot.
+    SWIRLY_CHECK(orders[0]->id() == 1_id64);
+    SWIRLY_CHECK(orders[0]->tif() == TimeInForce::Gtc);
+    // From the journal tail.
+    SWIRLY_CHECK(orders[1]->id() == 2_id64);
+    SWIRLY_CHECK(orders[1]->tif() == TimeInForce::Ioc);
+}
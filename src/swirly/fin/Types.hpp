@@ -70,7 +70,7 @@ class Posn;
 using PosnPtr = boost::intrusive_ptr<Posn>;
 using ConstPosnPtr = boost::intrusive_ptr<const Posn>;
 
-enum class More : int { No, Yes };
+enum class More : std::uint8_t { No, Yes };
 
 } // swirly
 
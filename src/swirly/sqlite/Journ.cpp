@@ -16,9 +16,13 @@
  */
 #include "Journ.hxx"
 
+#include <swirly/fin/BinJourn.hpp>
 #include <swirly/fin/Exec.hpp>
 
 #include <swirly/util/Conf.hpp>
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/Finally.hpp>
+#include <swirly/util/Log.hpp>
 
 using namespace std;
 
@@ -30,6 +34,10 @@ constexpr auto BeginSql = "BEGIN TRANSACTION"_sv;
 constexpr auto CommitSql = "COMMIT TRANSACTION"_sv;
 constexpr auto RollbackSql = "ROLLBACK TRANSACTION"_sv;
 
+constexpr auto SavepointSql = "SAVEPOINT multi_part"_sv;
+constexpr auto ReleaseSql = "RELEASE SAVEPOINT multi_part"_sv;
+constexpr auto RollbackToSql = "ROLLBACK TRANSACTION TO SAVEPOINT multi_part"_sv;
+
 constexpr auto InsertMarketSql = //
     "INSERT INTO market_t (id, instr, settl_day, state)" //
     " VALUES (?, ?, ?, ?)"_sv;
@@ -38,11 +46,14 @@ constexpr auto UpdateMarketSql = //
     "UPDATE Market_t SET state = ?2" //
     " WHERE id = ?1"_sv;
 
+// The seq_id is derived from the account's max_id, which is then incremented by trigger. This avoids
+// updating the exec row after insert.
 constexpr auto InsertExecSql = //
     "INSERT INTO exec_t (market_id, instr, settl_day, id, order_id, accnt, ref," //
     " state_id, side_id, lots, ticks, resd_lots, exec_lots, exec_cost, last_lots," //
-    " last_ticks, min_lots, match_id, liqInd_id, cpty, created)" //
-    " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"_sv;
+    " last_ticks, min_lots, match_id, liqInd_id, tif_id, cpty, created, seq_id)" //
+    " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?," //
+    " COALESCE((SELECT max_id FROM accnt_t WHERE symbol = ?6), 0) + 1)"_sv;
 
 constexpr auto UpdateExecSql = //
     "UPDATE exec_t SET archive = ?3" //
@@ -55,6 +66,9 @@ Journ::Journ(const Conf& conf)
       beginStmt_{prepare(*db_, BeginSql)},
       commitStmt_{prepare(*db_, CommitSql)},
       rollbackStmt_{prepare(*db_, RollbackSql)},
+      savepointStmt_{prepare(*db_, SavepointSql)},
+      releaseStmt_{prepare(*db_, ReleaseSql)},
+      rollbackToStmt_{prepare(*db_, RollbackToSql)},
       insertMarketStmt_{prepare(*db_, InsertMarketSql)},
       updateMarketStmt_{prepare(*db_, UpdateMarketSql)},
       insertExecStmt_{prepare(*db_, InsertExecSql)},
@@ -70,17 +84,23 @@ Journ& Journ::operator=(Journ&&) = default;
 
 void Journ::doBegin()
 {
-    stepOnce(*beginStmt_);
+    stepOnce(batch_ ? *savepointStmt_ : *beginStmt_);
 }
 
 void Journ::doCommit()
 {
-    stepOnce(*commitStmt_);
+    stepOnce(batch_ ? *releaseStmt_ : *commitStmt_);
 }
 
 void Journ::doRollback()
 {
-    stepOnce(*rollbackStmt_);
+    if (batch_) {
+        // Rolling back to a savepoint leaves it on the stack.
+        stepOnce(*rollbackToStmt_);
+        stepOnce(*releaseStmt_);
+    } else {
+        stepOnce(*rollbackStmt_);
+    }
 }
 
 void Journ::doUpdate(const Msg& msg)
@@ -88,6 +108,36 @@ void Journ::doUpdate(const Msg& msg)
     dispatch(msg);
 }
 
+void Journ::doUpdateBatch(ArrayView<Msg> msgs)
+{
+    // Group commit: the whole batch is written in a single transaction. Statement failures only
+    // undo the failing statement, and failed multi-part sequences are undone by their savepoint,
+    // so each message keeps the same outcome that it would have had on its own.
+    stepOnce(*beginStmt_);
+    {
+        batch_ = true;
+        auto finally = makeFinally([this]() { batch_ = false; });
+        for (const auto& msg : msgs) {
+            try {
+                dispatch(msg);
+            } catch (const exception& e) {
+                SWIRLY_ERROR(logMsg() << "failed to update journal: " << e.what());
+            }
+        }
+        // Discard a multi-part sequence that was cut short, e.g. by shutdown.
+        Transactional::reset();
+    }
+    try {
+        stepOnce(*commitStmt_);
+    } catch (...) {
+        // Some errors cause SQLite to rollback the transaction automatically.
+        if (!sqlite3_get_autocommit(db_.get())) {
+            stepOnce(*rollbackStmt_);
+        }
+        throw;
+    }
+}
+
 void Journ::onReset()
 {
     Transactional::reset();
@@ -150,6 +200,7 @@ void Journ::onCreateExec(const CreateExecBody& body)
     bind(body.minLots);
     bind(body.matchId, MaybeNull);
     bind(body.liqInd, MaybeNull);
+    bind(body.tif);
     bind(toStringView(body.cpty), MaybeNull);
     bind(body.created); // Created.
 
@@ -184,6 +235,13 @@ void Journ::onArchiveTrade(const ArchiveTradeBody& body)
 
 unique_ptr<Journ> makeJourn(const Conf& conf)
 {
+    const string_view type{conf.get("journ_type", "sqlite")};
+    if (iequals(type, "binary"_sv)) {
+        return make_unique<BinJourn>(conf);
+    }
+    if (!iequals(type, "sqlite"_sv)) {
+        throw Exception{errMsg() << "invalid journ_type: " << type};
+    }
     return make_unique<sqlite::Journ>(conf);
 }
 
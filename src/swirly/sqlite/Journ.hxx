@@ -51,6 +51,8 @@ class Journ : public Transactional, public swirly::Journ, BasicMsgHandler<Journ>
 
     void doUpdate(const Msg& msg) override;
 
+    void doUpdateBatch(ArrayView<Msg> msgs) override;
+
   private:
     void onReset();
 
@@ -66,10 +68,15 @@ class Journ : public Transactional, public swirly::Journ, BasicMsgHandler<Journ>
     StmtPtr beginStmt_;
     StmtPtr commitStmt_;
     StmtPtr rollbackStmt_;
+    StmtPtr savepointStmt_;
+    StmtPtr releaseStmt_;
+    StmtPtr rollbackToStmt_;
     StmtPtr insertMarketStmt_;
     StmtPtr updateMarketStmt_;
     StmtPtr insertExecStmt_;
     StmtPtr updateExecStmt_;
+    // True while a batch transaction is open. Multi-part sequences then map to savepoints.
+    bool batch_{false};
 };
 
 } // sqlite
@@ -23,9 +23,13 @@
 
 #include <swirly/fin/Order.hpp>
 #include <swirly/fin/Posn.hpp>
+#include <swirly/fin/Snap.hpp>
 
 #include <swirly/util/Conf.hpp>
 
+#include <atomic>
+#include <thread>
+
 using namespace std;
 
 namespace swirly {
@@ -48,29 +52,250 @@ constexpr auto SelectAccntSql = //
 
 constexpr auto SelectOrderSql = //
     "SELECT accnt, market_id, instr, settl_day, id, ref, state_id, side_id, lots, ticks," //
-    " resd_lots, exec_lots, exec_cost, last_lots, last_ticks, min_lots, created, modified" //
-    " FROM order_t WHERE resd_lots > 0;"_sv;
+    " resd_lots, exec_lots, exec_cost, last_lots, last_ticks, min_lots, tif_id, created," //
+    " modified FROM order_t WHERE resd_lots > 0;"_sv;
 
 constexpr auto SelectExecSql = //
     "SELECT market_id, instr, settl_day, id, order_id, ref, state_id, side_id, lots, ticks," //
     " resd_lots, exec_lots, exec_cost, last_lots, last_ticks, min_lots, match_id, liqInd_id," //
-    " cpty, created" //
+    " tif_id, cpty, created" //
     " FROM exec_t WHERE accnt = ? ORDER BY seq_id DESC LIMIT ?;"_sv;
 
+// Exec seq_ids are contiguous per account, so the most recent execs for each account are found with
+// a single range scan of the (accnt, seq_id) index. Accounts may be partitioned by rowid, so that
+// the history can be read concurrently.
+constexpr auto SelectAllExecSql = //
+    "SELECT e.accnt, e.market_id, e.instr, e.settl_day, e.id, e.order_id, e.ref, e.state_id," //
+    " e.side_id, e.lots, e.ticks, e.resd_lots, e.exec_lots, e.exec_cost, e.last_lots," //
+    " e.last_ticks, e.min_lots, e.match_id, e.liqInd_id, e.tif_id, e.cpty, e.created" //
+    " FROM accnt_t a JOIN exec_t e ON e.accnt = a.symbol AND e.seq_id > a.max_id - ?2" //
+    " WHERE a.modified > ?1 AND a.rowid % ?3 = ?4 ORDER BY a.symbol, e.seq_id DESC;"_sv;
+
 constexpr auto SelectTradeSql = //
-    "SELECT accnt, market_id, instr, settl_day, id, order_id, ref, side_id, lots, ticks," //
-    " resd_lots, exec_lots, exec_cost, last_lots, last_ticks, min_lots, match_id, liqInd_id," //
-    " cpty, created" //
+    "SELECT accnt, market_id, instr, settl_day, id, order_id, ref, state_id, side_id, lots," //
+    " ticks, resd_lots, exec_lots, exec_cost, last_lots, last_ticks, min_lots, match_id," //
+    " liqInd_id, tif_id, cpty, created" //
     " FROM exec_t WHERE state_id = 4 AND archive IS NULL;"_sv;
 
 constexpr auto SelectPosnSql = //
-    "SELECT accnt, market_id, instr, settl_day, side_id, lots, cost FROM posn_v;"_sv;
+    "SELECT accnt, market_id, instr, settl_day, buy_lots, buy_cost, sell_lots, sell_cost" //
+    " FROM posn_t;"_sv;
+
+void fetchAccnt(sqlite3& db, Time now, vector<SnapAccntBody>& rows)
+{
+    enum { //
+        Symbol //
+    };
+
+    StmtPtr stmt{prepare(db, SelectAccntSql)};
+    ScopedBind bind{*stmt};
+    // One week ago.
+    bind(now - 604800000ms);
+    while (step(*stmt)) {
+        rows.emplace_back();
+        setCString(rows.back().symbol, column<string_view>(*stmt, Symbol));
+    }
+}
+
+void fetchOrder(sqlite3& db, vector<SnapOrderBody>& rows)
+{
+    enum { //
+        Accnt, //
+        MarketId, //
+        Instr, //
+        SettlDay, //
+        Id, //
+        Ref, //
+        State, //
+        Side, //
+        Lots, //
+        Ticks, //
+        ResdLots, //
+        ExecLots, //
+        ExecCost, //
+        LastLots, //
+        LastTicks, //
+        MinLots, //
+        Tif, //
+        Created, //
+        Modified //
+    };
+
+    StmtPtr stmt{prepare(db, SelectOrderSql)};
+    while (step(*stmt)) {
+        rows.emplace_back();
+        auto& row = rows.back();
+        setCString(row.accnt, column<string_view>(*stmt, Accnt));
+        row.marketId = column<Id64>(*stmt, MarketId);
+        setCString(row.instr, column<string_view>(*stmt, Instr));
+        row.settlDay = column<JDay>(*stmt, SettlDay);
+        row.id = column<Id64>(*stmt, Id);
+        setCString(row.ref, column<string_view>(*stmt, Ref));
+        row.state = column<swirly::State>(*stmt, State);
+        row.side = column<swirly::Side>(*stmt, Side);
+        row.lots = column<swirly::Lots>(*stmt, Lots);
+        row.ticks = column<swirly::Ticks>(*stmt, Ticks);
+        row.resdLots = column<swirly::Lots>(*stmt, ResdLots);
+        row.execLots = column<swirly::Lots>(*stmt, ExecLots);
+        row.execCost = column<swirly::Cost>(*stmt, ExecCost);
+        row.lastLots = column<swirly::Lots>(*stmt, LastLots);
+        row.lastTicks = column<swirly::Ticks>(*stmt, LastTicks);
+        row.minLots = column<swirly::Lots>(*stmt, MinLots);
+        row.tif = column<TimeInForce>(*stmt, Tif);
+        row.created = column<int64_t>(*stmt, Created);
+        row.modified = column<int64_t>(*stmt, Modified);
+    }
+}
+
+void fetchExec(sqlite3_stmt& stmt, vector<CreateExecBody>& rows)
+{
+    enum { //
+        Accnt, //
+        MarketId, //
+        Instr, //
+        SettlDay, //
+        Id, //
+        OrderId, //
+        Ref, //
+        State, //
+        Side, //
+        Lots, //
+        Ticks, //
+        ResdLots, //
+        ExecLots, //
+        ExecCost, //
+        LastLots, //
+        LastTicks, //
+        MinLots, //
+        MatchId, //
+        LiqInd, //
+        Tif, //
+        Cpty, //
+        Created //
+    };
+
+    while (step(stmt)) {
+        rows.emplace_back();
+        auto& row = rows.back();
+        setCString(row.accnt, column<string_view>(stmt, Accnt));
+        row.marketId = column<Id64>(stmt, MarketId);
+        setCString(row.instr, column<string_view>(stmt, Instr));
+        row.settlDay = column<JDay>(stmt, SettlDay);
+        row.id = column<Id64>(stmt, Id);
+        row.orderId = column<Id64>(stmt, OrderId);
+        setCString(row.ref, column<string_view>(stmt, Ref));
+        row.state = column<swirly::State>(stmt, State);
+        row.side = column<swirly::Side>(stmt, Side);
+        row.lots = column<swirly::Lots>(stmt, Lots);
+        row.ticks = column<swirly::Ticks>(stmt, Ticks);
+        row.resdLots = column<swirly::Lots>(stmt, ResdLots);
+        row.execLots = column<swirly::Lots>(stmt, ExecLots);
+        row.execCost = column<swirly::Cost>(stmt, ExecCost);
+        row.lastLots = column<swirly::Lots>(stmt, LastLots);
+        row.lastTicks = column<swirly::Ticks>(stmt, LastTicks);
+        row.minLots = column<swirly::Lots>(stmt, MinLots);
+        row.matchId = column<Id64>(stmt, MatchId);
+        row.liqInd = column<swirly::LiqInd>(stmt, LiqInd);
+        row.tif = column<TimeInForce>(stmt, Tif);
+        setCString(row.cpty, column<string_view>(stmt, Cpty));
+        row.created = column<int64_t>(stmt, Created);
+    }
+}
+
+void fetchAllExec(sqlite3& db, Time now, size_t limit, size_t parts, size_t part,
+                  vector<CreateExecBody>& rows)
+{
+    StmtPtr stmt{prepare(db, SelectAllExecSql)};
+    ScopedBind bind{*stmt};
+    // One week ago.
+    bind(now - 604800000ms);
+    bind(limit);
+    bind(parts);
+    bind(part);
+    fetchExec(*stmt, rows);
+}
+
+void fetchTrade(sqlite3& db, vector<CreateExecBody>& rows)
+{
+    StmtPtr stmt{prepare(db, SelectTradeSql)};
+    fetchExec(*stmt, rows);
+}
+
+void fetchPosn(sqlite3& db, vector<SnapPosnBody>& rows)
+{
+    enum { //
+        Accnt, //
+        MarketId, //
+        Instr, //
+        SettlDay, //
+        BuyLots, //
+        BuyCost, //
+        SellLots, //
+        SellCost //
+    };
+
+    StmtPtr stmt{prepare(db, SelectPosnSql)};
+    while (step(*stmt)) {
+        rows.emplace_back();
+        auto& row = rows.back();
+        setCString(row.accnt, column<string_view>(*stmt, Accnt));
+        row.marketId = column<Id64>(*stmt, MarketId);
+        setCString(row.instr, column<string_view>(*stmt, Instr));
+        row.settlDay = column<JDay>(*stmt, SettlDay);
+        row.buyLots = column<Lots>(*stmt, BuyLots);
+        row.buyCost = column<Cost>(*stmt, BuyCost);
+        row.sellLots = column<Lots>(*stmt, SellLots);
+        row.sellCost = column<Cost>(*stmt, SellCost);
+    }
+}
+
+template <typename RowT>
+bool take(unique_ptr<vector<RowT>>& ptr, vector<RowT>& rows) noexcept
+{
+    if (!ptr) {
+        return false;
+    }
+    rows = move(*ptr);
+    ptr.reset();
+    return true;
+}
 
 } // anonymous
 
+/**
+ * Rows fetched concurrently by prefetch. Each set of rows is consumed by the first matching read.
+ */
+struct Model::Prefetch {
+    Prefetch(Time now, size_t limit, size_t parts)
+        : now{now},
+          limit{limit},
+          accnts{make_unique<vector<SnapAccntBody>>()},
+          execs{make_unique<vector<vector<CreateExecBody>>>(parts)},
+          orders{make_unique<vector<SnapOrderBody>>()},
+          trades{make_unique<vector<CreateExecBody>>()},
+          posns{make_unique<vector<SnapPosnBody>>()}
+    {
+    }
+    const Time now;
+    const size_t limit;
+    unique_ptr<vector<SnapAccntBody>> accnts;
+    // Exec history by account partition.
+    unique_ptr<vector<vector<CreateExecBody>>> execs;
+    unique_ptr<vector<SnapOrderBody>> orders;
+    unique_ptr<vector<CreateExecBody>> trades;
+    unique_ptr<vector<SnapPosnBody>> posns;
+};
+
 Model::Model(const Conf& conf)
     : db_{openDb(conf.get("sqlite_model", "swirly.db"), SQLITE_OPEN_READONLY, conf)}
 {
+    auto threads = conf.get<size_t>("sqlite_model_threads", 0);
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    for (size_t i{1}; i < threads; ++i) {
+        pool_.push_back(openDb(conf.get("sqlite_model", "swirly.db"), SQLITE_OPEN_READONLY, conf));
+    }
 }
 
 Model::~Model() noexcept = default;
@@ -159,62 +384,23 @@ void Model::doReadMarket(const ModelCallback<MarketPtr>& cb) const
 
 void Model::doReadAccnt(Time now, const ModelCallback<string_view>& cb) const
 {
-    enum { //
-        Symbol //
-    };
-
-    StmtPtr stmt{prepare(*db_, SelectAccntSql)};
-    ScopedBind bind{*stmt};
-    // One week ago.
-    bind(now - 604800000ms);
-    while (step(*stmt)) {
-        cb(column<string_view>(*stmt, Symbol));
+    vector<SnapAccntBody> rows;
+    if (!prefetch_ || prefetch_->now != now || !take(prefetch_->accnts, rows)) {
+        fetchAccnt(*db_, now, rows);
+    }
+    for (const auto& row : rows) {
+        cb(toStringView(row.symbol));
     }
 }
 
 void Model::doReadOrder(const ModelCallback<OrderPtr>& cb) const
 {
-    enum { //
-        Accnt, //
-        MarketId, //
-        Instr, //
-        SettlDay, //
-        Id, //
-        Ref, //
-        State, //
-        Side, //
-        Lots, //
-        Ticks, //
-        ResdLots, //
-        ExecLots, //
-        ExecCost, //
-        LastLots, //
-        LastTicks, //
-        MinLots, //
-        Created, //
-        Modified //
-    };
-
-    StmtPtr stmt{prepare(*db_, SelectOrderSql)};
-    while (step(*stmt)) {
-        cb(Order::make(column<string_view>(*stmt, Accnt), //
-                       column<Id64>(*stmt, MarketId), //
-                       column<string_view>(*stmt, Instr), //
-                       column<JDay>(*stmt, SettlDay), //
-                       column<Id64>(*stmt, Id), //
-                       column<string_view>(*stmt, Ref), //
-                       column<swirly::State>(*stmt, State), //
-                       column<swirly::Side>(*stmt, Side), //
-                       column<swirly::Lots>(*stmt, Lots), //
-                       column<swirly::Ticks>(*stmt, Ticks), //
-                       column<swirly::Lots>(*stmt, ResdLots), //
-                       column<swirly::Lots>(*stmt, ExecLots), //
-                       column<swirly::Cost>(*stmt, ExecCost), //
-                       column<swirly::Lots>(*stmt, LastLots), //
-                       column<swirly::Ticks>(*stmt, LastTicks), //
-                       column<swirly::Lots>(*stmt, MinLots), //
-                       column<Time>(*stmt, Created), //
-                       column<Time>(*stmt, Modified)));
+    vector<SnapOrderBody> rows;
+    if (!prefetch_ || !take(prefetch_->orders, rows)) {
+        fetchOrder(*db_, rows);
+    }
+    for (const auto& row : rows) {
+        cb(makeOrder(row));
     }
 }
 
@@ -239,6 +425,7 @@ void Model::doReadExec(string_view accnt, size_t limit, const ModelCallback<Exec
         MinLots, //
         MatchId, //
         LiqInd, //
+        Tif, //
         Cpty, //
         Created //
     };
@@ -268,84 +455,52 @@ void Model::doReadExec(string_view accnt, size_t limit, const ModelCallback<Exec
                       column<Id64>(*stmt, MatchId), //
                       column<swirly::LiqInd>(*stmt, LiqInd), //
                       column<string_view>(*stmt, Cpty), //
-                      column<Time>(*stmt, Created)));
+                      column<Time>(*stmt, Created), //
+                      column<TimeInForce>(*stmt, Tif)));
+    }
+}
+void Model::doReadAllExec(Time now, size_t limit, const ModelCallback<ExecPtr>& cb) const
+{
+    vector<vector<CreateExecBody>> parts;
+    if (!prefetch_ || prefetch_->now != now || prefetch_->limit != limit
+        || !take(prefetch_->execs, parts)) {
+        parts.resize(1);
+        fetchAllExec(*db_, now, limit, 1, 0, parts.front());
+    }
+    for (const auto& rows : parts) {
+        for (const auto& row : rows) {
+            cb(makeExec(row));
+        }
     }
 }
 
 void Model::doReadTrade(const ModelCallback<ExecPtr>& cb) const
 {
-    enum { //
-        Accnt, //
-        MarketId, //
-        Instr, //
-        SettlDay, //
-        Id, //
-        OrderId, //
-        Ref, //
-        Side, //
-        Lots, //
-        Ticks, //
-        ResdLots, //
-        ExecLots, //
-        ExecCost, //
-        LastLots, //
-        LastTicks, //
-        MinLots, //
-        MatchId, //
-        LiqInd, //
-        Cpty, //
-        Created //
-    };
-
-    StmtPtr stmt{prepare(*db_, SelectTradeSql)};
-    while (step(*stmt)) {
-        cb(Exec::make(column<string_view>(*stmt, Accnt), //
-                      column<Id64>(*stmt, MarketId), //
-                      column<string_view>(*stmt, Instr), //
-                      column<JDay>(*stmt, SettlDay), //
-                      column<Id64>(*stmt, Id), //
-                      column<Id64>(*stmt, OrderId), //
-                      column<string_view>(*stmt, Ref), //
-                      State::Trade, //
-                      column<swirly::Side>(*stmt, Side), //
-                      column<swirly::Lots>(*stmt, Lots), //
-                      column<swirly::Ticks>(*stmt, Ticks), //
-                      column<swirly::Lots>(*stmt, ResdLots), //
-                      column<swirly::Lots>(*stmt, ExecLots), //
-                      column<swirly::Cost>(*stmt, ExecCost), //
-                      column<swirly::Lots>(*stmt, LastLots), //
-                      column<swirly::Ticks>(*stmt, LastTicks), //
-                      column<swirly::Lots>(*stmt, MinLots), //
-                      column<Id64>(*stmt, MatchId), //
-                      column<swirly::LiqInd>(*stmt, LiqInd), //
-                      column<string_view>(*stmt, Cpty), //
-                      column<Time>(*stmt, Created)));
+    vector<CreateExecBody> rows;
+    if (!prefetch_ || !take(prefetch_->trades, rows)) {
+        fetchTrade(*db_, rows);
+    }
+    for (const auto& row : rows) {
+        cb(makeExec(row));
     }
 }
 
 void Model::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
 {
-    enum { //
-        Accnt, //
-        MarketId, //
-        Instr, //
-        SettlDay, //
-        Side, //
-        Lots, //
-        Cost //
-    };
+    vector<SnapPosnBody> rows;
+    if (!prefetch_ || !take(prefetch_->posns, rows)) {
+        fetchPosn(*db_, rows);
+    }
 
     PosnSet ps;
     PosnSet::Iterator it;
 
-    StmtPtr stmt{prepare(*db_, SelectPosnSql)};
-    while (step(*stmt)) {
-        const auto accnt = column<string_view>(*stmt, Accnt);
-        auto marketId = column<Id64>(*stmt, MarketId);
-        const auto instr = column<string_view>(*stmt, Instr);
-        auto settlDay = column<JDay>(*stmt, SettlDay);
+    for (const auto& row : rows) {
+        const auto accnt = toStringView(row.accnt);
+        auto marketId = row.marketId;
+        auto settlDay = row.settlDay;
 
-        // FIXME: review when end of day is implemented.
+        // Positions for settled markets are rolled, as they are by Serv::settlEndOfDay().
         if (settlDay != 0_jd && settlDay <= busDay) {
             marketId &= Id64{~0xffff};
             settlDay = 0_jd;
@@ -354,17 +509,12 @@ void Model::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
         bool found;
         tie(it, found) = ps.findHint(accnt, marketId);
         if (!found) {
-            it = ps.insertHint(it, Posn::make(accnt, marketId, instr, settlDay));
+            it = ps.insertHint(it, Posn::make(accnt, marketId, toStringView(row.instr), settlDay));
         }
 
-        const auto side = column<swirly::Side>(*stmt, Side);
-        const auto lots = column<swirly::Lots>(*stmt, Lots);
-        const auto cost = column<swirly::Cost>(*stmt, Cost);
-        if (side == swirly::Side::Buy) {
-            it->addBuy(lots, cost);
-        } else {
-            it->addSell(lots, cost);
-        }
+        // Positions for past settlement days are merged.
+        it->addBuy(row.buyLots, row.buyCost);
+        it->addSell(row.sellLots, row.sellCost);
     }
 
     for (it = ps.begin(); it != ps.end();) {
@@ -372,6 +522,59 @@ void Model::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
     }
 }
 
+void Model::doPrefetch(Time now, size_t limit) const
+{
+    // The exec history is usually the largest read, so it is split into one partition of accounts
+    // per connection.
+    const auto parts = pool_.size() + 1;
+    auto prefetch = make_unique<Prefetch>(now, limit, parts);
+    auto& p = *prefetch;
+
+    vector<function<void(sqlite3&)>> tasks;
+    for (size_t i{0}; i < parts; ++i) {
+        tasks.emplace_back([&p, parts, i](sqlite3& db) {
+            fetchAllExec(db, p.now, p.limit, parts, i, (*p.execs)[i]);
+        });
+    }
+    tasks.emplace_back([&p](sqlite3& db) { fetchAccnt(db, p.now, *p.accnts); });
+    tasks.emplace_back([&p](sqlite3& db) { fetchOrder(db, *p.orders); });
+    tasks.emplace_back([&p](sqlite3& db) { fetchTrade(db, *p.trades); });
+    tasks.emplace_back([&p](sqlite3& db) { fetchPosn(db, *p.posns); });
+
+    // Each connection is used by a single worker, and the calling thread is one of the workers.
+    // Workers only fetch rows, because objects must be allocated on the calling thread.
+    vector<exception_ptr> errs(tasks.size());
+    atomic<size_t> next{0};
+    auto worker = [&tasks, &errs, &next](sqlite3& db) noexcept {
+        for (size_t i; (i = next++) < tasks.size();) {
+            try {
+                tasks[i](db);
+            } catch (...) {
+                errs[i] = current_exception();
+            }
+        }
+    };
+    {
+        vector<thread> threads;
+        threads.reserve(pool_.size());
+        auto finally = makeFinally([&threads]() {
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        });
+        for (const auto& db : pool_) {
+            threads.emplace_back(worker, ref(*db));
+        }
+        worker(*db_);
+    }
+    for (const auto& err : errs) {
+        if (err) {
+            rethrow_exception(err);
+        }
+    }
+    prefetch_ = move(prefetch);
+}
+
 } // sqlite
 
 unique_ptr<Model> makeModel(const Conf& conf)
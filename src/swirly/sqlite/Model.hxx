@@ -21,6 +21,8 @@
 
 #include <swirly/fin/Model.hpp>
 
+#include <vector>
+
 namespace swirly {
 namespace sqlite {
 
@@ -51,12 +53,21 @@ class Model : public swirly::Model {
     void doReadExec(std::string_view accnt, std::size_t limit,
                     const ModelCallback<ExecPtr>& cb) const override;
 
+    void doReadAllExec(Time now, std::size_t limit,
+                       const ModelCallback<ExecPtr>& cb) const override;
+
     void doReadTrade(const ModelCallback<ExecPtr>& cb) const override;
 
     void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const override;
 
+    void doPrefetch(Time now, std::size_t limit) const override;
+
   private:
+    struct Prefetch;
     DbPtr db_;
+    // Additional read-only connections used by prefetch.
+    std::vector<DbPtr> pool_;
+    mutable std::unique_ptr<Prefetch> prefetch_;
 };
 
 } // sqlite
@@ -0,0 +1,56 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "TempDir.hpp"
+
+#include <stdexcept>
+
+#include <cstdlib> // mkdtemp()
+
+#include <dirent.h> // opendir()
+#include <unistd.h> // rmdir(), unlink()
+
+using namespace std;
+
+namespace swirly {
+namespace test {
+
+TempDir::TempDir()
+{
+    char tmpl[] = "/tmp/swirlyXXXXXX";
+    if (!mkdtemp(tmpl)) {
+        throw runtime_error{"mkdtemp() failed"};
+    }
+    path_ = tmpl;
+}
+
+TempDir::~TempDir() noexcept
+{
+    // Tests only create plain files, so there is no need to recurse.
+    auto* const dir = opendir(path_.c_str());
+    if (dir) {
+        while (const auto* const ent = readdir(dir)) {
+            if (ent->d_name[0] != '.') {
+                unlink(file(ent->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path_.c_str());
+}
+
+} // test
+} // swirly
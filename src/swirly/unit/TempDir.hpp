@@ -0,0 +1,59 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UNIT_TEMPDIR_HPP
+#define SWIRLY_UNIT_TEMPDIR_HPP
+
+#ifndef SWIRLY_API
+#define SWIRLY_API __attribute__((visibility("default")))
+#endif // SWIRLY_API
+
+#include <string>
+
+namespace swirly {
+namespace test {
+
+/**
+ * Temporary directory that is created under /tmp, and removed together with the files it contains
+ * when the fixture goes out of scope.
+ */
+class SWIRLY_API TempDir {
+  public:
+    TempDir();
+    ~TempDir() noexcept;
+
+    // Copy.
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    // Move.
+    TempDir(TempDir&&) = delete;
+    TempDir& operator=(TempDir&&) = delete;
+
+    const char* path() const noexcept { return path_.c_str(); }
+    /**
+     * @return the path of a file within the directory.
+     */
+    std::string file(const char* name) const { return path_ + '/' + name; }
+
+  private:
+    std::string path_;
+};
+
+} // test
+} // swirly
+
+#endif // SWIRLY_UNIT_TEMPDIR_HPP
@@ -0,0 +1,41 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UTIL_ATOMIC_HPP
+#define SWIRLY_UTIL_ATOMIC_HPP
+
+#include <atomic>
+#include <type_traits>
+
+namespace swirly {
+
+/**
+ * Add to an atomic counter that has a single writer.
+ *
+ * The owning thread is the only one that modifies the counter, so a relaxed load followed by a
+ * store cannot lose an update, and avoids the locked read-modify-write of fetch_add(). Other
+ * threads may read the counter concurrently, and always see a value that was stored.
+ */
+template <typename ValueT>
+inline void singleWriterAdd(std::atomic<ValueT>& counter, std::common_type_t<ValueT> n,
+                            std::memory_order order = std::memory_order_relaxed) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, order);
+}
+
+} // swirly
+
+#endif // SWIRLY_UTIL_ATOMIC_HPP
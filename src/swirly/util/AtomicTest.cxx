@@ -0,0 +1,36 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Atomic.hpp"
+
+#include <swirly/unit/Test.hpp>
+
+#include <cstdint>
+
+using namespace std;
+using namespace swirly;
+
+SWIRLY_TEST_CASE(SingleWriterAdd)
+{
+    atomic<uint64_t> counter{0};
+    singleWriterAdd(counter, 1);
+    singleWriterAdd(counter, 41, memory_order_release);
+    SWIRLY_CHECK(counter.load(memory_order_acquire) == 42);
+
+    atomic<int64_t> total{10};
+    singleWriterAdd(total, -15);
+    SWIRLY_CHECK(total.load() == -5);
+}
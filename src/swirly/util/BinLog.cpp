@@ -0,0 +1,452 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "BinLog.hpp"
+
+#include <swirly/util/Atomic.hpp>
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/File.hpp>
+#include <swirly/util/Math.hpp>
+#include <swirly/util/MemMap.hpp>
+#include <swirly/util/String.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio> // snprintf()
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h> // write()
+
+using namespace std;
+
+namespace swirly {
+namespace {
+
+constexpr char Magic[] = "SWIRLYL";
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pad;
+};
+static_assert(sizeof(Magic) == sizeof(FileHeader::magic), "invalid magic size");
+constexpr uint32_t Version{1};
+
+// The file is a sequence of blocks. A format block precedes the data blocks that refer to it.
+enum : uint32_t { FormatBlock = 1, DataBlock = 2 };
+
+struct BlockHeader {
+    uint32_t type;
+    uint32_t len;
+};
+
+struct FormatHeader {
+    uint32_t id;
+    int32_t level;
+    int32_t line;
+    uint32_t fileLen;
+    uint32_t textLen;
+};
+
+struct DataHeader {
+    uint32_t tid;
+    uint32_t pad;
+};
+
+// Records are packed without alignment, so they are always accessed with memcpy.
+struct RecordHeader {
+    uint16_t size;
+    uint16_t pad;
+    uint32_t id;
+    int64_t time;
+};
+
+constexpr Millis FlushInterval{10};
+
+struct Format {
+    int level;
+    const char* file;
+    int line;
+    const char* text;
+};
+
+/**
+ * Each thread writes to its own buffer, so that call-sites do not contend. The buffer is drained by
+ * the background thread.
+ */
+struct Buffer {
+    Buffer(uint32_t tid, size_t n) : tid{tid}, capacity{nextPow2(n)}, mask{capacity - 1}
+    {
+        data.reset(new char[capacity]);
+    }
+    const uint32_t tid;
+    const size_t capacity;
+    const size_t mask;
+    unique_ptr<char[]> data;
+    atomic<uint64_t> drops{0};
+    alignas(64) atomic<uint64_t> wpos{0};
+    alignas(64) atomic<uint64_t> rpos{0};
+};
+using BufferPtr = shared_ptr<Buffer>;
+
+struct Registry {
+    mutex regMutex;
+    condition_variable cond;
+    // Buffers outlive their threads, so that records can be written after threads exit.
+    vector<BufferPtr> buffers;
+    vector<Format> formats;
+    size_t formatsWritten{0};
+    File file;
+    thread worker;
+    bool stop{false};
+};
+
+Registry& registry() noexcept
+{
+    // Intentionally leaked, so that the registry outlives thread-local buffers.
+    static auto* registry = new Registry;
+    return *registry;
+}
+
+atomic<bool> enabled_{false};
+atomic<size_t> capacity_{0};
+
+Buffer& buffer()
+{
+    static thread_local BufferPtr buffer;
+    if (!buffer) {
+        static atomic<uint32_t> nextTid{0};
+        buffer = make_shared<Buffer>(++nextTid, capacity_.load(memory_order_relaxed));
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.regMutex};
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void writeAll(int fd, const void* data, size_t len)
+{
+    const auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        const auto ret = ::write(fd, p, len);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error{errno, system_category(), "write failed"};
+        }
+        p += ret;
+        len -= ret;
+    }
+}
+
+template <typename ValueT>
+void append(string& out, const ValueT& val)
+{
+    out.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+/**
+ * Move pending records from the thread buffers to the file.
+ */
+void drain(Registry& reg)
+{
+    vector<BufferPtr> buffers;
+    {
+        lock_guard<mutex> lock{reg.regMutex};
+        buffers = reg.buffers;
+    }
+    string data;
+    for (const auto& buf : buffers) {
+        const auto wpos = buf->wpos.load(memory_order_acquire);
+        const auto rpos = buf->rpos.load(memory_order_relaxed);
+        if (wpos == rpos) {
+            continue;
+        }
+        const auto len = wpos - rpos;
+        append(data, BlockHeader{DataBlock, static_cast<uint32_t>(sizeof(DataHeader) + len)});
+        append(data, DataHeader{buf->tid, 0});
+        const auto off = rpos & buf->mask;
+        const auto first = min(len, buf->capacity - off);
+        data.append(buf->data.get() + off, first);
+        data.append(buf->data.get(), len - first);
+        buf->rpos.store(wpos, memory_order_release);
+    }
+    // Formats are collected after the records, so that every record follows its format.
+    string formats;
+    {
+        lock_guard<mutex> lock{reg.regMutex};
+        for (; reg.formatsWritten < reg.formats.size(); ++reg.formatsWritten) {
+            const auto& fmt = reg.formats[reg.formatsWritten];
+            FormatHeader header;
+            header.id = reg.formatsWritten;
+            header.level = fmt.level;
+            header.line = fmt.line;
+            header.fileLen = strlen(fmt.file);
+            header.textLen = strlen(fmt.text);
+            append(formats, BlockHeader{FormatBlock, static_cast<uint32_t>(
+                                                         sizeof(header) + header.fileLen
+                                                         + header.textLen)});
+            append(formats, header);
+            formats.append(fmt.file, header.fileLen);
+            formats.append(fmt.text, header.textLen);
+        }
+    }
+    const auto fd = reg.file.get().get();
+    writeAll(fd, formats.data(), formats.size());
+    writeAll(fd, data.data(), data.size());
+}
+
+void run(Registry& reg) noexcept
+{
+    try {
+        unique_lock<mutex> lock{reg.regMutex};
+        while (!reg.stop) {
+            reg.cond.wait_for(lock, FlushInterval);
+            lock.unlock();
+            drain(reg);
+            lock.lock();
+        }
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR(logMsg() << "binary log failed: " << e.what());
+    }
+}
+
+void format(string& out, string_view text, const char* args, const char* end)
+{
+    char buf[32];
+    for (size_t i{0}; i < text.size(); ++i) {
+        if (text[i] != '{' || i + 1 == text.size() || text[i + 1] != '}') {
+            out += text[i];
+            continue;
+        }
+        ++i;
+        if (args >= end) {
+            out += "{}";
+            continue;
+        }
+        const char tag{*args++};
+        if (tag == 's') {
+            uint16_t len;
+            memcpy(&len, args, sizeof(len));
+            out.append(args + sizeof(len), len);
+            args += sizeof(len) + len;
+            continue;
+        }
+        switch (tag) {
+        case 'i': {
+            int64_t val;
+            memcpy(&val, args, sizeof(val));
+            out.append(buf, snprintf(buf, sizeof(buf), "%jd", static_cast<intmax_t>(val)));
+        } break;
+        case 'u': {
+            uint64_t val;
+            memcpy(&val, args, sizeof(val));
+            out.append(buf, snprintf(buf, sizeof(buf), "%ju", static_cast<uintmax_t>(val)));
+        } break;
+        case 'd': {
+            double val;
+            memcpy(&val, args, sizeof(val));
+            out.append(buf, snprintf(buf, sizeof(buf), "%g", val));
+        } break;
+        default:
+            throw Exception{errMsg() << "invalid binary log argument: " << tag};
+        }
+        args += sizeof(int64_t);
+    }
+}
+
+} // anonymous
+
+namespace detail {
+
+void BinLogEncoder::putString(string_view val) noexcept
+{
+    if (len_ + 1 + sizeof(uint16_t) <= size_) {
+        const uint16_t len = min(val.size(), size_ - len_ - 1 - sizeof(uint16_t));
+        buf_[len_] = 's';
+        memcpy(buf_ + len_ + 1, &len, sizeof(len));
+        memcpy(buf_ + len_ + 1 + sizeof(len), val.data(), len);
+        len_ += 1 + sizeof(len) + len;
+    }
+}
+
+void writeBinLog(uint32_t id, const char* args, size_t len) noexcept
+{
+    try {
+        auto& buf = buffer();
+        RecordHeader header;
+        header.size = sizeof(header) + len;
+        header.pad = 0;
+        header.id = id;
+        header.time = nsSinceEpoch(UnixClock::now());
+
+        const auto wpos = buf.wpos.load(memory_order_relaxed);
+        const auto rpos = buf.rpos.load(memory_order_acquire);
+        if (buf.capacity - (wpos - rpos) < header.size) {
+            singleWriterAdd(buf.drops, 1);
+            return;
+        }
+        const auto copy = [&buf](uint64_t pos, const void* data, size_t n) {
+            const auto off = pos & buf.mask;
+            const auto first = min(n, buf.capacity - off);
+            memcpy(buf.data.get() + off, data, first);
+            memcpy(buf.data.get(), static_cast<const char*>(data) + first, n - first);
+        };
+        copy(wpos, &header, sizeof(header));
+        if (len > 0) {
+            copy(wpos + sizeof(header), args, len);
+        }
+        buf.wpos.store(wpos + header.size, memory_order_release);
+    } catch (const std::bad_alloc&) {
+        // Binary logging is best effort.
+    }
+}
+
+} // detail
+
+bool isBinLogEnabled() noexcept
+{
+    return enabled_.load(memory_order_acquire);
+}
+
+void startBinLog(const char* path, size_t capacity)
+{
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.regMutex};
+    if (reg.file) {
+        throw Exception{"binary log already started"_sv};
+    }
+    auto file = openFile(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    FileHeader header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.pad = 0;
+    writeAll(file.get().get(), &header, sizeof(header));
+
+    reg.file = move(file);
+    reg.formatsWritten = 0;
+    reg.stop = false;
+    reg.worker = thread{run, ref(reg)};
+    capacity_.store(max<size_t>(capacity, MaxBinLogRecord), memory_order_relaxed);
+    enabled_.store(true, memory_order_release);
+}
+
+void stopBinLog() noexcept
+{
+    auto& reg = registry();
+    {
+        lock_guard<mutex> lock{reg.regMutex};
+        if (!reg.file) {
+            return;
+        }
+        enabled_.store(false, memory_order_release);
+        reg.stop = true;
+    }
+    reg.cond.notify_one();
+    reg.worker.join();
+    try {
+        drain(reg);
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR(logMsg() << "binary log failed: " << e.what());
+    }
+    lock_guard<mutex> lock{reg.regMutex};
+    reg.file = nullptr;
+}
+
+uint64_t binLogDrops() noexcept
+{
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.regMutex};
+    uint64_t drops{0};
+    for (const auto& buf : reg.buffers) {
+        drops += buf->drops.load(memory_order_relaxed);
+    }
+    return drops;
+}
+
+uint32_t registerBinLog(int level, const char* file, int line, const char* format)
+{
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.regMutex};
+    reg.formats.push_back({level, file, line, format});
+    return reg.formats.size() - 1;
+}
+
+void readBinLog(const char* path,
+                const function<void(uint32_t tid, int level, Time time, string_view msg)>& fn)
+{
+    const auto file = openFile(path, O_RDONLY);
+    const auto len = size(file.get());
+    if (len < sizeof(FileHeader)) {
+        throw Exception{errMsg() << "invalid binary log: " << path};
+    }
+    const auto memMap = openMemMap(nullptr, len, PROT_READ, MAP_SHARED, file.get(), 0);
+    const auto* const first = static_cast<const char*>(memMap.get().data());
+    const auto* const last = first + len;
+
+    FileHeader header;
+    memcpy(&header, first, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) {
+        throw Exception{errMsg() << "invalid binary log: " << path};
+    }
+    struct Site {
+        int level;
+        string_view text;
+    };
+    vector<Site> sites;
+    string msg;
+    // A trailing block may be incomplete if the process did not stop cleanly.
+    for (const auto* it = first + sizeof(header); last - it >= ptrdiff_t(sizeof(BlockHeader));) {
+        BlockHeader block;
+        memcpy(&block, it, sizeof(block));
+        it += sizeof(block);
+        if (last - it < ptrdiff_t(block.len)) {
+            break;
+        }
+        const auto* const end = it + block.len;
+        if (block.type == FormatBlock) {
+            FormatHeader fmt;
+            memcpy(&fmt, it, sizeof(fmt));
+            if (fmt.id >= sites.size()) {
+                sites.resize(fmt.id + 1);
+            }
+            sites[fmt.id] = {fmt.level, {it + sizeof(fmt) + fmt.fileLen, fmt.textLen}};
+        } else if (block.type == DataBlock) {
+            DataHeader data;
+            memcpy(&data, it, sizeof(data));
+            for (const auto* rec = it + sizeof(data); rec < end;) {
+                RecordHeader rh;
+                memcpy(&rh, rec, sizeof(rh));
+                if (rh.id >= sites.size() || rh.size < sizeof(rh) || end - rec < rh.size) {
+                    throw Exception{errMsg() << "invalid binary log: " << path};
+                }
+                msg.clear();
+                format(msg, sites[rh.id].text, rec + sizeof(rh), rec + rh.size);
+                fn(data.tid, sites[rh.id].level, toTime(Nanos{rh.time}), msg);
+                rec += rh.size;
+            }
+        }
+        it = end;
+    }
+}
+
+} // swirly
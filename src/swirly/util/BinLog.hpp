@@ -0,0 +1,215 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UTIL_BINLOG_HPP
+#define SWIRLY_UTIL_BINLOG_HPP
+
+#include <swirly/util/IntWrapper.hpp>
+#include <swirly/util/Log.hpp>
+#include <swirly/util/Symbol.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+namespace swirly {
+
+/**
+ * Maximum size of an encoded binary log record. Arguments that do not fit are truncated.
+ */
+constexpr std::size_t MaxBinLogRecord{1 << 10};
+
+/**
+ * Binary logging is disabled by default. When disabled, call-sites cost a single branch.
+ */
+SWIRLY_API bool isBinLogEnabled() noexcept;
+
+/**
+ * Return true if binary logging is enabled and level is less than or equal to current log level.
+ */
+inline bool isBinLogLevel(int level) noexcept
+{
+    return isBinLogEnabled() && isLogLevel(level);
+}
+
+/**
+ * Open binary log file and start the background thread that drains per-thread buffers to the file.
+ * Each thread is given a buffer of the specified capacity in bytes. Records are dropped when a
+ * buffer is full.
+ */
+SWIRLY_API void startBinLog(const char* path, std::size_t capacity = 1 << 20);
+
+/**
+ * Write pending records and close the binary log file.
+ */
+SWIRLY_API void stopBinLog() noexcept;
+
+/**
+ * Return the number of records dropped, because a per-thread buffer was full.
+ */
+SWIRLY_API std::uint64_t binLogDrops() noexcept;
+
+/**
+ * Register a call-site. This is called once per call-site by the SWIRLY_BINLOG macro.
+ *
+ * @return the format id.
+ */
+SWIRLY_API std::uint32_t registerBinLog(int level, const char* file, int line,
+                                        const char* format);
+
+/**
+ * Read records from a file written by the binary logger. Each "{}" placeholder in the format is
+ * replaced by the corresponding argument.
+ */
+SWIRLY_API void readBinLog(
+    const char* path,
+    const std::function<void(std::uint32_t tid, int level, Time time, std::string_view msg)>& fn);
+
+namespace detail {
+
+/**
+ * Encodes tagged arguments into a fixed-size record buffer.
+ */
+class SWIRLY_API BinLogEncoder {
+  public:
+    BinLogEncoder(char* buf, std::size_t size) noexcept : buf_{buf}, size_{size} {}
+
+    std::size_t size() const noexcept { return len_; }
+
+    void putInt(std::int64_t val) noexcept { putScalar('i', &val, sizeof(val)); }
+    void putUint(std::uint64_t val) noexcept { putScalar('u', &val, sizeof(val)); }
+    void putDouble(double val) noexcept { putScalar('d', &val, sizeof(val)); }
+    void putString(std::string_view val) noexcept;
+
+  private:
+    void putScalar(char tag, const void* val, std::size_t len) noexcept
+    {
+        if (len_ + 1 + len <= size_) {
+            buf_[len_] = tag;
+            std::memcpy(buf_ + len_ + 1, val, len);
+            len_ += 1 + len;
+        }
+    }
+
+    char* const buf_;
+    const std::size_t size_;
+    std::size_t len_{0};
+};
+
+template <typename ValueT, typename std::enable_if_t<std::is_integral<ValueT>::value>* = nullptr>
+inline void encode(BinLogEncoder& enc, ValueT val) noexcept
+{
+    if (std::is_signed<ValueT>::value) {
+        enc.putInt(val);
+    } else {
+        enc.putUint(val);
+    }
+}
+
+template <typename ValueT,
+          typename std::enable_if_t<std::is_floating_point<ValueT>::value>* = nullptr>
+inline void encode(BinLogEncoder& enc, ValueT val) noexcept
+{
+    enc.putDouble(val);
+}
+
+// Enums are recorded by name, so that the decoder does not need to know the enum.
+template <typename ValueT, typename std::enable_if_t<std::is_enum<ValueT>::value>* = nullptr>
+inline void encode(BinLogEncoder& enc, ValueT val) noexcept
+{
+    enc.putString(enumString(val));
+}
+
+template <typename PolicyT>
+inline void encode(BinLogEncoder& enc, IntWrapper<PolicyT> val) noexcept
+{
+    enc.putInt(val.count());
+}
+
+inline void encode(BinLogEncoder& enc, std::string_view val) noexcept
+{
+    enc.putString(val);
+}
+
+inline void encode(BinLogEncoder& enc, const char* val) noexcept
+{
+    enc.putString(val);
+}
+
+inline void encode(BinLogEncoder& enc, const std::string& val) noexcept
+{
+    enc.putString(val);
+}
+
+inline void encode(BinLogEncoder& enc, const Symbol& val) noexcept
+{
+    enc.putString({val.data(), val.size()});
+}
+
+inline void encodeAll(BinLogEncoder& enc) noexcept
+{
+}
+
+template <typename ArgT, typename... ArgsT>
+inline void encodeAll(BinLogEncoder& enc, const ArgT& arg, const ArgsT&... args) noexcept
+{
+    encode(enc, arg);
+    encodeAll(enc, args...);
+}
+
+/**
+ * Copy an encoded record into the calling thread's buffer.
+ */
+SWIRLY_API void writeBinLog(std::uint32_t id, const char* args, std::size_t len) noexcept;
+
+} // detail
+
+/**
+ * Record a binary log message. The arguments are copied into the calling thread's buffer, and are
+ * only formatted when the log is read.
+ */
+inline void writeBinLog(std::uint32_t id) noexcept
+{
+    detail::writeBinLog(id, nullptr, 0);
+}
+
+template <typename... ArgsT>
+void writeBinLog(std::uint32_t id, const ArgsT&... args) noexcept
+{
+    char buf[MaxBinLogRecord];
+    detail::BinLogEncoder enc{buf, sizeof(buf)};
+    detail::encodeAll(enc, args...);
+    detail::writeBinLog(id, buf, enc.size());
+}
+
+} // swirly
+
+// The format must be a string literal. Each call-site is registered once, and subsequent calls only
+// record the format id and the raw argument values.
+// SWIRLY_BINLOG(LogInfo, "exec: id={},lots={}", exec.id(), exec.lots());
+
+#define SWIRLY_BINLOG(level, format, ...)                                                          \
+    do {                                                                                           \
+        if (swirly::isBinLogLevel(level)) {                                                        \
+            static const std::uint32_t swirlyBinLogId{                                             \
+                swirly::registerBinLog(level, __FILE__, __LINE__, format)};                        \
+            swirly::writeBinLog(swirlyBinLogId, ##__VA_ARGS__);                                    \
+        }                                                                                          \
+    } while (false)
+
+#endif // SWIRLY_UTIL_BINLOG_HPP
@@ -0,0 +1,93 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "BinLog.hpp"
+
+#include <swirly/util/String.hpp>
+
+#include <swirly/unit/Test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdlib> // mkstemp()
+
+#include <unistd.h> // unlink()
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+enum class Colour { Red, Green };
+
+const char* enumString(Colour colour) noexcept
+{
+    return colour == Colour::Red ? "RED" : "GREEN";
+}
+
+using Lots = IntWrapper<Int64Policy>;
+
+struct Entry {
+    uint32_t tid;
+    int level;
+    string msg;
+};
+
+} // anonymous
+
+SWIRLY_TEST_CASE(BinLog)
+{
+    // Disabled by default.
+    SWIRLY_CHECK(!isBinLogEnabled());
+    SWIRLY_BINLOG(LogInfo, "disabled: {}", 1);
+
+    char path[] = "/tmp/swirlyXXXXXX";
+    close(mkstemp(path));
+
+    startBinLog(path, 1 << 12);
+    SWIRLY_CHECK(isBinLogEnabled());
+    for (int i{0}; i < 2; ++i) {
+        SWIRLY_BINLOG(LogInfo, "test: int={},uint={},dbl={},str={},enum={},wrap={}", -i, 2u, 1.5,
+                      "foo", Colour::Green, Lots{10});
+    }
+    thread{[]() {
+        SWIRLY_BINLOG(LogWarning, "thread: {} {} {}", string{"bar"}, Symbol{"baz"}, "x"_sv);
+        // Missing arguments are left as placeholders.
+        SWIRLY_BINLOG(LogWarning, "missing: {}");
+    }}.join();
+    // Filtered by log level.
+    SWIRLY_BINLOG(LogDebug, "debug: {}", 1);
+    stopBinLog();
+    SWIRLY_CHECK(!isBinLogEnabled());
+    SWIRLY_CHECK(binLogDrops() == 0);
+
+    vector<Entry> entries;
+    readBinLog(path, [&entries](uint32_t tid, int level, Time time, string_view msg) {
+        entries.push_back({tid, level, string{msg.data(), msg.size()}});
+    });
+    unlink(path);
+
+    SWIRLY_CHECK(entries.size() == 4);
+    SWIRLY_CHECK(entries[0].level == LogInfo);
+    SWIRLY_CHECK(entries[0].msg == "test: int=0,uint=2,dbl=1.5,str=foo,enum=GREEN,wrap=10");
+    SWIRLY_CHECK(entries[1].msg == "test: int=-1,uint=2,dbl=1.5,str=foo,enum=GREEN,wrap=10");
+    SWIRLY_CHECK(entries[2].tid != entries[0].tid);
+    SWIRLY_CHECK(entries[2].level == LogWarning);
+    SWIRLY_CHECK(entries[2].msg == "thread: bar baz x");
+    SWIRLY_CHECK(entries[3].msg == "missing: {}");
+}
@@ -60,6 +60,15 @@ void resize(FileHandle h, size_t size)
     }
 }
 
+void reserve(FileHandle h, size_t size)
+{
+    // Returns an error number instead of setting errno.
+    const int err{posix_fallocate(h.get(), 0, size)};
+    if (err != 0) {
+        throw system_error{err, system_category(), "posix_fallocate failed"};
+    }
+}
+
 size_t size(FileHandle h)
 {
     struct stat st;
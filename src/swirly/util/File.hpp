@@ -23,6 +23,8 @@
 #include <cstddef> // nullptr_t
 #include <memory>
 
+#include <sys/types.h> // mode_t
+
 namespace swirly {
 
 /**
@@ -63,6 +65,13 @@ SWIRLY_API File openFile(const char* path, int flags);
 
 SWIRLY_API void resize(FileHandle h, std::size_t size);
 
+/**
+ * Allocate disk space for the first size bytes of the file, extending the file if necessary.
+ * Unlike resize(), this guarantees that subsequent writes to the range will not fail for lack of
+ * space.
+ */
+SWIRLY_API void reserve(FileHandle h, std::size_t size);
+
 SWIRLY_API std::size_t size(FileHandle h);
 
 } // swirly
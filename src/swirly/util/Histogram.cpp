@@ -0,0 +1,90 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace swirly {
+
+Histogram::~Histogram() noexcept = default;
+
+uint64_t Histogram::valueAt(double pctile) const noexcept
+{
+    if (count_ == 0) {
+        return 0;
+    }
+    pctile = std::min(std::max(pctile, 0.0), 100.0);
+    // The rank of the observation at the percentile, which is at least one.
+    const auto rank = std::max<uint64_t>(llround(ceil(pctile / 100.0 * count_)), 1);
+    uint64_t n{0};
+    for (size_t i{0}; i < Buckets; ++i) {
+        n += counts_[i];
+        if (n >= rank) {
+            // The last bucket also holds values that were clamped.
+            return i + 1 < Buckets ? std::min(std::max(highest(i), min_), max_) : max_;
+        }
+    }
+    return max_;
+}
+
+uint64_t Histogram::countAtOrBelow(uint64_t val) const noexcept
+{
+    if (val >= max_) {
+        return count_;
+    }
+    uint64_t n{0};
+    for (size_t i{0}, last{index(val)}; i <= last; ++i) {
+        n += counts_[i];
+    }
+    return n;
+}
+
+void Histogram::reset() noexcept
+{
+    count_ = 0;
+    sum_ = 0;
+    min_ = numeric_limits<uint64_t>::max();
+    max_ = 0;
+    memset(counts_, 0, sizeof(counts_));
+}
+
+void Histogram::merge(const Histogram& rhs) noexcept
+{
+    if (rhs.count_ == 0) {
+        return;
+    }
+    for (size_t i{0}; i < Buckets; ++i) {
+        counts_[i] += rhs.counts_[i];
+    }
+    count_ += rhs.count_;
+    sum_ += rhs.sum_;
+    min_ = std::min(min_, rhs.min_);
+    max_ = std::max(max_, rhs.max_);
+}
+
+void Histogram::snapshot(Histogram& interval) noexcept
+{
+    interval = *this;
+    reset();
+}
+
+} // swirly
@@ -0,0 +1,136 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UTIL_HISTOGRAM_HPP
+#define SWIRLY_UTIL_HISTOGRAM_HPP
+
+#include <swirly/util/Defs.hpp>
+
+#include <cstdint>
+
+namespace swirly {
+
+/**
+ * A log-linear histogram of non-negative integer observations, in the style of HdrHistogram.
+ *
+ * Values below SubBuckets are counted exactly. Larger values fall into buckets whose width doubles
+ * with each power of two, and each power of two is divided into SubBuckets / 2 linear sub-buckets.
+ * Percentiles are therefore exact to within a relative error of less than 1 / (SubBuckets / 2),
+ * regardless of the shape of the distribution. Values of MaxValue or more are counted in the last
+ * bucket, but the maximum is always exact.
+ */
+class SWIRLY_API Histogram {
+  public:
+    enum : int { SubBucketBits = 8, MaxValueBits = 40 };
+    enum : std::uint64_t {
+        SubBuckets = 1 << SubBucketBits,
+        MaxValue = std::uint64_t{1} << MaxValueBits,
+        Buckets = (MaxValueBits - SubBucketBits + 2) * (SubBuckets / 2)
+    };
+
+    Histogram() noexcept { reset(); }
+    ~Histogram() noexcept;
+
+    // Copy.
+    Histogram(const Histogram& rhs) noexcept = default;
+    Histogram& operator=(const Histogram& rhs) noexcept = default;
+
+    // Move.
+    Histogram(Histogram&&) noexcept = default;
+    Histogram& operator=(Histogram&&) noexcept = default;
+
+    bool empty() const noexcept { return count_ == 0; }
+    /**
+     * @return the number of observations.
+     */
+    std::uint64_t count() const noexcept { return count_; }
+    std::uint64_t min() const noexcept { return count_ > 0 ? min_ : 0; }
+    std::uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept
+    {
+        return count_ > 0 ? static_cast<double>(sum_) / count_ : 0.0;
+    }
+    /**
+     * @return the highest value that is equivalent to the value at the percentile, or zero if the
+     * histogram is empty.
+     *
+     * @param pctile The percentile in the range [0, 100].
+     */
+    std::uint64_t valueAt(double pctile) const noexcept;
+    /**
+     * @return the number of observations that are equivalent to values less than or equal to val.
+     */
+    std::uint64_t countAtOrBelow(std::uint64_t val) const noexcept;
+
+    void reset() noexcept;
+    void record(std::uint64_t val, std::uint64_t count = 1) noexcept
+    {
+        counts_[index(val)] += count;
+        count_ += count;
+        sum_ += val * count;
+        if (val < min_) {
+            min_ = val;
+        }
+        if (val > max_) {
+            max_ = val;
+        }
+    }
+    /**
+     * Add the observations of another histogram to this one.
+     */
+    void merge(const Histogram& rhs) noexcept;
+    /**
+     * Copy the observations to the snapshot and reset. This allows interval histograms to be taken
+     * from a histogram that is recording continuously.
+     */
+    void snapshot(Histogram& interval) noexcept;
+
+  private:
+    static std::size_t index(std::uint64_t val) noexcept
+    {
+        if (val < SubBuckets) {
+            return val;
+        }
+        if (val >= MaxValue) {
+            val = MaxValue - 1;
+        }
+        // The bucket is the number of low-order bits that are discarded.
+        const int bucket{63 - __builtin_clzll(val) - (SubBucketBits - 1)};
+        return (bucket * (SubBuckets / 2)) + (val >> bucket);
+    }
+    /**
+     * @return the highest value that is equivalent to values in the bucket at index.
+     */
+    static std::uint64_t highest(std::size_t i) noexcept
+    {
+        if (i < SubBuckets) {
+            return i;
+        }
+        const int bucket{static_cast<int>(i / (SubBuckets / 2)) - 1};
+        const auto sub = i - bucket * (SubBuckets / 2);
+        return ((sub + 1) << bucket) - 1;
+    }
+
+    std::uint64_t count_;
+    std::uint64_t sum_;
+    std::uint64_t min_;
+    std::uint64_t max_;
+    std::uint64_t counts_[Buckets];
+};
+
+} // swirly
+
+#endif // SWIRLY_UTIL_HISTOGRAM_HPP
@@ -0,0 +1,92 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Histogram.hpp"
+
+#include <swirly/unit/Test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+SWIRLY_TEST_CASE(HistogramExact)
+{
+    Histogram h;
+    SWIRLY_CHECK(h.empty());
+    SWIRLY_CHECK(h.valueAt(99) == 0);
+
+    // Small values are counted exactly.
+    for (uint64_t i{1}; i <= 100; ++i) {
+        h.record(i);
+    }
+    SWIRLY_CHECK(h.count() == 100);
+    SWIRLY_CHECK(h.min() == 1);
+    SWIRLY_CHECK(h.max() == 100);
+    SWIRLY_CHECK(h.mean() == 50.5);
+    SWIRLY_CHECK(h.valueAt(0) == 1);
+    SWIRLY_CHECK(h.valueAt(50) == 50);
+    SWIRLY_CHECK(h.valueAt(99) == 99);
+    SWIRLY_CHECK(h.valueAt(99.9) == 100);
+    SWIRLY_CHECK(h.valueAt(100) == 100);
+    SWIRLY_CHECK(h.countAtOrBelow(0) == 0);
+    SWIRLY_CHECK(h.countAtOrBelow(10) == 10);
+    SWIRLY_CHECK(h.countAtOrBelow(1000) == 100);
+}
+
+SWIRLY_TEST_CASE(HistogramTail)
+{
+    Histogram h;
+
+    // A heavy tail that a normal approximation would badly underestimate.
+    h.record(1000, 990);
+    h.record(1000000, 10);
+    SWIRLY_CHECK(h.valueAt(99) == 1003);
+    SWIRLY_CHECK(h.valueAt(99.9) == 1000000);
+
+    // Relative error is bounded.
+    for (uint64_t val{256}; val < Histogram::MaxValue; val = val * 3 + 1) {
+        Histogram v;
+        v.record(val);
+        v.record(val + 1);
+        const auto p50 = v.valueAt(50);
+        SWIRLY_CHECK(p50 >= val && p50 - val < val / 128);
+    }
+
+    // Values beyond the range are clamped, but the maximum is exact.
+    h.record(Histogram::MaxValue * 2);
+    SWIRLY_CHECK(h.max() == Histogram::MaxValue * 2);
+    SWIRLY_CHECK(h.valueAt(100) == Histogram::MaxValue * 2);
+}
+
+SWIRLY_TEST_CASE(HistogramMerge)
+{
+    Histogram h1, h2;
+    h1.record(10, 2);
+    h2.record(5);
+    h2.record(20);
+
+    h1.merge(h2);
+    SWIRLY_CHECK(h1.count() == 4);
+    SWIRLY_CHECK(h1.min() == 5);
+    SWIRLY_CHECK(h1.max() == 20);
+    SWIRLY_CHECK(h1.valueAt(50) == 10);
+
+    Histogram interval;
+    h1.snapshot(interval);
+    SWIRLY_CHECK(h1.empty());
+    SWIRLY_CHECK(h1.max() == 0);
+    SWIRLY_CHECK(interval.count() == 4);
+    SWIRLY_CHECK(interval.valueAt(100) == 20);
+}
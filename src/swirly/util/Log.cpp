@@ -16,11 +16,16 @@
  */
 #include "Log.hpp"
 
+#include <swirly/util/Math.hpp>
+#include <swirly/util/SpscPipe.hpp>
 #include <swirly/util/Time.hpp>
 
 #include <algorithm> // max()
 #include <atomic>
 #include <cstring> // strlen()
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <syslog.h>
 #include <unistd.h> // getpid()
@@ -40,6 +45,151 @@ atomic<Logger> logger_{stdLogger};
 
 thread_local LogMsg logMsg_;
 
+/**
+ * Formats the log header. The date and time are cached, so that localtime_r and strftime are only
+ * called once per second when the same instance is used for consecutive messages.
+ */
+class LogHead {
+  public:
+    // The following format has an upper-bound of 42 characters:
+    // "%b %d %H:%M:%S.%03d %-7s [%d]: "
+    //
+    // Example:
+    // Mar 14 00:00:00.000 WARNING [0123456789]: msg...
+    // <---------------------------------------->
+    enum : std::size_t { MaxSize = 42 };
+
+    std::size_t format(char* buf, Time now, int level) noexcept
+    {
+        const auto t = UnixClock::to_time_t(now);
+        if (t != t_) {
+            struct tm tm;
+            localtime_r(&t, &tm);
+            len_ = strftime(date_, sizeof(date_), "%b %d %H:%M:%S", &tm);
+            t_ = t;
+        }
+        memcpy(buf, date_, len_);
+        const auto ms = msSinceEpoch(now);
+        return len_ + sprintf(buf + len_, ".%03d %-7s [%d]: ", static_cast<int>(ms % 1000),
+                              logLabel(level), static_cast<int>(getpid()));
+    }
+
+  private:
+    time_t t_{-1};
+    char date_[16];
+    std::size_t len_{0};
+};
+
+// Best effort given that this is the logger.
+inline void writeBestEffort(int fd, const iovec* iov, int iovcnt) noexcept
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+    writev(fd, iov, iovcnt);
+#pragma GCC diagnostic pop
+}
+
+inline int logFd(int level) noexcept
+{
+    return level > LogWarning ? STDOUT_FILENO : STDERR_FILENO;
+}
+
+struct alignas(64) AsyncSlot {
+    // Sequence number used to hand the slot between producers and the consumer.
+    std::atomic<uint64_t> seq;
+    int level;
+    std::uint32_t len;
+    Time time;
+    char msg[MaxLogMsg];
+};
+
+/**
+ * Bounded multi-producer, single-consumer ring buffer. Each slot carries a sequence number, so that
+ * producers only contend on the write position, and the consumer never takes a lock.
+ */
+struct AsyncLog {
+    explicit AsyncLog(std::size_t n) : capacity{nextPow2(n)}, mask{capacity - 1}
+    {
+        slots.reset(new AsyncSlot[capacity]);
+        for (std::size_t i{0}; i < capacity; ++i) {
+            slots[i].seq.store(i, memory_order_relaxed);
+        }
+    }
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr<AsyncSlot[]> slots;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> drops{0};
+    std::thread worker;
+    alignas(64) std::atomic<uint64_t> wpos{0};
+    alignas(64) uint64_t rpos{0};
+    std::atomic<int> waiter{0};
+};
+
+// Maximum number of messages written by a single writev call.
+constexpr std::size_t AsyncBatchSize{64};
+
+// The ring buffer is allocated once and never freed, so that threads which loaded the logger before
+// the background thread was stopped can still write to it safely.
+atomic<AsyncLog*> asyncLog_{nullptr};
+mutex asyncMutex_;
+
+inline bool isReady(const AsyncLog& log, uint64_t pos) noexcept
+{
+    return log.slots[pos & log.mask].seq.load(memory_order_acquire) == pos + 1;
+}
+
+void runAsyncLog(AsyncLog& log) noexcept
+{
+    LogHead head;
+    char heads[AsyncBatchSize][LogHead::MaxSize + 1];
+    iovec iov[AsyncBatchSize * 3];
+    char tail = '\n';
+    for (;;) {
+        // Gather consecutive messages for the same file descriptor.
+        std::size_t n{0};
+        int fd{-1};
+        for (; n < AsyncBatchSize && isReady(log, log.rpos + n); ++n) {
+            const auto& slot = log.slots[(log.rpos + n) & log.mask];
+            if (fd >= 0 && logFd(slot.level) != fd) {
+                break;
+            }
+            fd = logFd(slot.level);
+            iov[n * 3] = {heads[n], head.format(heads[n], slot.time, slot.level)};
+            iov[n * 3 + 1] = {const_cast<char*>(slot.msg), slot.len};
+            iov[n * 3 + 2] = {&tail, 1};
+        }
+        if (n > 0) {
+            writeBestEffort(fd, iov, n * 3);
+            for (std::size_t i{0}; i < n; ++i, ++log.rpos) {
+                log.slots[log.rpos & log.mask].seq.store(log.rpos + log.capacity,
+                                                         memory_order_release);
+            }
+            continue;
+        }
+        if (!log.running.load(memory_order_acquire)) {
+            break;
+        }
+        // Announce the waiter before re-checking, so that either the producer sees the flag or
+        // this thread sees the message.
+        log.waiter.store(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!isReady(log, log.rpos) && log.running.load(memory_order_acquire)) {
+            detail::futexWait(log.waiter, 1);
+        }
+        log.waiter.store(0, memory_order_relaxed);
+    }
+}
+
+void wakeAsyncLog(AsyncLog& log) noexcept
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (log.waiter.load(memory_order_relaxed) != 0) {
+        log.waiter.store(0, memory_order_relaxed);
+        detail::futexWake(log.waiter);
+    }
+}
+
 inline int acquireLevel() noexcept
 {
     return level_.load(memory_order_acquire);
@@ -88,36 +238,15 @@ void nullLogger(int level, string_view msg) noexcept
 
 void stdLogger(int level, string_view msg) noexcept
 {
-    const auto now = UnixClock::now();
-    const auto t = UnixClock::to_time_t(now);
-    const auto ms = msSinceEpoch(now);
-
-    struct tm tm;
-    localtime_r(&t, &tm);
-
-    // The following format has an upper-bound of 42 characters:
-    // "%b %d %H:%M:%S.%03d %-7s [%d]: "
-    //
-    // Example:
-    // Mar 14 00:00:00.000 WARNING [0123456789]: msg...
-    // <---------------------------------------->
-    char head[42 + 1];
-    size_t hlen = strftime(head, sizeof(head), "%b %d %H:%M:%S", &tm);
-    hlen += sprintf(head + hlen, ".%03d %-7s [%d]: ", static_cast<int>(ms % 1000), logLabel(level),
-                    static_cast<int>(getpid()));
+    char head[LogHead::MaxSize + 1];
+    const auto hlen = LogHead{}.format(head, CoarseClock::now(), level);
     char tail = '\n';
     iovec iov[] = {
         {head, hlen}, //
         {const_cast<char*>(msg.data()), msg.size()}, //
         {&tail, 1} //
     };
-
-    int fd{level > LogWarning ? STDOUT_FILENO : STDERR_FILENO};
-// Best effort given that this is the logger.
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-    writev(fd, iov, sizeof(iov) / sizeof(iov[0]));
-#pragma GCC diagnostic pop
+    writeBestEffort(logFd(level), iov, sizeof(iov) / sizeof(iov[0]));
 }
 
 void sysLogger(int level, string_view msg) noexcept
@@ -145,6 +274,72 @@ void sysLogger(int level, string_view msg) noexcept
     syslog(prio, "%.*s", static_cast<int>(msg.size()), msg.data());
 }
 
+void asyncLogger(int level, string_view msg) noexcept
+{
+    auto* const log = asyncLog_.load(memory_order_acquire);
+    if (!log || !log->running.load(memory_order_relaxed)) {
+        stdLogger(level, msg);
+        return;
+    }
+    // Claim a slot.
+    auto pos = log->wpos.load(memory_order_relaxed);
+    AsyncSlot* slot;
+    for (;;) {
+        slot = &log->slots[pos & log->mask];
+        const auto diff = static_cast<int64_t>(slot->seq.load(memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (log->wpos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full.
+            log->drops.fetch_add(1, memory_order_relaxed);
+            return;
+        } else {
+            pos = log->wpos.load(memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    slot->len = min(msg.size(), MaxLogMsg);
+    slot->time = CoarseClock::now();
+    memcpy(slot->msg, msg.data(), slot->len);
+    slot->seq.store(pos + 1, memory_order_release);
+    wakeAsyncLog(*log);
+}
+
+void startAsyncLogger(size_t capacity)
+{
+    lock_guard<mutex> lock{asyncMutex_};
+    auto* log = asyncLog_.load(memory_order_relaxed);
+    if (!log) {
+        log = new AsyncLog{capacity};
+        asyncLog_.store(log, memory_order_release);
+    }
+    if (!log->running.load(memory_order_relaxed)) {
+        log->running.store(true, memory_order_release);
+        log->worker = thread{runAsyncLog, ref(*log)};
+    }
+}
+
+void stopAsyncLogger() noexcept
+{
+    lock_guard<mutex> lock{asyncMutex_};
+    auto* const log = asyncLog_.load(memory_order_relaxed);
+    if (log && log->running.load(memory_order_relaxed)) {
+        log->running.store(false, memory_order_release);
+        atomic_thread_fence(memory_order_seq_cst);
+        log->waiter.store(0, memory_order_relaxed);
+        detail::futexWake(log->waiter);
+        log->worker.join();
+    }
+}
+
+uint64_t asyncLogDrops() noexcept
+{
+    auto* const log = asyncLog_.load(memory_order_acquire);
+    return log ? log->drops.load(memory_order_relaxed) : 0;
+}
+
 LogMsg& logMsg() noexcept
 {
     logMsg_.reset();
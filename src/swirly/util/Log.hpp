@@ -115,6 +115,31 @@ SWIRLY_API void stdLogger(int level, std::string_view msg) noexcept;
  */
 SWIRLY_API void sysLogger(int level, std::string_view msg) noexcept;
 
+/**
+ * Asynchronous logger. This logger copies the message into a lock-free ring buffer and returns
+ * without blocking. A background thread formats the time-stamp and writes messages in batches to
+ * the same file descriptors as the standard logger. Messages are dropped if the ring buffer is
+ * full. The standard logger is used directly if the background thread is not running.
+ */
+SWIRLY_API void asyncLogger(int level, std::string_view msg) noexcept;
+
+/**
+ * Start the background thread used by the asynchronous logger. The ring buffer is allocated by the
+ * first call, and its capacity is rounded up to the next power of two.
+ */
+SWIRLY_API void startAsyncLogger(std::size_t capacity = 1 << 10);
+
+/**
+ * Write pending messages and stop the background thread.
+ */
+SWIRLY_API void stopAsyncLogger() noexcept;
+
+/**
+ * Return the number of messages dropped by the asynchronous logger, because the ring buffer was
+ * full.
+ */
+SWIRLY_API std::uint64_t asyncLogDrops() noexcept;
+
 /**
  * Thread-local log message. This thread-local instance of StringBuilder can be used to format log
  * messages before writing to the log. Note that the StringBuilder is reset each time this function
@@ -17,10 +17,15 @@
 #include "Log.hpp"
 
 #include <swirly/util/Finally.hpp>
+#include <swirly/util/String.hpp>
 
 #include <swirly/unit/Test.hpp>
 
+#include <cstdio>
 #include <cstring>
+#include <thread>
+
+#include <unistd.h>
 
 using namespace std;
 using namespace swirly;
@@ -99,3 +104,46 @@ SWIRLY_TEST_CASE(LogMacro)
     SWIRLY_CHECK(lastLevel == LogInfo);
     SWIRLY_CHECK(lastMsg == "test6: (10,20)");
 }
+
+SWIRLY_TEST_CASE(AsyncLogger)
+{
+    // Redirect stdout to a temporary file.
+    FILE* const file{tmpfile()};
+    SWIRLY_CHECK(file != nullptr);
+    const int prevFd{dup(STDOUT_FILENO)};
+    fflush(stdout);
+    dup2(fileno(file), STDOUT_FILENO);
+    auto finally = makeFinally([file, prevFd]() {
+        dup2(prevFd, STDOUT_FILENO);
+        close(prevFd);
+        fclose(file);
+    });
+
+    startAsyncLogger(1 << 4);
+    thread t{[]() {
+        for (int i{0}; i < 8; ++i) {
+            asyncLogger(LogInfo, "async: thread"_sv);
+        }
+    }};
+    for (int i{0}; i < 8; ++i) {
+        asyncLogger(LogInfo, "async: main"_sv);
+    }
+    t.join();
+    stopAsyncLogger();
+
+    // Falls back to the standard logger when stopped.
+    asyncLogger(LogInfo, "async: stopped"_sv);
+
+    char buf[4096];
+    const auto len = pread(fileno(file), buf, sizeof(buf) - 1, 0);
+    SWIRLY_CHECK(len > 0);
+    buf[len] = '\0';
+
+    int lines{0};
+    for (const char* it{buf}; (it = strstr(it, "async: ")); ++it) {
+        ++lines;
+    }
+    SWIRLY_CHECK(lines + asyncLogDrops() == 17);
+    SWIRLY_CHECK(strstr(buf, " INFO    [") != nullptr);
+    SWIRLY_CHECK(strstr(buf, "async: stopped\n") != nullptr);
+}
@@ -16,10 +16,18 @@
  */
 #include "MemCtx.hpp"
 
+#include "Log.hpp"
 #include "MemMap.hpp"
 #include "MemPool.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
 #include <fcntl.h>
+#include <sys/mman.h>
 
 using namespace std;
 
@@ -33,87 +41,430 @@ File reserveFile(const char* path, size_t size)
     return file;
 }
 
+// Assumption: the default huge page size is 2MiB.
+enum { HugePageBits = 21 };
+
+MemMap openAnonMap(size_t size, const MemOpts& opts)
+{
+    if (opts.hugePages) {
+        try {
+            // The length must be a multiple of the huge page size.
+            return openMemMap(nullptr, ceilPow2<HugePageBits>(size), PROT_READ | PROT_WRITE,
+                              MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+        } catch (const system_error& e) {
+            SWIRLY_WARNING(logMsg() << "huge pages unavailable: " << e.what());
+        }
+    }
+    return openMemMap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+}
+
+void prepareMap(MemMapHandle h, const MemOpts& opts)
+{
+    if (opts.hugePages) {
+        // Transparent huge pages are advisory, so failure is not an error. The advice is redundant
+        // for explicit huge pages.
+        madvise(h.data(), h.size(), MADV_HUGEPAGE);
+    }
+    if (opts.prefault) {
+        // Write each page without changing its contents, because shared maps may already hold data.
+        auto* const data = static_cast<volatile char*>(h.data());
+        for (size_t i{0}; i < h.size(); i += PageSize) {
+            data[i] = data[i];
+        }
+    }
+    if (opts.lock && mlock(h.data(), h.size()) < 0) {
+        throw system_error{errno, system_category(), "mlock failed"};
+    }
+}
+
+// Multiples of the cache-line size up to 384 bytes, followed by powers of two up to the page size.
+enum : size_t { SizeClasses = 10, MagazineSize = 32 };
+
+/**
+ * @return the size class, or SizeClasses if the size is larger than a page.
+ */
+constexpr size_t sizeClass(size_t size) noexcept
+{
+    if (size <= (6 << 6)) {
+        return size == 0 ? 0 : (ceilCacheLine(size) >> CacheLineBits) - 1;
+    }
+    if (size <= (1 << 9)) {
+        return 6;
+    }
+    if (size <= (1 << 10)) {
+        return 7;
+    }
+    if (size <= (1 << 11)) {
+        return 8;
+    }
+    if (size <= PageSize) {
+        return 9;
+    }
+    return SizeClasses;
+}
+static_assert(sizeClass(1) == 0 && sizeClass(6 << 6) == 5 && sizeClass((6 << 6) + 1) == 6);
+static_assert(sizeClass(PageSize) == 9 && sizeClass(PageSize + 1) == SizeClasses);
+
+constexpr size_t ClassSizes[SizeClasses]{1 << 6,  2 << 6,  3 << 6,  4 << 6,  5 << 6,
+                                         6 << 6,  1 << 9,  1 << 10, 1 << 11, PageSize};
+
+/**
+ * Increment a counter that is only written by the calling thread, but may be read by others.
+ */
+inline void incCount(uint64_t& count) noexcept
+{
+    __atomic_store_n(&count, count + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Call fn with the pool's free list for the size class.
+ */
+template <typename FnT>
+auto visitStack(MemPool& pool, size_t cls, FnT fn)
+{
+    switch (cls) {
+    case 0:
+        return fn(pool.free1);
+    case 1:
+        return fn(pool.free2);
+    case 2:
+        return fn(pool.free3);
+    case 3:
+        return fn(pool.free4);
+    case 4:
+        return fn(pool.free5);
+    case 5:
+        return fn(pool.free6);
+    case 6:
+        return fn(pool.free7);
+    case 7:
+        return fn(pool.free8);
+    case 8:
+        return fn(pool.free9);
+    default:
+        return fn(pool.free10);
+    }
+}
+
+enum : size_t { MaxSegments = 64 };
+
+// Warn when the last permitted segment is this full.
+constexpr size_t WatermarkPct{80};
+
+/**
+ * Ids of live contexts. The registry is never destroyed, because thread-local caches may be
+ * destroyed after static objects.
+ */
+struct Registry {
+    mutex idsMutex;
+    vector<uint64_t> ids;
+};
+
+Registry& registry()
+{
+    static auto* registry = new Registry;
+    return *registry;
+}
+
 } // anonymous
 
 struct MemCtx::Impl {
-    explicit Impl(size_t maxSize)
+    /**
+     * Blocks of a single size class cached by a thread.
+     */
+    struct Magazine {
+        size_t size;
+        void* blocks[MagazineSize];
+    };
+
+    /**
+     * Thread-local magazines in front of the shared free lists. The magazines hold blocks from a
+     * single context, which is identified by a unique id, because a context may be destroyed and
+     * another allocated at the same address.
+     */
+    struct Cache {
+        ~Cache() noexcept
+        {
+            auto& reg = registry();
+            lock_guard<mutex> lock{reg.idsMutex};
+            if (find(reg.ids.begin(), reg.ids.end(), id) != reg.ids.end()) {
+                impl->detach(*this);
+            }
+        }
+        uint64_t id;
+        Impl* impl;
+        Magazine mags[SizeClasses];
+        // Counters are written by the owning thread, and aggregated by stats().
+        uint64_t allocs[SizeClasses];
+        uint64_t frees[SizeClasses];
+    };
+
+    /**
+     * Each segment has its own pool header, so that offset links remain 32 bits.
+     */
+    struct Segment {
+        MemMap memMap;
+        MemPool* pool{nullptr};
+    };
+
+    Impl(size_t maxSize, const MemOpts& opts)
         : maxSize{maxSize},
-          memMap{openMemMap(nullptr, PageSize + maxSize, PROT_READ | PROT_WRITE,
-                            MAP_ANON | MAP_PRIVATE, -1, 0)},
-          pool(*static_cast<MemPool*>(memMap.get().data()))
+          // An empty pool cannot grow.
+          maxSegments{maxSize > 0 ? min<size_t>(max<size_t>(opts.maxSegments, 1), MaxSegments) : 1},
+          opts{opts}
     {
+        addSegment(openAnonMap(PageSize + maxSize, opts));
+        enter();
     }
-    Impl(const char* path, size_t maxSize)
+    Impl(const char* path, size_t maxSize, const MemOpts& opts)
         : maxSize{maxSize},
-          file{reserveFile(path, PageSize + maxSize)},
-          memMap{openMemMap(nullptr, PageSize + maxSize, PROT_READ | PROT_WRITE, MAP_SHARED,
-                            file.get(), 0)},
-          pool(*static_cast<MemPool*>(memMap.get().data()))
+          maxSegments{1},
+          opts{opts},
+          file{reserveFile(path, PageSize + maxSize)}
     {
+        // Shared memory-maps do not grow.
+        addSegment(openMemMap(nullptr, PageSize + maxSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                              file.get(), 0));
+        enter();
+    }
+    ~Impl() noexcept
+    {
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.idsMutex};
+        reg.ids.erase(find(reg.ids.begin(), reg.ids.end(), id));
     }
     void* alloc(size_t size)
     {
-        void* addr;
-        switch (ceilCacheLine(size)) {
-        case 1 << 6:
-            addr = allocBlock(pool, pool.free1, maxSize);
-            break;
-        case 2 << 6:
-            addr = allocBlock(pool, pool.free2, maxSize);
-            break;
-        case 3 << 6:
-            addr = allocBlock(pool, pool.free3, maxSize);
-            break;
-        case 4 << 6:
-            addr = allocBlock(pool, pool.free4, maxSize);
-            break;
-        case 5 << 6:
-            addr = allocBlock(pool, pool.free5, maxSize);
-            break;
-        case 6 << 6:
-            addr = allocBlock(pool, pool.free6, maxSize);
-            break;
-        default:
+        const auto cls = sizeClass(size);
+        if (cls == SizeClasses) {
             throw bad_alloc{};
         }
+        auto& cache = this->cache();
+        auto& mag = cache.mags[cls];
+        void* const addr{mag.size > 0 ? mag.blocks[--mag.size] : allocShared(cls)};
+        incCount(cache.allocs[cls]);
         return addr;
     }
     void dealloc(void* addr, size_t size) noexcept
     {
-        switch (ceilCacheLine(size)) {
-        case 1 << 6:
-            deallocBlock(pool, pool.free1, addr);
-            break;
-        case 2 << 6:
-            deallocBlock(pool, pool.free2, addr);
-            break;
-        case 3 << 6:
-            deallocBlock(pool, pool.free3, addr);
-            break;
-        case 4 << 6:
-            deallocBlock(pool, pool.free4, addr);
-            break;
-        case 5 << 6:
-            deallocBlock(pool, pool.free5, addr);
-            break;
-        case 6 << 6:
-            deallocBlock(pool, pool.free6, addr);
-            break;
-        default:
+        const auto cls = sizeClass(size);
+        if (cls == SizeClasses) {
             abort();
         }
+        auto& cache = this->cache();
+        incCount(cache.frees[cls]);
+        auto& mag = cache.mags[cls];
+        if (mag.size == MagazineSize) {
+            // Return half of the magazine to the shared free list.
+            while (mag.size > MagazineSize / 2) {
+                deallocShared(cls, mag.blocks[--mag.size]);
+            }
+        }
+        mag.blocks[mag.size++] = addr;
+    }
+    void* allocShared(size_t cls)
+    {
+        const auto n = segments.load(memory_order_acquire);
+        // Reuse free blocks from any segment before reserving new ones.
+        for (size_t i{0}; i < n; ++i) {
+            auto& pool = *segs[i].pool;
+            void* const addr{visitStack(pool, cls, [&pool](auto& stack) -> void* {
+                return pop(pool, stack);
+            })};
+            if (addr) {
+                shared[cls].fetch_sub(1, memory_order_relaxed);
+                return addr;
+            }
+        }
+        // New blocks are only reserved from the last segment.
+        for (auto i = n - 1;;) {
+            auto& pool = *segs[i].pool;
+            try {
+                void* const addr{visitStack(pool, cls, [this, &pool](auto& stack) {
+                    return reserveBlock(pool, stack, this->maxSize);
+                })};
+                reserved[cls].fetch_add(1, memory_order_relaxed);
+                if (i + 1 == maxSegments) {
+                    checkWatermark(pool);
+                }
+                return addr;
+            } catch (const bad_alloc&) {
+                i = grow(i);
+            }
+        }
+    }
+    void deallocShared(size_t cls, void* addr) noexcept
+    {
+        auto& pool = owner(addr);
+        shared[cls].fetch_add(1, memory_order_relaxed);
+        visitStack(pool, cls, [&pool, addr](auto& stack) { deallocBlock(pool, stack, addr); });
+    }
+    /**
+     * @return the pool of the segment containing addr.
+     */
+    MemPool& owner(void* addr) noexcept
+    {
+        const auto n = segments.load(memory_order_acquire);
+        for (size_t i{0}; i < n; ++i) {
+            auto& pool = *segs[i].pool;
+            if (addr >= &pool.storage[0] && addr < &pool.storage[maxSize]) {
+                return pool;
+            }
+        }
+        abort();
     }
+    void addSegment(MemMap memMap)
+    {
+        prepareMap(memMap.get(), opts);
+        const auto n = segments.load(memory_order_relaxed);
+        auto& seg = segs[n];
+        seg.pool = static_cast<MemPool*>(memMap.get().data());
+        seg.memMap = move(memMap);
+        // Publish the segment to other threads.
+        segments.store(n + 1, memory_order_release);
+    }
+    /**
+     * Map a new segment, unless another thread has already done so.
+     *
+     * @return the index of the last segment.
+     */
+    size_t grow(size_t last)
+    {
+        lock_guard<mutex> lock{growMutex};
+        const auto n = segments.load(memory_order_relaxed);
+        if (last + 1 == n) {
+            if (n == maxSegments) {
+                throw bad_alloc{};
+            }
+            addSegment(openAnonMap(PageSize + maxSize, opts));
+            SWIRLY_WARNING(logMsg() << "memory pool grew to " << n + 1 << " of " << maxSegments
+                                    << " segments of " << (maxSize >> 10) << "KiB");
+        }
+        return segments.load(memory_order_relaxed) - 1;
+    }
+    void checkWatermark(MemPool& pool) noexcept
+    {
+        MemSize offset;
+        __atomic_load(&pool.offset, &offset, __ATOMIC_RELAXED);
+        if (offset * 100 > maxSize * WatermarkPct && !watermark.exchange(true)) {
+            SWIRLY_WARNING(logMsg() << "memory pool above " << WatermarkPct << "% of capacity");
+        }
+    }
+    void enter()
+    {
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.idsMutex};
+        reg.ids.push_back(id);
+    }
+    /**
+     * Return all cached blocks to the shared free lists.
+     */
+    void flush(Cache& cache) noexcept
+    {
+        for (size_t cls{0}; cls < SizeClasses; ++cls) {
+            auto& mag = cache.mags[cls];
+            while (mag.size > 0) {
+                deallocShared(cls, mag.blocks[--mag.size]);
+            }
+        }
+    }
+    /**
+     * @return the calling thread's cache, after detaching it from any other context.
+     */
+    Cache& cache() noexcept
+    {
+        static thread_local Cache cache{};
+        if (cache.id != id) {
+            auto& reg = registry();
+            lock_guard<mutex> lock{reg.idsMutex};
+            if (find(reg.ids.begin(), reg.ids.end(), cache.id) != reg.ids.end()) {
+                cache.impl->detach(cache);
+            } else {
+                // The blocks belong to a context that no longer exists.
+                for (size_t cls{0}; cls < SizeClasses; ++cls) {
+                    cache.mags[cls].size = 0;
+                    cache.allocs[cls] = 0;
+                    cache.frees[cls] = 0;
+                }
+            }
+            cache.id = id;
+            cache.impl = this;
+            caches.push_back(&cache);
+        }
+        return cache;
+    }
+    /**
+     * Flush the cache and retire its counters. The registry lock must be held.
+     */
+    void detach(Cache& cache) noexcept
+    {
+        flush(cache);
+        for (size_t cls{0}; cls < SizeClasses; ++cls) {
+            retiredAllocs[cls] += cache.allocs[cls];
+            retiredFrees[cls] += cache.frees[cls];
+            cache.allocs[cls] = 0;
+            cache.frees[cls] = 0;
+        }
+        caches.erase(find(caches.begin(), caches.end(), &cache));
+    }
+    MemStats stats()
+    {
+        MemStats stats;
+        stats.segmentSize = maxSize;
+        stats.segments = segments.load(memory_order_acquire);
+        stats.maxSegments = maxSegments;
+        stats.reserved = 0;
+        for (size_t i{0}; i < stats.segments; ++i) {
+            MemSize offset;
+            __atomic_load(&segs[i].pool->offset, &offset, __ATOMIC_RELAXED);
+            stats.reserved += offset;
+        }
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.idsMutex};
+        for (size_t cls{0}; cls < SizeClasses; ++cls) {
+            MemClassStats cs;
+            cs.blockSize = ClassSizes[cls];
+            cs.allocs = retiredAllocs[cls];
+            cs.frees = retiredFrees[cls];
+            for (const auto* cache : caches) {
+                cs.allocs += __atomic_load_n(&cache->allocs[cls], __ATOMIC_RELAXED);
+                cs.frees += __atomic_load_n(&cache->frees[cls], __ATOMIC_RELAXED);
+            }
+            cs.reserved = reserved[cls].load(memory_order_relaxed);
+            cs.free = shared[cls].load(memory_order_relaxed);
+            stats.classes.push_back(cs);
+        }
+        return stats;
+    }
+    static atomic<uint64_t> nextId;
+    // Zero is reserved for caches that do not belong to any context.
+    const uint64_t id{++nextId};
     const size_t maxSize;
+    const size_t maxSegments;
+    const MemOpts opts;
     File file;
-    MemMap memMap;
-    MemPool& pool;
+    mutex growMutex;
+    atomic<size_t> segments{0};
+    atomic<bool> watermark{false};
+    Segment segs[MaxSegments];
+    // Blocks reserved from segments, and blocks on the shared free lists, by size class.
+    atomic<uint64_t> reserved[SizeClasses]{};
+    atomic<uint64_t> shared[SizeClasses]{};
+    // Caches attached to this context, and the counters of detached caches. These are guarded by
+    // the registry lock.
+    vector<Cache*> caches;
+    uint64_t retiredAllocs[SizeClasses]{};
+    uint64_t retiredFrees[SizeClasses]{};
 };
 
-MemCtx::MemCtx(size_t maxSize) : impl_{make_unique<Impl>(maxSize)}
+atomic<uint64_t> MemCtx::Impl::nextId{0};
+
+MemCtx::MemCtx(size_t maxSize, const MemOpts& opts) : impl_{make_unique<Impl>(maxSize, opts)}
 {
 }
 
-MemCtx::MemCtx(const char* path, size_t maxSize) : impl_{make_unique<Impl>(path, maxSize)}
+MemCtx::MemCtx(const char* path, size_t maxSize, const MemOpts& opts)
+    : impl_{make_unique<Impl>(path, maxSize, opts)}
 {
 }
 
@@ -125,6 +476,39 @@ MemCtx::~MemCtx() noexcept = default;
 MemCtx::MemCtx(MemCtx&&) noexcept = default;
 MemCtx& MemCtx::operator=(MemCtx&&) noexcept = default;
 
+MemStats MemCtx::stats() const
+{
+    assert(impl_);
+    return impl_->stats();
+}
+
+void MemStats::toJson(ostream& os) const
+{
+    os << "{\"segmentSize\":" << segmentSize //
+       << ",\"segments\":" << segments //
+       << ",\"maxSegments\":" << maxSegments //
+       << ",\"reserved\":" << reserved //
+       << ",\"classes\":[";
+    for (size_t i{0}; i < classes.size(); ++i) {
+        const auto& cs = classes[i];
+        // Counters are read at slightly different times, so derived values may be transiently
+        // inconsistent.
+        const auto inUse = static_cast<int64_t>(cs.allocs - cs.frees);
+        if (i > 0) {
+            os << ',';
+        }
+        os << "{\"blockSize\":" << cs.blockSize //
+           << ",\"allocs\":" << cs.allocs //
+           << ",\"frees\":" << cs.frees //
+           << ",\"inUse\":" << inUse //
+           << ",\"reserved\":" << cs.reserved //
+           << ",\"free\":" << cs.free //
+           << ",\"cached\":" << static_cast<int64_t>(cs.reserved - cs.free) - inUse //
+           << '}';
+    }
+    os << "]}";
+}
+
 size_t MemCtx::maxSize() noexcept
 {
     assert(impl_);
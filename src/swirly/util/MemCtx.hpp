@@ -20,21 +20,82 @@
 #include <swirly/util/Defs.hpp>
 
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
+#include <vector>
 
 namespace swirly {
 
+/**
+ * Memory-map options. These are intended to remove page-fault jitter from latency-sensitive paths.
+ */
+struct MemOpts {
+    /**
+     * Back anonymous memory-maps with explicit huge pages, falling back to transparent huge pages
+     * if none are reserved.
+     */
+    bool hugePages{false};
+    /**
+     * Touch every page of the memory-map on construction.
+     */
+    bool prefault{false};
+    /**
+     * Lock the memory-map into RAM.
+     */
+    bool lock{false};
+    /**
+     * Max number of segments. Segments after the first are mapped on demand when the pool is
+     * exhausted, up to a limit of 64. Shared memory-maps do not grow.
+     */
+    std::size_t maxSegments{1};
+};
+
+struct MemClassStats {
+    std::size_t blockSize;
+    std::uint64_t allocs;
+    std::uint64_t frees;
+    /**
+     * Blocks reserved from segments.
+     */
+    std::uint64_t reserved;
+    /**
+     * Blocks on the shared free list. Other free blocks are cached by threads.
+     */
+    std::uint64_t free;
+};
+
+struct SWIRLY_API MemStats {
+    std::size_t segmentSize;
+    std::size_t segments;
+    std::size_t maxSegments;
+    /**
+     * Bytes reserved from segments. This is the high-water mark, because reserved memory is
+     * recycled through the free lists rather than returned.
+     */
+    std::size_t reserved;
+    std::vector<MemClassStats> classes;
+
+    void toJson(std::ostream& os) const;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const MemStats& stats)
+{
+    stats.toJson(os);
+    return os;
+}
+
 class SWIRLY_API MemCtx {
   public:
     /**
      * This constructor uses a anonymous, private memory-map.
      */
-    explicit MemCtx(std::size_t maxSize);
+    explicit MemCtx(std::size_t maxSize, const MemOpts& opts = MemOpts{});
 
     /**
      * This constructor uses a shared memory-map.
      */
-    MemCtx(const char* path, std::size_t maxSize);
+    MemCtx(const char* path, std::size_t maxSize, const MemOpts& opts = MemOpts{});
 
     MemCtx();
     ~MemCtx() noexcept;
@@ -48,6 +109,11 @@ class SWIRLY_API MemCtx {
 
     std::size_t maxSize() noexcept;
 
+    /**
+     * Aggregate allocator counters across threads.
+     */
+    MemStats stats() const;
+
     void* alloc(std::size_t size);
 
     void dealloc(void* addr, std::size_t size) noexcept;
@@ -18,7 +18,10 @@
 
 #include <swirly/unit/Test.hpp>
 
+#include <cstdint>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 using namespace std;
 using namespace swirly;
@@ -61,3 +64,113 @@ SWIRLY_TEST_CASE(MemCtx)
     SWIRLY_CHECK(p1 == p2);
     memCtx.dealloc(p2, sizeof(Foo));
 }
+
+SWIRLY_TEST_CASE(MemCtxSizeClass)
+{
+    MemCtx memCtx{1 << 16};
+
+    // Blocks larger than a page are not supported.
+    SWIRLY_CHECK_THROW(memCtx.alloc(4097), bad_alloc);
+
+    // Sizes are rounded up to the size class.
+    void* p1{memCtx.alloc(400)};
+    memCtx.dealloc(p1, 400);
+    void* p2{memCtx.alloc(512)};
+    SWIRLY_CHECK(p1 == p2);
+    memCtx.dealloc(p2, 512);
+
+    // Page-sized blocks are page aligned.
+    void* p3{memCtx.alloc(4096)};
+    SWIRLY_CHECK(reinterpret_cast<uintptr_t>(p3) % 4096 == 0);
+    memCtx.dealloc(p3, 4096);
+}
+
+SWIRLY_TEST_CASE(MemCtxThread)
+{
+    MemCtx memCtx{1 << 20};
+
+    void* p1{nullptr};
+    thread t{[&memCtx, &p1]() {
+        p1 = memCtx.alloc(64);
+        memCtx.dealloc(p1, 64);
+    }};
+    t.join();
+
+    // Blocks cached by the thread are returned to the shared free list when the thread exits.
+    void* p2{memCtx.alloc(64)};
+    SWIRLY_CHECK(p1 == p2);
+    memCtx.dealloc(p2, 64);
+}
+
+SWIRLY_TEST_CASE(MemCtxStats)
+{
+    MemCtx memCtx{1 << 16};
+
+    void* p1{memCtx.alloc(64)};
+    void* p2{memCtx.alloc(64)};
+    memCtx.dealloc(p1, 64);
+    void* p3{memCtx.alloc(128)};
+
+    // Counters of threads that have exited are retained.
+    thread t{[&memCtx]() { memCtx.dealloc(memCtx.alloc(64), 64); }};
+    t.join();
+
+    const auto stats = memCtx.stats();
+    SWIRLY_CHECK(stats.segments == 1);
+    SWIRLY_CHECK(stats.reserved == 3 * 64 + 128);
+    SWIRLY_CHECK(stats.classes.size() == 10);
+
+    const auto& cs1 = stats.classes[0];
+    SWIRLY_CHECK(cs1.blockSize == 64);
+    SWIRLY_CHECK(cs1.allocs == 3);
+    SWIRLY_CHECK(cs1.frees == 2);
+    SWIRLY_CHECK(cs1.reserved == 3);
+    // The exiting thread flushed its magazine to the shared free list, but p1 is still cached.
+    SWIRLY_CHECK(cs1.free == 1);
+
+    const auto& cs2 = stats.classes[1];
+    SWIRLY_CHECK(cs2.allocs == 1);
+    SWIRLY_CHECK(cs2.frees == 0);
+    SWIRLY_CHECK(cs2.reserved == 1);
+
+    memCtx.dealloc(p2, 64);
+    memCtx.dealloc(p3, 128);
+}
+
+SWIRLY_TEST_CASE(MemCtxOpts)
+{
+    MemOpts opts;
+    opts.hugePages = true;
+    opts.prefault = true;
+    // Falls back to transparent huge pages if none are reserved.
+    MemCtx memCtx{1 << 16, opts};
+
+    char* p1{static_cast<char*>(memCtx.alloc(sizeof(Foo)))};
+    strcpy(p1, "test");
+    memCtx.dealloc(p1, sizeof(Foo));
+}
+
+SWIRLY_TEST_CASE(MemCtxGrowth)
+{
+    MemOpts opts;
+    opts.maxSegments = 2;
+    MemCtx memCtx{4096, opts};
+
+    // Allocate from the first segment, then from the second.
+    vector<void*> v;
+    for (int i{0}; i < 2; ++i) {
+        v.push_back(memCtx.alloc(4096));
+    }
+    SWIRLY_CHECK(v[0] != v[1]);
+    // Both segments are exhausted.
+    SWIRLY_CHECK_THROW(memCtx.alloc(4096), bad_alloc);
+
+    // Blocks are returned to the segment they came from.
+    for (auto* p : v) {
+        memCtx.dealloc(p, 4096);
+    }
+    for (int i{0}; i < 2; ++i) {
+        v.push_back(memCtx.alloc(4096));
+    }
+    SWIRLY_CHECK((v[2] == v[0] && v[3] == v[1]) || (v[2] == v[1] && v[3] == v[0]));
+}
@@ -111,6 +111,10 @@ struct MemPool {
             MemStack<(4 << 6)> free4;
             MemStack<(5 << 6)> free5;
             MemStack<(6 << 6)> free6;
+            MemStack<(1 << 9)> free7;
+            MemStack<(1 << 10)> free8;
+            MemStack<(1 << 11)> free9;
+            MemStack<(1 << 12)> free10;
             MemSize offset;
         };
     };
@@ -178,12 +182,17 @@ inline MemNode<SizeN>* pop(const MemPool& pool, MemStack<SizeN>& stack)
     return node;
 }
 
-inline MemSize reserve(MemPool& pool, MemSize size, MemSize maxSize)
+/**
+ * Reserve size bytes from the unallocated region of the pool. The offset is aligned to align, which
+ * must be a power of two.
+ */
+inline MemSize reserve(MemPool& pool, MemSize size, MemSize align, MemSize maxSize)
 {
-    MemSize newOffset, oldOffset;
+    MemSize offset, newOffset, oldOffset;
     __atomic_load(&pool.offset, &oldOffset, __ATOMIC_RELAXED);
     do {
-        newOffset = oldOffset + size;
+        offset = (oldOffset + align - 1) & ~(align - 1);
+        newOffset = offset + size;
         if (newOffset > maxSize) {
             throw std::bad_alloc{};
         }
@@ -194,7 +203,16 @@ inline MemSize reserve(MemPool& pool, MemSize size, MemSize maxSize)
                                           __ATOMIC_RELAXED, // Success.
                                           __ATOMIC_RELAXED // Failure.
                                           ));
-    return oldOffset;
+    return offset;
+}
+
+template <std::size_t SizeN>
+inline void* reserveBlock(MemPool& pool, MemStack<SizeN>& stack, MemSize maxSize)
+{
+    // Page-sized blocks are page aligned.
+    const auto offset
+        = reserve(pool, SizeN, SizeN < PageSize ? CacheLineSize : PageSize, maxSize);
+    return offsetToPtr(pool, offset);
 }
 
 template <std::size_t SizeN>
@@ -202,8 +220,7 @@ inline void* allocBlock(MemPool& pool, MemStack<SizeN>& stack, MemSize maxSize)
 {
     void* addr = pop(pool, stack);
     if (!addr) {
-        const auto offset = reserve(pool, SizeN, maxSize);
-        addr = offsetToPtr(pool, offset);
+        addr = reserveBlock(pool, stack, maxSize);
     }
     return addr;
 }
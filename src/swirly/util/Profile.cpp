@@ -21,6 +21,17 @@
 using namespace std;
 
 namespace swirly {
+namespace {
+
+/**
+ * @return nanoseconds as fractional microseconds.
+ */
+inline double toMicros(double ns) noexcept
+{
+    return ns / 1000.0;
+}
+
+} // anonymous
 
 Profile::~Profile() noexcept
 {
@@ -29,41 +40,23 @@ Profile::~Profile() noexcept
 
 void Profile::report() const noexcept
 {
-    const auto sd = stdev(var_);
-    if (!std::isnan(sd)) {
+    if (!hist_.empty()) {
         SWIRLY_INFO(logMsg() << '<' << name_ //
-                             << "> {\"size\":" << var_.size() //
-                             << ",\"mean\":" << var_.mean() //
-                             << ",\"stdevp\":" << sd //
-                             << ",\"pctile95\":" << pctile95(var_.mean(), sd) //
-                             << ",\"pctile99\":" << pctile99(var_.mean(), sd) //
-                             << ",\"pctile999\":" << pctile999(var_.mean(), sd) //
-                             << ",\"min\":" << var_.min() //
-                             << ",\"max\":" << var_.max() //
+                             << "> {\"size\":" << hist_.count() //
+                             << ",\"mean\":" << toMicros(hist_.mean()) //
+                             << ",\"pctile50\":" << toMicros(hist_.valueAt(50)) //
+                             << ",\"pctile95\":" << toMicros(hist_.valueAt(95)) //
+                             << ",\"pctile99\":" << toMicros(hist_.valueAt(99)) //
+                             << ",\"pctile999\":" << toMicros(hist_.valueAt(99.9)) //
+                             << ",\"min\":" << toMicros(hist_.min()) //
+                             << ",\"max\":" << toMicros(hist_.max()) //
                              << '}');
     }
 }
 
-void Profile::record(double val) noexcept
-{
-    var_.append(val);
-    const auto sd = stdev(var_);
-    if (!std::isnan(sd)) {
-        const auto z = zscore(var_.mean(), sd, val);
-        // NORMSINV(0.999) = 3.0902323
-        if (z > 3.0902323) {
-            SWIRLY_WARNING(logMsg()
-                           << '<' << name_ << "> outlier " << val << " with z-score " << z);
-        }
-    }
-}
-
 TimeRecorder::~TimeRecorder() noexcept
 {
-    const auto end = chrono::high_resolution_clock::now();
-    const chrono::duration<double, micro> diff{end - start_};
-    const auto usec = diff.count();
-    profile_.record(usec);
+    profile_.record(MonoClock::now() - start_);
 }
 
 } // swirly
@@ -17,15 +17,17 @@
 #ifndef SWIRLY_UTIL_PROFILE_HPP
 #define SWIRLY_UTIL_PROFILE_HPP
 
-#include <swirly/util/Math.hpp>
+#include <swirly/util/Histogram.hpp>
 #include <swirly/util/String.hpp>
+#include <swirly/util/Time.hpp>
 
 #include <chrono>
 
 namespace swirly {
 
 /**
- * A statistical profile of observations.
+ * A latency profile. Observations are recorded in a histogram, so that reported percentiles reflect
+ * the actual distribution.
  */
 class SWIRLY_API Profile {
   public:
@@ -47,25 +49,29 @@ class SWIRLY_API Profile {
     /**
      * @return true if there are no observations.
      */
-    bool empty() const noexcept { return var_.empty(); }
+    bool empty() const noexcept { return hist_.empty(); }
     /**
      * @return the number of observations.
      */
-    std::size_t size() const noexcept { return var_.size(); }
+    std::size_t size() const noexcept { return hist_.count(); }
+    /**
+     * @return the histogram of observations in nanoseconds.
+     */
+    const Histogram& histogram() const noexcept { return hist_; }
     /**
      * Clear profile.
      */
-    void clear() noexcept { var_.clear(); }
+    void clear() noexcept { hist_.reset(); }
     /**
      * Add observation to profile.
      *
      * @param val The observation.
      */
-    void record(double val) noexcept;
+    void record(Nanos val) noexcept { hist_.record(val.count() > 0 ? val.count() : 0); }
 
   private:
     String<16> name_;
-    VarAccum var_;
+    Histogram hist_;
 };
 
 /**
@@ -75,7 +81,7 @@ class SWIRLY_API Profile {
 class SWIRLY_API TimeRecorder {
   public:
     explicit TimeRecorder(Profile& profile) noexcept
-        : profile_(profile), start_{std::chrono::high_resolution_clock::now()}
+        : profile_(profile), start_{MonoClock::now()}
     {
     }
     ~TimeRecorder() noexcept;
@@ -90,7 +96,7 @@ class SWIRLY_API TimeRecorder {
 
   private:
     Profile& profile_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> start_;
+    MonoClock::time_point start_;
 };
 
 } // swirly
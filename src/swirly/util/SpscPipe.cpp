@@ -0,0 +1,62 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "SpscPipe.hpp"
+
+#include <climits> // INT_MAX
+
+#include <unistd.h> // syscall()
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+namespace swirly {
+
+PipeIdle toPipeIdle(string_view sv, PipeIdle dfl) noexcept
+{
+    if (iequals(sv, "spin"_sv)) {
+        return PipeIdle::Spin;
+    }
+    if (iequals(sv, "yield"_sv)) {
+        return PipeIdle::Yield;
+    }
+    if (iequals(sv, "park"_sv)) {
+        return PipeIdle::Park;
+    }
+    return dfl;
+}
+
+namespace detail {
+
+static_assert(sizeof(atomic<int>) == sizeof(int), "atomic<int> must be usable as a futex word");
+
+void futexWait(atomic<int>& word, int val) noexcept
+{
+    // Spurious wake-ups and EAGAIN are handled by the caller re-checking its predicate.
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, val, nullptr, nullptr,
+            0);
+}
+
+void futexWake(atomic<int>& word) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+            nullptr, 0);
+}
+
+} // detail
+} // swirly
@@ -0,0 +1,307 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UTIL_SPSCPIPE_HPP
+#define SWIRLY_UTIL_SPSCPIPE_HPP
+
+#include <swirly/util/Atomic.hpp>
+#include <swirly/util/Math.hpp>
+#include <swirly/util/String.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+namespace swirly {
+
+/**
+ * Strategy used by a pipe endpoint while waiting for the other side.
+ */
+enum class PipeIdle {
+    /**
+     * Busy-wait on the position. Lowest latency, but burns a core.
+     */
+    Spin,
+    /**
+     * Yield the processor between polls.
+     */
+    Yield,
+    /**
+     * Spin briefly and then sleep on a futex until woken by the other side.
+     */
+    Park
+};
+
+inline const char* enumString(PipeIdle idle) noexcept
+{
+    switch (idle) {
+    case PipeIdle::Spin:
+        return "SPIN";
+    case PipeIdle::Yield:
+        return "YIELD";
+    case PipeIdle::Park:
+        return "PARK";
+    }
+    std::terminate();
+}
+
+inline std::ostream& operator<<(std::ostream& os, PipeIdle idle)
+{
+    return os << enumString(idle);
+}
+
+/**
+ * Parse idle strategy. The comparison is case-insensitive.
+ *
+ * @return the default value if the string is not recognised.
+ */
+SWIRLY_API PipeIdle toPipeIdle(std::string_view sv, PipeIdle dfl = PipeIdle::Park) noexcept;
+
+namespace detail {
+
+/**
+ * Block while the word is equal to the value.
+ */
+SWIRLY_API void futexWait(std::atomic<int>& word, int val) noexcept;
+
+/**
+ * Wake all threads blocked on the word.
+ */
+SWIRLY_API void futexWake(std::atomic<int>& word) noexcept;
+
+inline void cpuRelax() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+} // detail
+
+/**
+ * Lock-free pipe for exactly one producer thread and one consumer thread. The interface mirrors
+ * Pipe, so that it can be used as a drop-in replacement where the single-producer constraint
+ * holds.
+ */
+template <typename ValueT>
+class SpscPipe {
+  public:
+    explicit SpscPipe(std::size_t capacity, PipeIdle idle = PipeIdle::Park)
+        : capacity_{nextPow2(capacity)}, mask_{capacity_ - 1}, idle_{idle},
+          buf_{new ValueT[capacity_]}
+    {
+    }
+    ~SpscPipe() noexcept = default;
+
+    // Copy.
+    SpscPipe(const SpscPipe& rhs) = delete;
+    SpscPipe& operator=(const SpscPipe& rhs) = delete;
+
+    // Move.
+    SpscPipe(SpscPipe&&) = delete;
+    SpscPipe& operator=(SpscPipe&&) = delete;
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    PipeIdle idle() const noexcept { return idle_; }
+    bool empty() const noexcept
+    {
+        return rpos_.load(std::memory_order_acquire) == wpos_.load(std::memory_order_acquire);
+    }
+    bool full() const noexcept
+    {
+        return wpos_.load(std::memory_order_acquire) - rpos_.load(std::memory_order_acquire)
+            >= capacity_;
+    }
+    /**
+     * @return the number of values in the pipe. This may be read from any thread.
+     */
+    std::size_t size() const noexcept
+    {
+        return wpos_.load(std::memory_order_acquire) - rpos_.load(std::memory_order_acquire);
+    }
+    /**
+     * @return the number of writes that waited for space, because the pipe was full.
+     */
+    std::uint64_t stalls() const noexcept { return stalls_.load(std::memory_order_relaxed); }
+    /**
+     * @return the total time that writes waited for space.
+     */
+    Nanos stallTime() const noexcept { return Nanos{stallTime_.load(std::memory_order_relaxed)}; }
+    /**
+     * Consumer only. Waits until a value is available or the pipe is closed.
+     *
+     * @return false if the pipe is closed and empty.
+     */
+    template <typename FnT>
+    bool read(FnT fn)
+    {
+        const auto rpos = rpos_.load(std::memory_order_relaxed);
+        if (rpos == wposCache_) {
+            wait(readWaiter_, [this, rpos]() {
+                wposCache_ = wpos_.load(std::memory_order_acquire);
+                return wposCache_ != rpos || closed_.load(std::memory_order_acquire);
+            });
+            if (rpos == wposCache_) {
+                // Values written before the pipe was closed are still visible here.
+                wposCache_ = wpos_.load(std::memory_order_acquire);
+                if (rpos == wposCache_) {
+                    return false;
+                }
+            }
+        }
+        // Continue to read when closed while buffer is not empty.
+        const ValueT& ref = buf_[rpos & mask_];
+        fn(ref);
+        rpos_.store(rpos + 1, std::memory_order_release);
+        notify(writeWaiter_);
+        return true;
+    }
+    /**
+     * Consumer only. Reads a value if one is immediately available.
+     *
+     * @return false if the pipe is empty.
+     */
+    template <typename FnT>
+    bool tryRead(FnT fn)
+    {
+        const auto rpos = rpos_.load(std::memory_order_relaxed);
+        if (rpos == wposCache_) {
+            wposCache_ = wpos_.load(std::memory_order_acquire);
+            if (rpos == wposCache_) {
+                return false;
+            }
+        }
+        const ValueT& ref = buf_[rpos & mask_];
+        fn(ref);
+        rpos_.store(rpos + 1, std::memory_order_release);
+        notify(writeWaiter_);
+        return true;
+    }
+    /**
+     * Producer only. Waits while the pipe is full.
+     *
+     * @return false if the pipe is closed.
+     */
+    template <typename FnT>
+    bool write(FnT fn)
+    {
+        const auto wpos = wpos_.load(std::memory_order_relaxed);
+        if (wpos - rposCache_ >= capacity_) {
+            rposCache_ = rpos_.load(std::memory_order_acquire);
+            if (wpos - rposCache_ >= capacity_) {
+                const auto start = MonoClock::now();
+                wait(writeWaiter_, [this, wpos]() {
+                    rposCache_ = rpos_.load(std::memory_order_acquire);
+                    return wpos - rposCache_ < capacity_ || closed_.load(std::memory_order_acquire);
+                });
+                singleWriterAdd(stalls_, 1);
+                singleWriterAdd(stallTime_, (MonoClock::now() - start).count());
+            }
+        }
+        // Prevent further writes when closed.
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        fn(buf_[wpos & mask_]);
+        wpos_.store(wpos + 1, std::memory_order_release);
+        notify(readWaiter_);
+        return true;
+    }
+    void close() noexcept
+    {
+        closed_.store(true, std::memory_order_release);
+        if (idle_ == PipeIdle::Park) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            readWaiter_.store(0, std::memory_order_relaxed);
+            detail::futexWake(readWaiter_);
+            writeWaiter_.store(0, std::memory_order_relaxed);
+            detail::futexWake(writeWaiter_);
+        }
+    }
+
+  private:
+    enum : int { SpinCount = 1 << 10 };
+
+    template <typename PredT>
+    void wait(std::atomic<int>& waiter, PredT pred) noexcept
+    {
+        for (int i{0}; !pred(); ++i) {
+            switch (idle_) {
+            case PipeIdle::Spin:
+                detail::cpuRelax();
+                break;
+            case PipeIdle::Yield:
+                std::this_thread::yield();
+                break;
+            case PipeIdle::Park:
+                if (i < SpinCount) {
+                    detail::cpuRelax();
+                    break;
+                }
+                // Announce the waiter before re-checking the predicate, so that the other side
+                // either sees the flag or this side sees the update.
+                waiter.store(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!pred()) {
+                    detail::futexWait(waiter, 1);
+                }
+                waiter.store(0, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    void notify(std::atomic<int>& waiter) noexcept
+    {
+        if (idle_ == PipeIdle::Park) {
+            // Pairs with the fence in wait(). The cached positions are only lower bounds, so they
+            // cannot prove that the other side is not parking, and the fence is required on each
+            // notification. It is local to this core; use PipeIdle::Spin to avoid it altogether.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiter.load(std::memory_order_relaxed) != 0) {
+                waiter.store(0, std::memory_order_relaxed);
+                detail::futexWake(waiter);
+            }
+        }
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const PipeIdle idle_;
+    std::unique_ptr<ValueT[]> buf_;
+    std::atomic<bool> closed_{false};
+    // Ensure that consumer and producer state are in different cache-lines. Each side keeps a
+    // cached copy of the other side's position, so that the other side's line is only read when
+    // the cached copy indicates that the pipe is empty or full.
+    alignas(64) std::atomic<uint64_t> rpos_{0};
+    uint64_t wposCache_{0};
+    alignas(64) std::atomic<uint64_t> wpos_{0};
+    uint64_t rposCache_{0};
+    std::atomic<uint64_t> stalls_{0};
+    std::atomic<int64_t> stallTime_{0};
+    // Each waiter flag has a line of its own, which is only written when a side parks. The flag
+    // that is checked after each read or write is therefore held in the cache of both sides,
+    // rather than bouncing with the other side's position.
+    alignas(64) std::atomic<int> readWaiter_{0};
+    alignas(64) std::atomic<int> writeWaiter_{0};
+};
+
+} // swirly
+
+#endif // SWIRLY_UTIL_SPSCPIPE_HPP
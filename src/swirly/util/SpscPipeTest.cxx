@@ -0,0 +1,110 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "SpscPipe.hpp"
+
+#include <swirly/unit/Test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+using IntPipe = SpscPipe<int>;
+
+void producer(IntPipe& p)
+{
+    for (int i{1}; i <= 10000; ++i) {
+        p.write([i](int& ref) { ref = i; });
+    }
+    p.close();
+}
+
+long consume(PipeIdle idle)
+{
+    IntPipe p{1 << 10, idle};
+    thread t{producer, ref(p)};
+    long sum{0};
+    int prev{0};
+    bool ordered{true};
+    while (p.read([&](int i) {
+        ordered = ordered && i == prev + 1;
+        prev = i;
+        sum += i;
+    }))
+        ;
+    t.join();
+    return ordered ? sum : -1;
+}
+
+} // anonymous
+
+SWIRLY_TEST_CASE(SpscPipeIdle)
+{
+    SWIRLY_CHECK(toPipeIdle("spin"_sv) == PipeIdle::Spin);
+    SWIRLY_CHECK(toPipeIdle("YIELD"_sv) == PipeIdle::Yield);
+    SWIRLY_CHECK(toPipeIdle("Park"_sv) == PipeIdle::Park);
+    SWIRLY_CHECK(toPipeIdle("sleep"_sv, PipeIdle::Spin) == PipeIdle::Spin);
+    SWIRLY_CHECK(toPipeIdle(""_sv) == PipeIdle::Park);
+}
+
+SWIRLY_TEST_CASE(SpscPipeClose)
+{
+    IntPipe p{3};
+    SWIRLY_CHECK(p.capacity() == 4);
+    SWIRLY_CHECK(p.empty());
+    for (int i{1}; i <= 4; ++i) {
+        SWIRLY_CHECK(p.write([i](int& ref) { ref = i; }));
+    }
+    SWIRLY_CHECK(p.full());
+    p.close();
+    // Writes fail once closed, but pending values can still be read.
+    SWIRLY_CHECK(!p.write([](int& ref) { ref = 0; }));
+    int sum{0};
+    while (p.read([&sum](int i) { sum += i; }))
+        ;
+    SWIRLY_CHECK(sum == 10);
+    SWIRLY_CHECK(p.empty());
+}
+
+SWIRLY_TEST_CASE(SpscPipeTryRead)
+{
+    IntPipe p{4};
+    int sum{0};
+    auto fn = [&sum](int i) { sum += i; };
+    SWIRLY_CHECK(!p.tryRead(fn));
+    p.write([](int& ref) { ref = 1; });
+    p.write([](int& ref) { ref = 2; });
+    SWIRLY_CHECK(p.tryRead(fn));
+    SWIRLY_CHECK(p.tryRead(fn));
+    SWIRLY_CHECK(!p.tryRead(fn));
+    SWIRLY_CHECK(sum == 3);
+}
+
+SWIRLY_TEST_CASE(SpscPipeSpin)
+{
+    SWIRLY_CHECK(consume(PipeIdle::Spin) == 50005000);
+}
+
+SWIRLY_TEST_CASE(SpscPipeYield)
+{
+    SWIRLY_CHECK(consume(PipeIdle::Yield) == 50005000);
+}
+
+SWIRLY_TEST_CASE(SpscPipePark)
+{
+    SWIRLY_CHECK(consume(PipeIdle::Park) == 50005000);
+}
@@ -16,6 +16,8 @@
  */
 #include "String.hpp"
 
+#include <strings.h> // strncasecmp()
+
 using namespace std;
 
 namespace swirly {
@@ -121,6 +123,11 @@ bool stob(string_view sv, bool dfl) noexcept
     return val;
 }
 
+bool iequals(string_view lhs, string_view rhs) noexcept
+{
+    return lhs.size() == rhs.size() && strncasecmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
 void ltrim(string_view& s) noexcept
 {
     const auto pos = s.find_first_not_of(Space);
@@ -317,6 +317,11 @@ SWIRLY_API uint64_t stou64(std::string_view sv) noexcept;
 
 SWIRLY_API bool stob(std::string_view sv, bool dfl = false) noexcept;
 
+/**
+ * @return true if the strings are equal, ignoring case.
+ */
+SWIRLY_API bool iequals(std::string_view lhs, std::string_view rhs) noexcept;
+
 SWIRLY_API void ltrim(std::string_view& s) noexcept;
 
 SWIRLY_API void ltrim(std::string& s) noexcept;
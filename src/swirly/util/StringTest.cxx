@@ -153,6 +153,15 @@ SWIRLY_TEST_CASE(Stob)
     SWIRLY_CHECK(stob("false"_sv, true) == false);
 }
 
+SWIRLY_TEST_CASE(Iequals)
+{
+    SWIRLY_CHECK(iequals(""_sv, ""_sv));
+    SWIRLY_CHECK(iequals("foo"_sv, "FOO"_sv));
+    SWIRLY_CHECK(iequals("Foo"_sv, "fOo"_sv));
+    SWIRLY_CHECK(!iequals("foo"_sv, "bar"_sv));
+    SWIRLY_CHECK(!iequals("foo"_sv, "foobar"_sv));
+}
+
 SWIRLY_TEST_CASE(LtrimCopy)
 {
     SWIRLY_CHECK(ltrimCopy(""_sv) == ""_sv);
@@ -16,9 +16,16 @@
  */
 #include "Time.hpp"
 
+#include <atomic>
 #include <iomanip>
 #include <sstream>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define SWIRLY_HAVE_TSC 1
+#endif
+
 using namespace std;
 
 namespace swirly {
@@ -27,14 +34,166 @@ constexpr size_t operator""_strlen(const char* data, size_t len) noexcept
 {
     return len;
 }
+
+// Period of calibration against CLOCK_MONOTONIC.
+constexpr int64_t CalibrateNs{10'000'000};
+// Period after which the wall clock is re-anchored to CLOCK_REALTIME.
+constexpr int64_t AnchorNs{1'000'000'000};
+// Largest backward step of the wall clock that is held rather than followed. Larger steps are
+// adjustments of the system clock.
+constexpr int64_t HoldNs{1'000'000};
+
+inline int64_t getTime(clockid_t id) noexcept
+{
+    timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec * 1'000'000'000L + ts.tv_nsec;
+}
+
+#if defined(SWIRLY_HAVE_TSC)
+
+inline uint64_t readTsc() noexcept
+{
+    // The fence prevents the counter from being read before earlier instructions complete.
+    _mm_lfence();
+    return __rdtsc();
+}
+
+/**
+ * @return true if the time-stamp counter runs at a constant rate in all power states.
+ */
+bool hasInvariantTsc() noexcept
+{
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1 << 8)) != 0;
+}
+
+#endif // SWIRLY_HAVE_TSC
+
+/**
+ * Nanoseconds are derived from ticks as a 32.32 fixed-point multiplication relative to a base
+ * point, which is established during calibration.
+ */
+struct Tsc {
+    Tsc() noexcept
+    {
+#if defined(SWIRLY_HAVE_TSC)
+        if (!hasInvariantTsc()) {
+            return;
+        }
+        const auto start = getTime(CLOCK_MONOTONIC);
+        const auto startTsc = readTsc();
+        int64_t end;
+        do {
+            end = getTime(CLOCK_MONOTONIC);
+        } while (end - start < CalibrateNs);
+        const auto endTsc = readTsc();
+        if (endTsc <= startTsc) {
+            return;
+        }
+        mult = (static_cast<unsigned __int128>(end - start) << 32) / (endTsc - startTsc);
+        baseNs = end;
+        baseTsc = endTsc;
+        enabled = true;
+#endif
+    }
+    int64_t now() const noexcept
+    {
+#if defined(SWIRLY_HAVE_TSC)
+        if (enabled) {
+            const auto ticks = static_cast<int64_t>(readTsc() - baseTsc);
+            return baseNs + static_cast<int64_t>((static_cast<__int128>(ticks) * mult) >> 32);
+        }
+#endif
+        return getTime(CLOCK_MONOTONIC);
+    }
+    bool enabled{false};
+    uint64_t mult{0};
+    int64_t baseNs{0};
+    uint64_t baseTsc{0};
+};
+
+const Tsc& tsc() noexcept
+{
+    static const Tsc tsc;
+    return tsc;
+}
+
+/**
+ * Offset of the wall clock from MonoClock. The offset is shared by all threads, so that threads
+ * agree on the wall clock, and whichever thread first finds it stale re-anchors it.
+ */
+struct Anchor {
+    explicit Anchor(const Tsc& tsc) noexcept
+    {
+        const auto real = getTime(CLOCK_REALTIME);
+        const auto mono = tsc.now();
+        offset.store(real - mono, memory_order_relaxed);
+        anchored.store(mono, memory_order_relaxed);
+    }
+    int64_t now(const Tsc& tsc) noexcept
+    {
+        const auto mono = tsc.now();
+        auto prev = anchored.load(memory_order_relaxed);
+        if (mono - prev >= AnchorNs
+            && anchored.compare_exchange_strong(prev, mono, memory_order_relaxed)) {
+            offset.store(getTime(CLOCK_REALTIME) - tsc.now(), memory_order_relaxed);
+        }
+        return mono + offset.load(memory_order_relaxed);
+    }
+    atomic<int64_t> offset{0};
+    // MonoClock time of the last re-anchor.
+    atomic<int64_t> anchored{0};
+};
+
+Anchor& anchor() noexcept
+{
+    static Anchor anchor{tsc()};
+    return anchor;
+}
+
 } // anonymous
 
+MonoClock::time_point MonoClock::now() noexcept
+{
+    return time_point{duration{tsc().now()}};
+}
+
+void MonoClock::calibrate() noexcept
+{
+    if (tsc().enabled) {
+        anchor();
+    }
+}
+
+bool MonoClock::isTsc() noexcept
+{
+    return tsc().enabled;
+}
+
 UnixClock::time_point UnixClock::now() noexcept
 {
-    using chrono::nanoseconds;
-    timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return time_point{nanoseconds{ts.tv_sec * 1'000'000'000L + ts.tv_nsec}};
+    const auto& t = tsc();
+    if (!t.enabled) {
+        return time_point{duration{getTime(CLOCK_REALTIME)}};
+    }
+    // Re-anchoring may step the wall clock back by the drift accumulated since the last anchor, so
+    // each thread holds its clock until it catches up.
+    static thread_local int64_t last{0};
+    const auto now = anchor().now(t);
+    if (now >= last || last - now > HoldNs) {
+        last = now;
+    }
+    return time_point{duration{last}};
+}
+
+CoarseClock::time_point CoarseClock::now() noexcept
+{
+    return time_point{duration{getTime(CLOCK_REALTIME_COARSE)}};
 }
 
 void formatTime(Time time, ostream& os)
@@ -28,6 +28,38 @@ namespace swirly {
 
 using namespace std::literals::chrono_literals;
 
+/**
+ * A steady clock that reads the invariant time-stamp counter where one is available, and falls back
+ * to CLOCK_MONOTONIC otherwise. This is the clock for measuring intervals on the hot path.
+ */
+struct SWIRLY_API MonoClock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<MonoClock, duration>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept;
+
+    /**
+     * Calibrate the time-stamp counter, which takes about ten milliseconds. Calibration is
+     * otherwise performed on first use, so this should be called during startup, before any
+     * latency-sensitive threads are started.
+     */
+    static void calibrate() noexcept;
+    /**
+     * @return true if the clock reads the time-stamp counter.
+     */
+    static bool isTsc() noexcept;
+};
+
+/**
+ * The wall clock. When MonoClock reads the time-stamp counter, the wall clock is extrapolated from
+ * MonoClock by an offset that is shared by all threads, and re-anchored to CLOCK_REALTIME once per
+ * second. Small steps back on re-anchoring are held, so that readings never go backwards within a
+ * thread unless the system clock is adjusted.
+ */
 struct SWIRLY_API UnixClock {
     using duration = std::chrono::nanoseconds;
     using rep = duration::rep;
@@ -52,7 +84,23 @@ struct SWIRLY_API UnixClock {
     }
 };
 
+/**
+ * A coarse wall clock that reads the kernel's cached time, which is updated on each tick. The
+ * resolution is typically between one and four milliseconds, which is sufficient for log headers.
+ */
+struct SWIRLY_API CoarseClock {
+    using duration = UnixClock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = UnixClock::time_point;
+
+    static constexpr bool is_steady = false;
+
+    static time_point now() noexcept;
+};
+
 using Time = UnixClock::time_point;
+using Seconds = std::chrono::seconds;
 using Millis = std::chrono::milliseconds;
 using Micros = std::chrono::microseconds;
 using Nanos = std::chrono::nanoseconds;
@@ -0,0 +1,67 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Time.hpp"
+
+#include <swirly/unit/Test.hpp>
+
+#include <ctime>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+int64_t getTime(clockid_t id) noexcept
+{
+    timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec * 1'000'000'000L + ts.tv_nsec;
+}
+
+bool isNear(int64_t lhs, int64_t rhs, int64_t tol) noexcept
+{
+    return lhs - rhs < tol && rhs - lhs < tol;
+}
+
+} // anonymous
+
+SWIRLY_TEST_CASE(MonoClock)
+{
+    auto prev = MonoClock::now();
+    for (int i{0}; i < 1000; ++i) {
+        const auto now = MonoClock::now();
+        SWIRLY_CHECK(now >= prev);
+        prev = now;
+    }
+    // Calibrated against CLOCK_MONOTONIC.
+    SWIRLY_CHECK(isNear(MonoClock::now().time_since_epoch().count(), getTime(CLOCK_MONOTONIC),
+                        1'000'000));
+}
+
+SWIRLY_TEST_CASE(UnixClock)
+{
+    MonoClock::calibrate();
+    auto prev = UnixClock::now();
+    for (int i{0}; i < 1000; ++i) {
+        const auto now = UnixClock::now();
+        SWIRLY_CHECK(now >= prev);
+        prev = now;
+    }
+    SWIRLY_CHECK(isNear(nsSinceEpoch(UnixClock::now()), getTime(CLOCK_REALTIME), 1'000'000));
+    // The coarse clock lags by no more than a few ticks.
+    SWIRLY_CHECK(isNear(nsSinceEpoch(CoarseClock::now()), getTime(CLOCK_REALTIME), 100'000'000));
+}
@@ -0,0 +1,227 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Trace.hpp"
+
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/File.hpp>
+#include <swirly/util/MemMap.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h> // write()
+
+using namespace std;
+
+namespace swirly {
+namespace {
+
+constexpr char Magic[] = "SWIRLYT";
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t eventSize;
+    uint64_t events;
+};
+static_assert(sizeof(Magic) == sizeof(TraceHeader::magic), "invalid magic size");
+constexpr uint32_t Version{1};
+
+/**
+ * Each thread writes to its own ring buffer, so that probes do not contend.
+ */
+struct Ring {
+    explicit Ring(uint32_t tid, size_t capacity) : tid{tid}, key{tid, 0}, events(capacity) {}
+    const uint32_t tid;
+    // Requests begun on this thread.
+    uint64_t reqs{0};
+    // Request to which events are attributed, which may have begun on another thread.
+    TraceKey key;
+    uint64_t count{0};
+    vector<TraceEvent> events;
+};
+using RingPtr = shared_ptr<Ring>;
+
+struct Registry {
+    mutex ringsMutex;
+    // Rings outlive their threads, so that events can be written after threads exit.
+    vector<RingPtr> rings;
+};
+
+Registry& registry() noexcept
+{
+    // Intentionally leaked, so that the registry outlives thread-local rings.
+    static auto* registry = new Registry;
+    return *registry;
+}
+
+atomic<bool> enabled_{false};
+atomic<size_t> capacity_{0};
+
+Ring& ring()
+{
+    static thread_local RingPtr ring;
+    if (!ring) {
+        static atomic<uint32_t> nextTid{0};
+        ring = make_shared<Ring>(++nextTid, capacity_.load(memory_order_relaxed));
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.ringsMutex};
+        reg.rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void writeAll(int fd, const void* data, size_t len)
+{
+    const auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        const auto ret = ::write(fd, p, len);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error{errno, system_category(), "write failed"};
+        }
+        p += ret;
+        len -= ret;
+    }
+}
+
+} // anonymous
+
+bool isTraceEnabled() noexcept
+{
+    return enabled_.load(memory_order_acquire);
+}
+
+void enableTrace(size_t capacity) noexcept
+{
+    assert(capacity > 0);
+    capacity_.store(capacity, memory_order_relaxed);
+    enabled_.store(true, memory_order_release);
+}
+
+void beginTrace() noexcept
+{
+    if (isTraceEnabled()) {
+        try {
+            auto& r = ring();
+            r.key = {r.tid, ++r.reqs};
+        } catch (const std::bad_alloc&) {
+            // Tracing is best effort.
+        }
+    }
+}
+
+TraceKey traceKey() noexcept
+{
+    if (isTraceEnabled()) {
+        try {
+            return ring().key;
+        } catch (const std::bad_alloc&) {
+            // Tracing is best effort.
+        }
+    }
+    return {};
+}
+
+void setTraceKey(TraceKey key) noexcept
+{
+    if (isTraceEnabled()) {
+        try {
+            ring().key = key;
+        } catch (const std::bad_alloc&) {
+            // Tracing is best effort.
+        }
+    }
+}
+
+void trace(TraceStage stage, MonoClock::time_point start, MonoClock::time_point end) noexcept
+{
+    if (!isTraceEnabled()) {
+        return;
+    }
+    try {
+        auto& r = ring();
+        auto& ev = r.events[r.count++ % r.events.size()];
+        ev.tid = r.key.tid;
+        ev.stage = stage;
+        ev.pad = 0;
+        ev.req = r.key.req;
+        ev.start = start.time_since_epoch().count();
+        ev.end = end.time_since_epoch().count();
+    } catch (const std::bad_alloc&) {
+        // Tracing is best effort.
+    }
+}
+
+size_t writeTrace(const char* path)
+{
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.ringsMutex};
+
+    TraceHeader header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.eventSize = sizeof(TraceEvent);
+    header.events = 0;
+    for (const auto& r : reg.rings) {
+        header.events += min<uint64_t>(r->count, r->events.size());
+    }
+
+    const auto file = openFile(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    const auto fd = file.get().get();
+    writeAll(fd, &header, sizeof(header));
+    for (const auto& r : reg.rings) {
+        const auto n = r->events.size();
+        // Oldest first.
+        for (auto i = r->count - min<uint64_t>(r->count, n); i < r->count; ++i) {
+            writeAll(fd, &r->events[i % n], sizeof(TraceEvent));
+        }
+    }
+    return header.events;
+}
+
+void readTrace(const char* path, const function<void(const TraceEvent&)>& fn)
+{
+    const auto file = openFile(path, O_RDONLY);
+    const auto len = size(file.get());
+    if (len < sizeof(TraceHeader)) {
+        throw Exception{errMsg() << "invalid trace: " << path};
+    }
+    const auto memMap = openMemMap(nullptr, len, PROT_READ, MAP_SHARED, file.get(), 0);
+
+    const auto* const header = static_cast<const TraceHeader*>(memMap.get().data());
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version
+        || header->eventSize != sizeof(TraceEvent)
+        || len != sizeof(TraceHeader) + header->events * sizeof(TraceEvent)) {
+        throw Exception{errMsg() << "invalid trace: " << path};
+    }
+    const auto* const first = reinterpret_cast<const TraceEvent*>(header + 1);
+    const auto* const last = first + header->events;
+    for (const auto* it = first; it != last; ++it) {
+        fn(*it);
+    }
+}
+
+} // swirly
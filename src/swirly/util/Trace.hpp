@@ -0,0 +1,228 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_UTIL_TRACE_HPP
+#define SWIRLY_UTIL_TRACE_HPP
+
+#include <swirly/util/Time.hpp>
+
+#include <exception>
+#include <functional>
+#include <ostream>
+
+namespace swirly {
+
+/**
+ * Stages of the request path. Stages may be nested, so their durations are inclusive.
+ */
+enum class TraceStage : std::uint16_t {
+    /**
+     * From the start of the HTTP message to the end of the REST response.
+     */
+    Request,
+    /**
+     * HTTP parsing, from the start of the message to the end of the message.
+     */
+    Http,
+    /**
+     * Parsing of the REST body.
+     */
+    Body,
+    /**
+     * Dispatch of the REST request, including serialisation of the response.
+     */
+    Rest,
+    /**
+     * Order matching in Serv, including the journal enqueue.
+     */
+    Match,
+    /**
+     * Enqueue of journal messages to the async journal.
+     */
+    Journ,
+    /**
+     * Serialisation of the order response.
+     */
+    Json
+};
+
+enum { TraceStages = static_cast<int>(TraceStage::Json) + 1 };
+
+inline const char* enumString(TraceStage stage) noexcept
+{
+    switch (stage) {
+    case TraceStage::Request:
+        return "REQUEST";
+    case TraceStage::Http:
+        return "HTTP";
+    case TraceStage::Body:
+        return "BODY";
+    case TraceStage::Rest:
+        return "REST";
+    case TraceStage::Match:
+        return "MATCH";
+    case TraceStage::Journ:
+        return "JOURN";
+    case TraceStage::Json:
+        return "JSON";
+    }
+    std::terminate();
+}
+
+inline std::ostream& operator<<(std::ostream& os, TraceStage stage)
+{
+    return os << enumString(stage);
+}
+
+/**
+ * A timed stage of a traced request. Events are identified by thread and request sequence number,
+ * because each thread numbers its requests independently.
+ */
+struct TraceEvent {
+    std::uint32_t tid;
+    TraceStage stage;
+    std::uint16_t pad;
+    std::uint64_t req;
+    std::int64_t start;
+    std::int64_t end;
+};
+static_assert(sizeof(TraceEvent) == 32, "must be specific size");
+
+/**
+ * Identifies a traced request. A request that is handed from one thread to another keeps the key
+ * of the thread on which it began, so that all of its stages are attributed to the same request.
+ */
+struct TraceKey {
+    std::uint32_t tid;
+    std::uint64_t req;
+};
+
+/**
+ * Tracing is disabled by default. When disabled, probes cost a single branch.
+ */
+SWIRLY_API bool isTraceEnabled() noexcept;
+
+/**
+ * Enable tracing with a ring buffer of the given capacity for each thread. The oldest events are
+ * overwritten when a ring buffer is full.
+ */
+SWIRLY_API void enableTrace(std::size_t capacity = 1 << 14) noexcept;
+
+/**
+ * Begin a new request on the calling thread. Subsequent events on this thread are attributed to the
+ * request.
+ */
+SWIRLY_API void beginTrace() noexcept;
+
+/**
+ * @return the key of the current request on the calling thread, or a zero key if tracing is
+ * disabled.
+ */
+SWIRLY_API TraceKey traceKey() noexcept;
+
+/**
+ * Attribute subsequent events on the calling thread to the request identified by key, which may
+ * have begun on another thread.
+ */
+SWIRLY_API void setTraceKey(TraceKey key) noexcept;
+
+/**
+ * Record an event for the current request on the calling thread.
+ */
+SWIRLY_API void trace(TraceStage stage, MonoClock::time_point start,
+                      MonoClock::time_point end) noexcept;
+
+/**
+ * Write the events of all threads to a file, oldest first. Threads should not be tracing while the
+ * file is written.
+ *
+ * @return the number of events written.
+ */
+SWIRLY_API std::size_t writeTrace(const char* path);
+
+/**
+ * Read events from a file written by writeTrace().
+ */
+SWIRLY_API void readTrace(const char* path, const std::function<void(const TraceEvent&)>& fn);
+
+/**
+ * Record the time elapsed during object lifetime as a stage of the current request.
+ */
+class TraceScope {
+  public:
+    explicit TraceScope(TraceStage stage) noexcept : stage_{stage}
+    {
+        if (isTraceEnabled()) {
+            start_ = MonoClock::now();
+        }
+    }
+    ~TraceScope() noexcept
+    {
+        if (start_ != MonoClock::time_point{}) {
+            trace(stage_, start_, MonoClock::now());
+        }
+    }
+
+    // Copy.
+    TraceScope(const TraceScope& rhs) = delete;
+    TraceScope& operator=(const TraceScope& rhs) = delete;
+
+    // Move.
+    TraceScope(TraceScope&&) = delete;
+    TraceScope& operator=(TraceScope&&) = delete;
+
+  private:
+    const TraceStage stage_;
+    MonoClock::time_point start_{};
+};
+
+/**
+ * Attribute the events of the calling thread to a request that began on another thread during
+ * object lifetime. The previous request is restored during destruction.
+ */
+class TraceContext {
+  public:
+    explicit TraceContext(TraceKey key) noexcept
+    {
+        if (isTraceEnabled()) {
+            prev_ = traceKey();
+            setTraceKey(key);
+            active_ = true;
+        }
+    }
+    ~TraceContext() noexcept
+    {
+        if (active_) {
+            setTraceKey(prev_);
+        }
+    }
+
+    // Copy.
+    TraceContext(const TraceContext& rhs) = delete;
+    TraceContext& operator=(const TraceContext& rhs) = delete;
+
+    // Move.
+    TraceContext(TraceContext&&) = delete;
+    TraceContext& operator=(TraceContext&&) = delete;
+
+  private:
+    TraceKey prev_{};
+    bool active_{false};
+};
+
+} // swirly
+
+#endif // SWIRLY_UTIL_TRACE_HPP
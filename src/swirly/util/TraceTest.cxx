@@ -0,0 +1,120 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Trace.hpp"
+
+#include <swirly/unit/Test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdlib> // mkstemp()
+
+#include <unistd.h> // unlink()
+
+using namespace std;
+using namespace swirly;
+
+SWIRLY_TEST_CASE(Trace)
+{
+    const MonoClock::time_point t{1000ns};
+
+    // Disabled by default.
+    SWIRLY_CHECK(!isTraceEnabled());
+    beginTrace();
+    trace(TraceStage::Http, t, t + 10ns);
+
+    enableTrace(4);
+    SWIRLY_CHECK(isTraceEnabled());
+    beginTrace();
+    for (int i{0}; i < 6; ++i) {
+        trace(TraceStage::Match, t + i * 1ns, t + i * 2ns);
+    }
+    thread{[t]() {
+        beginTrace();
+        TraceScope scope{TraceStage::Request};
+        trace(TraceStage::Json, t, t + 5ns);
+    }}.join();
+
+    char path[] = "/tmp/swirlyXXXXXX";
+    close(mkstemp(path));
+    SWIRLY_CHECK(writeTrace(path) == 6);
+
+    vector<TraceEvent> events;
+    readTrace(path, [&events](const auto& ev) { events.push_back(ev); });
+    unlink(path);
+
+    SWIRLY_CHECK(events.size() == 6);
+    // The oldest events were overwritten.
+    SWIRLY_CHECK(events[0].tid == events[3].tid);
+    SWIRLY_CHECK(events[0].req == 1);
+    SWIRLY_CHECK(events[0].stage == TraceStage::Match);
+    SWIRLY_CHECK(events[0].start == 1002);
+    SWIRLY_CHECK(events[3].end == 1010);
+
+    SWIRLY_CHECK(events[4].tid != events[0].tid);
+    SWIRLY_CHECK(events[4].req == 1);
+    SWIRLY_CHECK(events[4].stage == TraceStage::Json);
+    SWIRLY_CHECK(events[5].stage == TraceStage::Request);
+    SWIRLY_CHECK(events[5].end >= events[5].start);
+}
+
+SWIRLY_TEST_CASE(TraceContext)
+{
+    const MonoClock::time_point t{1000ns};
+    enableTrace(4);
+
+    // Request begins on one thread and is handed to another.
+    TraceKey key;
+    thread{[t, &key]() {
+        beginTrace();
+        trace(TraceStage::Body, t, t + 1ns);
+        key = traceKey();
+    }}.join();
+    SWIRLY_CHECK(key.req == 1);
+
+    thread{[t, key]() {
+        beginTrace();
+        {
+            TraceContext ctx{key};
+            trace(TraceStage::Rest, t, t + 2ns);
+        }
+        // The thread's own request is restored.
+        trace(TraceStage::Json, t, t + 3ns);
+    }}.join();
+
+    char path[] = "/tmp/swirlyXXXXXX";
+    close(mkstemp(path));
+    writeTrace(path);
+
+    vector<TraceEvent> events;
+    readTrace(path, [&events](const auto& ev) {
+        if (ev.start == 1000 && ev.end <= 1003) {
+            events.push_back(ev);
+        }
+    });
+    unlink(path);
+
+    SWIRLY_CHECK(events.size() == 3);
+    SWIRLY_CHECK(events[0].stage == TraceStage::Body);
+    SWIRLY_CHECK(events[1].stage == TraceStage::Rest);
+    SWIRLY_CHECK(events[1].tid == events[0].tid);
+    SWIRLY_CHECK(events[1].req == events[0].req);
+    SWIRLY_CHECK(events[2].stage == TraceStage::Json);
+    SWIRLY_CHECK(events[2].tid != events[0].tid);
+    SWIRLY_CHECK(events[2].req == 1);
+}
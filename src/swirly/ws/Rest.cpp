@@ -20,10 +20,15 @@
 #include <swirly/clob/Response.hpp>
 
 #include <swirly/fin/Exception.hpp>
+#include <swirly/fin/Journ.hpp>
 
 #include <swirly/util/Date.hpp>
+#include <swirly/util/Finally.hpp>
+#include <swirly/util/Trace.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <mutex>
 
 using namespace std;
 
@@ -31,18 +36,108 @@ namespace swirly {
 namespace detail {
 namespace {
 
-void getOrder(const Accnt& accnt, ostream& out)
+/**
+ * Journal implementations have a single writer, so the journal threads of each shard take turns.
+ */
+class SharedJourn : public Journ {
+  public:
+    explicit SharedJourn(Journ& journ) noexcept : journ_(journ) {}
+    ~SharedJourn() noexcept override = default;
+
+  protected:
+    void doUpdate(const Msg& msg) override
+    {
+        lock_guard<mutex> lock{journMutex_};
+        journ_.update(msg);
+    }
+
+    void doUpdateBatch(ArrayView<Msg> msgs) override
+    {
+        lock_guard<mutex> lock{journMutex_};
+        journ_.update(msgs);
+    }
+
+    uint64_t doSeq() const noexcept override
+    {
+        lock_guard<mutex> lock{journMutex_};
+        return journ_.seq();
+    }
+
+  private:
+    Journ& journ_;
+    mutable mutex journMutex_;
+};
+
+inline const Exec* toPtr(const ConstExecPtr& ptr) noexcept
+{
+    return ptr.get();
+}
+
+template <typename ValueT>
+const ValueT* toPtr(const ValueT& ref) noexcept
+{
+    return &ref;
+}
+
+/**
+ * Merge the elements of each shard. The elements of each shard are already ordered, so the merged
+ * sequence has the order that a single shard would produce. The caller must hold the shard locks.
+ */
+template <typename ValueT, typename ShardsT, typename FnT, typename CompT>
+vector<const ValueT*> merge(const ShardsT& shards, FnT fn, CompT comp)
+{
+    vector<const ValueT*> vals;
+    for (const auto& shard : shards) {
+        const auto mid = vals.size();
+        for (const auto& val : fn(shard->serv)) {
+            vals.push_back(toPtr(val));
+        }
+        inplace_merge(vals.begin(), vals.begin() + mid, vals.end(), comp);
+    }
+    return vals;
+}
+
+template <typename IteratorT>
+void putArray(IteratorT first, IteratorT last, ostream& out)
 {
-    const auto& orders = accnt.orders();
     out << '[';
-    copy(orders.begin(), orders.end(), OStreamJoiner(out, ','));
+    transform(first, last,
+              OStreamJoiner(out, ','), [](const auto* ptr) -> const auto& { return *ptr; });
     out << ']';
 }
 
-void getExec(const Accnt& accnt, Page page, ostream& out)
+template <typename ValueT>
+bool byMarketId(const ValueT* lhs, const ValueT* rhs) noexcept
 {
-    const auto& execs = accnt.execs();
-    out << '[';
+    return lhs->marketId() < rhs->marketId()
+        || (lhs->marketId() == rhs->marketId() && lhs->id() < rhs->id());
+}
+
+template <typename ShardsT>
+void getMarket(const ShardsT& shards, ostream& out)
+{
+    const auto markets = merge<Market>(
+        shards, [](const Serv& serv) -> const auto& { return serv.markets(); },
+        [](const auto* lhs, const auto* rhs) { return lhs->id() < rhs->id(); });
+    putArray(markets.begin(), markets.end(), out);
+}
+
+template <typename ShardsT>
+void getOrder(const ShardsT& shards, Symbol accnt, ostream& out)
+{
+    const auto orders = merge<Order>(
+        shards, [accnt](const Serv& serv) -> const auto& { return serv.accnt(accnt).orders(); },
+        byMarketId<Order>);
+    putArray(orders.begin(), orders.end(), out);
+}
+
+template <typename ShardsT>
+void getExec(const ShardsT& shards, Symbol accnt, Page page, ostream& out)
+{
+    // Most recent first.
+    const auto execs = merge<Exec>(
+        shards, [accnt](const Serv& serv) -> const auto& { return serv.accnt(accnt).execs(); },
+        [](const auto* lhs, const auto* rhs) { return lhs->created() > rhs->created(); });
     const auto size = execs.size();
     if (page.offset < size) {
         auto first = execs.begin();
@@ -54,37 +149,115 @@ void getExec(const Accnt& accnt, Page page, ostream& out)
         } else {
             last = execs.end();
         }
-        transform(first, last,
-                  OStreamJoiner(out, ','), [](const auto& ptr) -> const auto& { return *ptr; });
+        putArray(first, last, out);
+    } else {
+        out << "[]";
     }
-    out << ']';
 }
 
-void getTrade(const Accnt& accnt, ostream& out)
+template <typename ShardsT>
+void getTrade(const ShardsT& shards, Symbol accnt, ostream& out)
 {
-    const auto& trades = accnt.trades();
-    out << '[';
-    copy(trades.begin(), trades.end(), OStreamJoiner(out, ','));
-    out << ']';
+    const auto trades = merge<Exec>(
+        shards, [accnt](const Serv& serv) -> const auto& { return serv.accnt(accnt).trades(); },
+        byMarketId<Exec>);
+    putArray(trades.begin(), trades.end(), out);
 }
 
-void getPosn(const Accnt& accnt, ostream& out)
+template <typename ShardsT>
+void getPosn(const ShardsT& shards, Symbol accnt, ostream& out)
 {
-    const auto& posns = accnt.posns();
-    out << '[';
-    copy(posns.begin(), posns.end(), OStreamJoiner(out, ','));
-    out << ']';
+    const auto posns = merge<Posn>(
+        shards, [accnt](const Serv& serv) -> const auto& { return serv.accnt(accnt).posns(); },
+        [](const auto* lhs, const auto* rhs) { return lhs->marketId() < rhs->marketId(); });
+    putArray(posns.begin(), posns.end(), out);
 }
 
 } // anonymous
 } // detail
 
+struct Rest::Shard {
+    Shard(Journ& journ, size_t pipeCapacity, size_t maxExecs, PipeIdle pipeIdle,
+          size_t batchSize, Micros batchLatency)
+        : serv{journ, pipeCapacity, maxExecs, pipeIdle, batchSize, batchLatency}
+    {
+    }
+    mutex servMutex;
+    Serv serv;
+};
+
+Rest::Rest(Journ& journ, size_t pipeCapacity, size_t maxExecs, PipeIdle pipeIdle,
+           size_t batchSize, Micros batchLatency, size_t shards)
+{
+    assert(shards > 0);
+    Journ* shared{&journ};
+    if (shards > 1) {
+        journ_ = make_unique<detail::SharedJourn>(journ);
+        shared = journ_.get();
+    }
+    shards_.reserve(shards);
+    for (size_t i{0}; i < shards; ++i) {
+        shards_.push_back(make_unique<Shard>(*shared, pipeCapacity, maxExecs, pipeIdle, batchSize,
+                                             batchLatency));
+    }
+}
+
 Rest::~Rest() noexcept = default;
 
 Rest::Rest(Rest&&) = default;
 
 Rest& Rest::operator=(Rest&&) = default;
 
+const Serv& Rest::serv(size_t shard) const noexcept
+{
+    return shards_[shard]->serv;
+}
+
+size_t Rest::shardOf(Symbol instrSymbol) const noexcept
+{
+    // Instruments are immutable once loaded, so no lock is required.
+    const auto& instrs = shards_.front()->serv.instrs();
+    auto it = instrs.find(instrSymbol);
+    return it != instrs.end() ? swirly::shardOf(it->id(), shards_.size()) : 0;
+}
+
+void Rest::load(const Model& model, Time now)
+{
+    vector<Serv*> servs;
+    servs.reserve(shards_.size());
+    for (auto& shard : shards_) {
+        servs.push_back(&shard->serv);
+    }
+    Serv::load(model, now, servs);
+}
+
+uint64_t Rest::snapshot(const char* path, Time now)
+{
+    if (shards_.size() > 1) {
+        throw Exception{"snapshots require a single engine shard"_sv};
+    }
+    auto& shard = *shards_.front();
+    lock_guard<mutex> lock{shard.servMutex};
+    return shard.serv.snapshot(path, now);
+}
+
+bool Rest::endOfDay(Time now, Micros slice, size_t chunkSize)
+{
+    bool done{true};
+    for (auto& shard : shards_) {
+        lock_guard<mutex> lock{shard->servMutex};
+        auto& serv = shard->serv;
+        const auto end = MonoClock::now() + slice;
+        bool shardDone;
+        do {
+            // Orders are expired before the markets that they belong to are removed.
+            shardDone = serv.expireEndOfDay(now, chunkSize) && serv.settlEndOfDay(now, chunkSize);
+        } while (!shardDone && MonoClock::now() < end);
+        done = done && shardDone;
+    }
+    return done;
+}
+
 void Rest::getRefData(EntitySet es, Time now, ostream& out) const
 {
     int i{0};
@@ -116,7 +289,8 @@ void Rest::getRefData(EntitySet es, Time now, ostream& out) const
 
 void Rest::getAsset(Time now, ostream& out) const
 {
-    const auto& assets = serv_.assets();
+    // Reference data is immutable once loaded, so no lock is required.
+    const auto& assets = shards_.front()->serv.assets();
     out << '[';
     copy(assets.begin(), assets.end(), OStreamJoiner(out, ','));
     out << ']';
@@ -124,7 +298,7 @@ void Rest::getAsset(Time now, ostream& out) const
 
 void Rest::getAsset(Symbol symbol, Time now, ostream& out) const
 {
-    const auto& assets = serv_.assets();
+    const auto& assets = shards_.front()->serv.assets();
     auto it = assets.find(symbol);
     if (it == assets.end()) {
         throw NotFoundException{errMsg() << "asset '" << symbol << "' does not exist"};
@@ -134,7 +308,7 @@ void Rest::getAsset(Symbol symbol, Time now, ostream& out) const
 
 void Rest::getInstr(Time now, ostream& out) const
 {
-    const auto& instrs = serv_.instrs();
+    const auto& instrs = shards_.front()->serv.instrs();
     out << '[';
     copy(instrs.begin(), instrs.end(), OStreamJoiner(out, ','));
     out << ']';
@@ -142,7 +316,7 @@ void Rest::getInstr(Time now, ostream& out) const
 
 void Rest::getInstr(Symbol symbol, Time now, ostream& out) const
 {
-    const auto& instrs = serv_.instrs();
+    const auto& instrs = shards_.front()->serv.instrs();
     auto it = instrs.find(symbol);
     if (it == instrs.end()) {
         throw NotFoundException{errMsg() << "instr '" << symbol << "' does not exist"};
@@ -152,12 +326,13 @@ void Rest::getInstr(Symbol symbol, Time now, ostream& out) const
 
 void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& out) const
 {
-    const auto& accnt = serv_.accnt(symbol);
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
     int i{0};
     out << '{';
     if (es.market()) {
         out << "\"markets\":";
-        getMarket(now, out);
+        detail::getMarket(shards_, out);
         ++i;
     }
     if (es.order()) {
@@ -165,7 +340,7 @@ void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& o
             out << ',';
         }
         out << "\"orders\":";
-        detail::getOrder(accnt, out);
+        detail::getOrder(shards_, symbol, out);
         ++i;
     }
     if (es.exec()) {
@@ -173,7 +348,7 @@ void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& o
             out << ',';
         }
         out << "\"execs\":";
-        detail::getExec(accnt, page, out);
+        detail::getExec(shards_, symbol, page, out);
         ++i;
     }
     if (es.trade()) {
@@ -181,7 +356,7 @@ void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& o
             out << ',';
         }
         out << "\"trades\":";
-        detail::getTrade(accnt, out);
+        detail::getTrade(shards_, symbol, out);
         ++i;
     }
     if (es.posn()) {
@@ -189,7 +364,7 @@ void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& o
             out << ',';
         }
         out << "\"posns\":";
-        detail::getPosn(accnt, out);
+        detail::getPosn(shards_, symbol, out);
         ++i;
     }
     out << '}';
@@ -197,15 +372,16 @@ void Rest::getAccnt(Symbol symbol, EntitySet es, Page page, Time now, ostream& o
 
 void Rest::getMarket(Time now, std::ostream& out) const
 {
-    const auto& markets = serv_.markets();
-    out << '[';
-    copy(markets.begin(), markets.end(), OStreamJoiner(out, ','));
-    out << ']';
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
+    detail::getMarket(shards_, out);
 }
 
 void Rest::getMarket(Symbol instrSymbol, Time now, std::ostream& out) const
 {
-    const auto& markets = serv_.markets();
+    auto& shard = *shards_[shardOf(instrSymbol)];
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& markets = shard.serv.markets();
     out << '[';
     copy_if(markets.begin(), markets.end(), OStreamJoiner(out, ','),
             [instrSymbol](const auto& market) { return market.instr() == instrSymbol; });
@@ -214,18 +390,24 @@ void Rest::getMarket(Symbol instrSymbol, Time now, std::ostream& out) const
 
 void Rest::getMarket(Symbol instrSymbol, IsoDate settlDate, Time now, std::ostream& out) const
 {
-    const auto id = toMarketId(serv_.instr(instrSymbol).id(), settlDate);
-    out << serv_.market(id);
+    const auto id = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(id);
+    lock_guard<mutex> lock{shard.servMutex};
+    out << shard.serv.market(id);
 }
 
 void Rest::getOrder(Symbol accntSymbol, Time now, ostream& out) const
 {
-    detail::getOrder(serv_.accnt(accntSymbol), out);
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
+    detail::getOrder(shards_, accntSymbol, out);
 }
 
 void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, Time now, ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
+    auto& shard = *shards_[shardOf(instrSymbol)];
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& orders = accnt.orders();
     out << '[';
     copy_if(orders.begin(), orders.end(), OStreamJoiner(out, ','),
@@ -236,9 +418,10 @@ void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, Time now, ostream& o
 void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Time now,
                     ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& orders = accnt.orders();
     out << '[';
     copy_if(orders.begin(), orders.end(), OStreamJoiner(out, ','),
@@ -249,9 +432,10 @@ void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, T
 void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Id64 id, Time now,
                     ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& orders = accnt.orders();
     auto it = orders.find(marketId, id);
     if (it == orders.end()) {
@@ -262,17 +446,23 @@ void Rest::getOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, I
 
 void Rest::getExec(Symbol accntSymbol, Page page, Time now, ostream& out) const
 {
-    detail::getExec(serv_.accnt(accntSymbol), page, out);
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
+    detail::getExec(shards_, accntSymbol, page, out);
 }
 
 void Rest::getTrade(Symbol accntSymbol, Time now, ostream& out) const
 {
-    detail::getTrade(serv_.accnt(accntSymbol), out);
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
+    detail::getTrade(shards_, accntSymbol, out);
 }
 
 void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, Time now, std::ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
+    auto& shard = *shards_[shardOf(instrSymbol)];
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& trades = accnt.trades();
     out << '[';
     copy_if(trades.begin(), trades.end(), OStreamJoiner(out, ','),
@@ -283,9 +473,10 @@ void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, Time now, std::ostre
 void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Time now,
                     ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& trades = accnt.trades();
     out << '[';
     copy_if(trades.begin(), trades.end(), OStreamJoiner(out, ','),
@@ -296,9 +487,10 @@ void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, T
 void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Id64 id, Time now,
                     ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& trades = accnt.trades();
     auto it = trades.find(marketId, id);
     if (it == trades.end()) {
@@ -309,12 +501,16 @@ void Rest::getTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, I
 
 void Rest::getPosn(Symbol accntSymbol, Time now, ostream& out) const
 {
-    detail::getPosn(serv_.accnt(accntSymbol), out);
+    lockAll();
+    auto finally = makeFinally([this]() { this->unlockAll(); });
+    detail::getPosn(shards_, accntSymbol, out);
 }
 
 void Rest::getPosn(Symbol accntSymbol, Symbol instrSymbol, Time now, ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
+    auto& shard = *shards_[shardOf(instrSymbol)];
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& posns = accnt.posns();
     out << '[';
     copy_if(posns.begin(), posns.end(), OStreamJoiner(out, ','),
@@ -325,9 +521,10 @@ void Rest::getPosn(Symbol accntSymbol, Symbol instrSymbol, Time now, ostream& ou
 void Rest::getPosn(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Time now,
                    ostream& out) const
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& accnt = shard.serv.accnt(accntSymbol);
     const auto& posns = accnt.posns();
     auto it = posns.find(marketId);
     if (it == posns.end()) {
@@ -340,67 +537,113 @@ void Rest::getPosn(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, Ti
 void Rest::postMarket(Symbol instrSymbol, IsoDate settlDate, MarketState state, Time now,
                       ostream& out)
 {
-    const auto& instr = serv_.instr(instrSymbol);
+    const auto& instr = this->instr(instrSymbol);
     const auto settlDay = maybeIsoToJd(settlDate);
-    const auto& market = serv_.createMarket(instr, settlDay, state, now);
+    auto& shard = this->shard(toMarketId(instr.id(), settlDay));
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& market = shard.serv.createMarket(instr, settlDay, state, now);
     out << market;
 }
 
 void Rest::putMarket(Symbol instrSymbol, IsoDate settlDate, MarketState state, Time now,
                      ostream& out)
 {
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto id = toMarketId(instr.id(), settlDate);
-    const auto& market = serv_.market(id);
-    serv_.updateMarket(market, state, now);
+    const auto id = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(id);
+    lock_guard<mutex> lock{shard.servMutex};
+    const auto& market = shard.serv.market(id);
+    shard.serv.updateMarket(market, state, now);
     out << market;
 }
 
 void Rest::postOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, string_view ref,
-                     Side side, Lots lots, Ticks ticks, Lots minLots, Time now, ostream& out)
+                     Side side, Lots lots, Ticks ticks, Lots minLots, TimeInForce tif, Time now,
+                     ostream& out)
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
-    const auto& market = serv_.market(marketId);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    const auto& accnt = serv.accnt(accntSymbol);
+    const auto& market = serv.market(marketId);
     Response resp;
-    serv_.createOrder(accnt, market, ref, side, lots, ticks, minLots, now, resp);
+    serv.createOrder(accnt, market, ref, side, lots, ticks, minLots, tif, now, resp);
+    TraceScope ts{TraceStage::Json};
+    out << resp;
+}
+
+void Rest::postOrders(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate,
+                      ArrayView<OrderSpec> specs, Time now, ostream& out)
+{
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    const auto& accnt = serv.accnt(accntSymbol);
+    const auto& market = serv.market(marketId);
+    Response resp;
+    serv.createOrders(accnt, market, specs, now, resp);
+    TraceScope ts{TraceStage::Json};
     out << resp;
 }
 
 void Rest::putOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, ArrayView<Id64> ids,
                     Lots lots, Time now, ostream& out)
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
-    const auto& market = serv_.market(marketId);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    const auto& accnt = serv.accnt(accntSymbol);
+    const auto& market = serv.market(marketId);
     Response resp;
     if (lots > 0_lts) {
         if (ids.size() == 1) {
-            serv_.reviseOrder(accnt, market, ids[0], lots, now, resp);
+            serv.reviseOrder(accnt, market, ids[0], lots, now, resp);
         } else {
-            serv_.reviseOrder(accnt, market, ids, lots, now, resp);
+            serv.reviseOrder(accnt, market, ids, lots, now, resp);
         }
     } else {
         if (ids.size() == 1) {
-            serv_.cancelOrder(accnt, market, ids[0], now, resp);
+            serv.cancelOrder(accnt, market, ids[0], now, resp);
         } else {
-            serv_.cancelOrder(accnt, market, ids, now, resp);
+            serv.cancelOrder(accnt, market, ids, now, resp);
         }
     }
+    TraceScope ts{TraceStage::Json};
     out << resp;
 }
 
+void Rest::deleteOrder(Symbol accntSymbol, Time now)
+{
+    // Shards are locked in turn, because each shard journals its own cancellations.
+    for (auto& shard : shards_) {
+        lock_guard<mutex> lock{shard->servMutex};
+        auto& serv = shard->serv;
+        serv.cancelOrder(serv.accnt(accntSymbol), now);
+    }
+}
+
+void Rest::deleteMarketOrder(Symbol instrSymbol, IsoDate settlDate, Time now)
+{
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    serv.cancelOrder(serv.market(marketId), now);
+}
+
 void Rest::postTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, string_view ref,
                      Side side, Lots lots, Ticks ticks, LiqInd liqInd, Symbol cpty, Time now,
                      ostream& out)
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
-    const auto& market = serv_.market(marketId);
-    auto trades = serv_.createTrade(accnt, market, ref, side, lots, ticks, liqInd, cpty, now);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    const auto& accnt = serv.accnt(accntSymbol);
+    const auto& market = serv.market(marketId);
+    auto trades = serv.createTrade(accnt, market, ref, side, lots, ticks, liqInd, cpty, now);
     out << '[' << *trades.first;
     if (trades.second) {
         out << ',' << *trades.second;
@@ -411,10 +654,38 @@ void Rest::postTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate,
 void Rest::deleteTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate,
                        ArrayView<Id64> ids, Time now)
 {
-    const auto& accnt = serv_.accnt(accntSymbol);
-    const auto& instr = serv_.instr(instrSymbol);
-    const auto marketId = toMarketId(instr.id(), settlDate);
-    serv_.archiveTrade(accnt, marketId, ids, now);
+    const auto marketId = toMarketId(instr(instrSymbol).id(), settlDate);
+    auto& shard = this->shard(marketId);
+    lock_guard<mutex> lock{shard.servMutex};
+    auto& serv = shard.serv;
+    const auto& accnt = serv.accnt(accntSymbol);
+    serv.archiveTrade(accnt, marketId, ids, now);
+}
+
+const Instr& Rest::instr(Symbol symbol) const
+{
+    // Instruments are immutable once loaded, so no lock is required.
+    return shards_.front()->serv.instr(symbol);
+}
+
+Rest::Shard& Rest::shard(Id64 marketId) const noexcept
+{
+    return *shards_[swirly::shardOf(marketId, shards_.size())];
+}
+
+void Rest::lockAll() const noexcept
+{
+    // Always in the same order, so that account-level queries cannot deadlock.
+    for (const auto& shard : shards_) {
+        shard->servMutex.lock();
+    }
+}
+
+void Rest::unlockAll() const noexcept
+{
+    for (const auto& shard : shards_) {
+        shard->servMutex.unlock();
+    }
 }
 
 } // swirly
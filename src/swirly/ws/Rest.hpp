@@ -22,14 +22,24 @@
 
 #include <swirly/clob/Serv.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace swirly {
 
+/**
+ * Markets are partitioned across one or more engine shards, each of which has its own Serv and
+ * journal pipe. Commands for a market are routed to the shard that owns it, and account-level
+ * queries merge the results of all shards.
+ *
+ * Each shard is guarded by its own mutex, so that commands for markets in different shards may be
+ * run concurrently from different threads.
+ */
 class SWIRLY_API Rest {
   public:
-    Rest(Journ& journ, std::size_t pipeCapacity, std::size_t maxExecs)
-        : serv_{journ, pipeCapacity, maxExecs}
-    {
-    }
+    Rest(Journ& journ, std::size_t pipeCapacity, std::size_t maxExecs,
+         PipeIdle pipeIdle = PipeIdle::Park, std::size_t batchSize = 1 << 6,
+         Micros batchLatency = 1ms, std::size_t shards = 1);
     ~Rest() noexcept;
 
     // Copy.
@@ -40,7 +50,32 @@ class SWIRLY_API Rest {
     Rest(Rest&&);
     Rest& operator=(Rest&&);
 
-    void load(const Model& model, Time now) { serv_.load(model, now); }
+    std::size_t shards() const noexcept { return shards_.size(); }
+
+    /**
+     * The Serv counters may be read without holding the shard lock.
+     */
+    const Serv& serv(std::size_t shard) const noexcept;
+
+    /**
+     * @return the shard that owns markets for the instrument, or zero if the instrument does not
+     * exist.
+     */
+    std::size_t shardOf(Symbol instrSymbol) const noexcept;
+
+    void load(const Model& model, Time now);
+
+    uint64_t snapshot(const char* path, Time now);
+
+    /**
+     * Run a slice of the end-of-day process, which expires orders, rolls positions and removes
+     * markets that have closed. Work is done in chunks of at most chunkSize items, and each shard
+     * is locked for little more than one time slice, so that a large run does not block order entry
+     * for long.
+     *
+     * @return true if the run is complete, otherwise the caller should call again.
+     */
+    bool endOfDay(Time now, Micros slice, std::size_t chunkSize = 1 << 6);
 
     void getRefData(EntitySet es, Time now, std::ostream& out) const;
 
@@ -96,11 +131,25 @@ class SWIRLY_API Rest {
                    std::ostream& out);
 
     void postOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, std::string_view ref,
-                   Side side, Lots lots, Ticks ticks, Lots minLots, Time now, std::ostream& out);
+                   Side side, Lots lots, Ticks ticks, Lots minLots, TimeInForce tif, Time now,
+                   std::ostream& out);
+
+    void postOrders(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate,
+                    ArrayView<OrderSpec> specs, Time now, std::ostream& out);
 
     void putOrder(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, ArrayView<Id64> ids,
                   Lots lots, Time now, std::ostream& out);
 
+    /**
+     * Cancel all orders for the account in all markets.
+     */
+    void deleteOrder(Symbol accntSymbol, Time now);
+
+    /**
+     * Cancel all orders in the market for all accounts.
+     */
+    void deleteMarketOrder(Symbol instrSymbol, IsoDate settlDate, Time now);
+
     void postTrade(Symbol accntSymbol, Symbol instrSymbol, IsoDate settlDate, std::string_view ref,
                    Side side, Lots lots, Ticks ticks, LiqInd liqInd, Symbol cpty, Time now,
                    std::ostream& out);
@@ -109,7 +158,18 @@ class SWIRLY_API Rest {
                      Time now);
 
   private:
-    Serv serv_;
+    struct Shard;
+
+    const Instr& instr(Symbol symbol) const;
+
+    Shard& shard(Id64 marketId) const noexcept;
+
+    void lockAll() const noexcept;
+
+    void unlockAll() const noexcept;
+
+    std::unique_ptr<Journ> journ_;
+    std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 } // swirly
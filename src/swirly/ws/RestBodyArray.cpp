@@ -0,0 +1,133 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "RestBodyArray.hpp"
+
+#include <swirly/fin/Exception.hpp>
+
+using namespace std;
+
+namespace swirly {
+namespace {
+
+constexpr bool isSpace(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+} // anonymous
+
+RestBodyArray::~RestBodyArray() noexcept = default;
+
+void RestBodyArray::reset() noexcept
+{
+    state_ = State::Begin;
+    depth_ = 0;
+    quoted_ = false;
+    escaped_ = false;
+    size_ = 0;
+}
+
+bool RestBodyArray::parse(string_view buf)
+{
+    const char* p{buf.data()};
+    const char* const pe{p + buf.size()};
+    // Start of the current object within the buffer.
+    const char* obj{p};
+
+    for (; p != pe; ++p) {
+        const char c{*p};
+        if (state_ == State::Object) {
+            // Objects are delimited here, and their contents are parsed by the RestBody.
+            if (quoted_) {
+                if (escaped_) {
+                    escaped_ = false;
+                } else if (c == '\\') {
+                    escaped_ = true;
+                } else if (c == '"') {
+                    quoted_ = false;
+                }
+            } else if (c == '"') {
+                quoted_ = true;
+            } else if (c == '{') {
+                ++depth_;
+            } else if (c == '}' && --depth_ == 0) {
+                if (!bodies_[size_]->parse({obj, static_cast<size_t>(p + 1 - obj)})) {
+                    throw BadRequestException{"parse error"_sv};
+                }
+                ++size_;
+                state_ = State::Delim;
+            }
+            continue;
+        }
+        if (isSpace(c)) {
+            continue;
+        }
+        switch (state_) {
+        case State::Begin:
+            if (c != '[') {
+                throw BadRequestException{"parse error"_sv};
+            }
+            state_ = State::First;
+            break;
+        case State::First:
+        case State::Next:
+            if (c == ']' && state_ == State::First) {
+                // Empty array.
+                state_ = State::End;
+                break;
+            }
+            if (c != '{') {
+                throw BadRequestException{"parse error"_sv};
+            }
+            beginObject();
+            obj = p;
+            break;
+        case State::Delim:
+            if (c == ',') {
+                state_ = State::Next;
+            } else if (c == ']') {
+                state_ = State::End;
+            } else {
+                throw BadRequestException{"parse error"_sv};
+            }
+            break;
+        case State::Object:
+        case State::End:
+            throw BadRequestException{"parse error"_sv};
+        }
+    }
+    if (state_ == State::Object && obj != pe) {
+        // The remainder of the object follows in the next buffer.
+        bodies_[size_]->parse({obj, static_cast<size_t>(pe - obj)});
+    }
+    return state_ == State::End;
+}
+
+void RestBodyArray::beginObject()
+{
+    if (size_ == bodies_.size()) {
+        bodies_.push_back(make_unique<RestBody>());
+    } else {
+        bodies_[size_]->reset();
+    }
+    state_ = State::Object;
+    depth_ = 1;
+    quoted_ = false;
+    escaped_ = false;
+}
+
+} // swirly
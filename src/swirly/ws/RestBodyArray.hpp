@@ -0,0 +1,74 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_WS_RESTBODYARRAY_HPP
+#define SWIRLY_WS_RESTBODYARRAY_HPP
+
+#include <swirly/ws/RestBody.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace swirly {
+
+/**
+ * Incremental parser for a JSON array of objects, such as a batch of orders. Each object is parsed
+ * by a RestBody. The RestBody objects are retained by reset(), so that they can be reused by the
+ * next request.
+ */
+class SWIRLY_API RestBodyArray {
+  public:
+    RestBodyArray() noexcept { reset(); }
+    ~RestBodyArray() noexcept;
+
+    // Copy.
+    RestBodyArray(const RestBodyArray&) = delete;
+    RestBodyArray& operator=(const RestBodyArray&) = delete;
+
+    // Move.
+    RestBodyArray(RestBodyArray&&) = delete;
+    RestBodyArray& operator=(RestBodyArray&&) = delete;
+
+    bool empty() const noexcept { return size_ == 0; }
+    /**
+     * @return the number of complete objects.
+     */
+    std::size_t size() const noexcept { return size_; }
+    const RestBody& operator[](std::size_t i) const noexcept { return *bodies_[i]; }
+
+    void reset() noexcept;
+
+    /**
+     * @return true if the array is complete.
+     */
+    bool parse(std::string_view buf);
+
+  private:
+    enum class State { Begin, First, Next, Object, Delim, End };
+
+    void beginObject();
+
+    State state_;
+    int depth_;
+    bool quoted_;
+    bool escaped_;
+    std::size_t size_;
+    std::vector<std::unique_ptr<RestBody>> bodies_;
+};
+
+} // swirly
+
+#endif // SWIRLY_WS_RESTBODYARRAY_HPP
@@ -0,0 +1,95 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "RestBodyArray.hpp"
+
+#include <swirly/fin/Exception.hpp>
+
+#include <swirly/unit/Test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+SWIRLY_TEST_CASE(RestBodyArrayEmpty)
+{
+    RestBodyArray rba;
+
+    SWIRLY_CHECK(rba.parse(" [ ] "_sv));
+    SWIRLY_CHECK(rba.empty());
+}
+
+SWIRLY_TEST_CASE(RestBodyArrayOrders)
+{
+    RestBodyArray rba;
+
+    SWIRLY_CHECK(rba.parse(R"([{"ref":"a{\"b","side":"BUY","lots":10,"ticks":12345},)"
+                           R"( {"side":"SELL","lots":5,"ticks":12346,"minLots":1}])"_sv));
+    SWIRLY_CHECK(rba.size() == 2U);
+
+    SWIRLY_CHECK(rba[0].fields() == (RestBody::Ref | RestBody::Side | RestBody::Lots
+                                     | RestBody::Ticks));
+    SWIRLY_CHECK(rba[0].ref() == "a{\"b"_sv);
+    SWIRLY_CHECK(rba[0].side() == Side::Buy);
+    SWIRLY_CHECK(rba[0].lots() == 10_lts);
+    SWIRLY_CHECK(rba[0].ticks() == 12345_tks);
+
+    SWIRLY_CHECK(rba[1].fields() == (RestBody::Side | RestBody::Lots | RestBody::Ticks
+                                     | RestBody::MinLots));
+    SWIRLY_CHECK(rba[1].side() == Side::Sell);
+    SWIRLY_CHECK(rba[1].lots() == 5_lts);
+    SWIRLY_CHECK(rba[1].ticks() == 12346_tks);
+    SWIRLY_CHECK(rba[1].minLots() == 1_lts);
+
+    // Bodies are reset when reused.
+    rba.reset();
+    SWIRLY_CHECK(rba.parse(R"([{"lots":1}])"_sv));
+    SWIRLY_CHECK(rba.size() == 1U);
+    SWIRLY_CHECK(rba[0].fields() == RestBody::Lots);
+}
+
+SWIRLY_TEST_CASE(RestBodyArrayPartial)
+{
+    RestBodyArray rba;
+
+    SWIRLY_CHECK(!rba.parse(R"([{"side":"BU)"_sv));
+    SWIRLY_CHECK(rba.empty());
+    SWIRLY_CHECK(!rba.parse(R"(Y","lots":10},{"lo)"_sv));
+    SWIRLY_CHECK(rba.size() == 1U);
+    SWIRLY_CHECK(rba.parse(R"(ts":20}])"_sv));
+    SWIRLY_CHECK(rba.size() == 2U);
+    SWIRLY_CHECK(rba[0].side() == Side::Buy);
+    SWIRLY_CHECK(rba[0].lots() == 10_lts);
+    SWIRLY_CHECK(rba[1].lots() == 20_lts);
+}
+
+SWIRLY_TEST_CASE(RestBodyArrayBadSyntax)
+{
+    RestBodyArray rba;
+
+    SWIRLY_CHECK_THROW(rba.parse(R"({"lots":1})"_sv), BadRequestException);
+
+    rba.reset();
+    SWIRLY_CHECK_THROW(rba.parse(R"([{"lots":1} {"lots":2}])"_sv), BadRequestException);
+
+    rba.reset();
+    SWIRLY_CHECK_THROW(rba.parse(R"([{"lots":1},])"_sv), BadRequestException);
+
+    rba.reset();
+    SWIRLY_CHECK_THROW(rba.parse(R"([{"lots":1}] x)"_sv), BadRequestException);
+
+    rba.reset();
+    SWIRLY_CHECK_THROW(rba.parse(R"([{"lots":x}])"_sv), BadRequestException);
+}
@@ -0,0 +1,209 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Engine.hpp"
+
+#include "HttpRequest.hpp"
+#include "HttpResponse.hpp"
+#include "HttpSess.hpp"
+#include "RestServ.hpp"
+
+#include <swirly/ws/Rest.hpp>
+
+#include <swirly/util/Tokeniser.hpp>
+
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h> // write()
+
+using namespace boost;
+using namespace std;
+
+namespace swirly {
+namespace {
+
+string_view popToken(Tokeniser& toks) noexcept
+{
+    if (toks.empty()) {
+        return {};
+    }
+    auto tok = toks.top();
+    toks.pop();
+    // Support both plural and singular forms.
+    if (!tok.empty() && tok.back() == 's') {
+        tok.remove_suffix(1);
+    }
+    return tok;
+}
+
+} // anonymous
+
+Doorbell::Doorbell(asio::io_service& ioServ, function<void()> fn)
+    : fn_{std::move(fn)}, desc_{ioServ}
+{
+    const int fd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+    if (fd < 0) {
+        throw system_error{errno, system_category(), "eventfd failed"};
+    }
+    desc_.assign(fd);
+    asyncWait();
+}
+
+Doorbell::~Doorbell() noexcept = default;
+
+void Doorbell::ring() noexcept
+{
+    if (!pending_.exchange(true, memory_order_acq_rel)) {
+        const uint64_t val{1};
+// Best effort, because the counter cannot overflow with a single outstanding write.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+        ::write(desc_.native_handle(), &val, sizeof(val));
+#pragma GCC diagnostic pop
+    }
+}
+
+void Doorbell::asyncWait()
+{
+    desc_.async_read_some(asio::buffer(&buf_, sizeof(buf_)), [this](auto ec, auto len) {
+        if (!ec) {
+            // Clear before the callback, so that a ring during the callback is not lost.
+            pending_.exchange(false, memory_order_acq_rel);
+            fn_();
+            this->asyncWait();
+        }
+    });
+}
+
+EngineLink::EngineLink(asio::io_service& ioServ, Engine& engine, size_t capacity)
+    : engine_(engine),
+      capacity_{nextPow2(capacity)},
+      reqPipe_{capacity_},
+      respPipe_{capacity_},
+      doorbell_{ioServ, [this]() { onResponse(); }}
+{
+    engine.attach(*this);
+}
+
+EngineLink::~EngineLink() noexcept = default;
+
+void EngineLink::submit(HttpSess& sess, const HttpRequest& req, string& buf)
+{
+    const EngineTask task{&sess, &req, &buf, traceKey()};
+    if (inflight_ < capacity_) {
+        doSubmit(task);
+    } else {
+        backlog_.push_back(task);
+    }
+    intrusive_ptr_add_ref(&sess);
+}
+
+void EngineLink::doSubmit(const EngineTask& task)
+{
+    ++inflight_;
+    reqPipe_.write([&task](EngineTask& ref) { ref = task; });
+    engine_.doorbell_.ring();
+}
+
+void EngineLink::onResponse() noexcept
+{
+    HttpSess* sess{nullptr};
+    while (respPipe_.tryRead([&sess](const EngineTask& task) { sess = task.sess; })) {
+        --inflight_;
+        if (!backlog_.empty()) {
+            doSubmit(backlog_.front());
+            backlog_.pop_front();
+        }
+        sess->onResponse();
+        intrusive_ptr_release(sess);
+    }
+}
+
+Engine::Engine(asio::io_service& ioServ, RestServ& restServ)
+    : restServ_(restServ), doorbell_{ioServ, [this]() { dispatch(); }}
+{
+}
+
+Engine::~Engine() noexcept = default;
+
+void Engine::attach(EngineLink& link)
+{
+    links_.push_back(&link);
+}
+
+void Engine::dispatch() noexcept
+{
+    for (auto* link : links_) {
+        bool done{false};
+        // Each link has at most capacity requests in flight, so this loop is bounded.
+        while (link->reqPipe_.tryRead([this, link](const EngineTask& task) {
+            {
+                TraceContext ctx{task.trace};
+                HttpResponse resp{*task.buf};
+                restServ_.handleRequest(*task.req, resp);
+            }
+            link->respPipe_.write([&task](EngineTask& ref) { ref = task; });
+        })) {
+            done = true;
+        }
+        if (done) {
+            link->doorbell_.ring();
+        }
+    }
+}
+
+EngineRouter::EngineRouter(asio::io_service& ioServ, const Rest& rest, ArrayView<Engine*> engines,
+                           size_t capacity)
+    : rest_(rest)
+{
+    links_.reserve(engines.size());
+    for (auto* engine : engines) {
+        links_.push_back(make_unique<EngineLink>(ioServ, *engine, capacity));
+    }
+}
+
+EngineRouter::~EngineRouter() noexcept = default;
+
+void EngineRouter::submit(HttpSess& sess, const HttpRequest& req, string& buf)
+{
+    links_[route(req.path())]->submit(sess, req, buf);
+}
+
+size_t EngineRouter::route(string_view path) const noexcept
+{
+    if (links_.size() == 1) {
+        return 0;
+    }
+    if (!path.empty() && path.front() == '/') {
+        path.remove_prefix(1);
+    }
+    Tokeniser toks{path, "/"_sv};
+    auto tok = popToken(toks);
+    if (tok == "accnt"_sv) {
+        tok = popToken(toks);
+        if (tok != "order"_sv && tok != "trade"_sv && tok != "posn"_sv) {
+            return 0;
+        }
+    } else if (tok != "market"_sv) {
+        return 0;
+    }
+    // The instrument symbol follows the collection name.
+    const auto instr = toks.empty() ? string_view{} : toks.top();
+    return instr.empty() ? 0 : rest_.shardOf(Symbol{instr}) % links_.size();
+}
+
+} // swirly
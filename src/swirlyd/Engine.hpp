@@ -0,0 +1,188 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_ENGINE_HPP
+#define SWIRLYD_ENGINE_HPP
+
+#include <swirly/util/Array.hpp>
+#include <swirly/util/SpscPipe.hpp>
+#include <swirly/util/Trace.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#include <boost/asio.hpp>
+#pragma GCC diagnostic pop
+
+namespace swirly {
+
+class Engine;
+class HttpRequest;
+class HttpSess;
+class Rest;
+class RestServ;
+
+/**
+ * Wakes an io_service from another thread. The callback runs on the thread that owns the
+ * io_service. Rings that arrive before the callback runs are coalesced, so that at most one
+ * eventfd write is made for each wake-up.
+ */
+class Doorbell {
+  public:
+    Doorbell(boost::asio::io_service& ioServ, std::function<void()> fn);
+    ~Doorbell() noexcept;
+
+    // Copy.
+    Doorbell(const Doorbell&) = delete;
+    Doorbell& operator=(const Doorbell&) = delete;
+
+    // Move.
+    Doorbell(Doorbell&&) = delete;
+    Doorbell& operator=(Doorbell&&) = delete;
+
+    /**
+     * May be called from any thread.
+     */
+    void ring() noexcept;
+
+  private:
+    void asyncWait();
+
+    std::function<void()> fn_;
+    boost::asio::posix::stream_descriptor desc_;
+    std::uint64_t buf_{0};
+    std::atomic<bool> pending_{false};
+};
+
+/**
+ * Request handed from an I/O thread to the engine thread. The session does not touch the request
+ * or the response buffer until the task is returned. The trace key of the I/O thread is carried
+ * with the request, so that the engine's stages are attributed to the same request.
+ */
+struct EngineTask {
+    HttpSess* sess;
+    const HttpRequest* req;
+    std::string* buf;
+    TraceKey trace;
+};
+
+/**
+ * Connects one I/O thread to the engine thread with a pair of lock-free pipes. The number of
+ * requests in flight is limited to the pipe capacity, so that neither side blocks on a full pipe.
+ * Excess requests are held in a backlog on the I/O thread.
+ */
+class EngineLink {
+    friend class Engine;
+
+  public:
+    EngineLink(boost::asio::io_service& ioServ, Engine& engine, std::size_t capacity);
+    ~EngineLink() noexcept;
+
+    // Copy.
+    EngineLink(const EngineLink&) = delete;
+    EngineLink& operator=(const EngineLink&) = delete;
+
+    // Move.
+    EngineLink(EngineLink&&) = delete;
+    EngineLink& operator=(EngineLink&&) = delete;
+
+    /**
+     * I/O thread only. The session is retained until the response is returned.
+     */
+    void submit(HttpSess& sess, const HttpRequest& req, std::string& buf);
+
+  private:
+    void doSubmit(const EngineTask& task);
+    void onResponse() noexcept;
+
+    Engine& engine_;
+    const std::size_t capacity_;
+    SpscPipe<EngineTask> reqPipe_;
+    SpscPipe<EngineTask> respPipe_;
+    Doorbell doorbell_;
+    // Only accessed from the I/O thread.
+    std::size_t inflight_{0};
+    std::deque<EngineTask> backlog_;
+};
+
+/**
+ * Runs REST requests submitted by I/O threads on the thread that owns the io_service, which is the
+ * only thread that calls the RestServ. Each market is owned by a single engine, so matching remains
+ * deterministic, while HTTP parsing and socket I/O scale across the I/O threads.
+ */
+class Engine {
+    friend class EngineLink;
+
+  public:
+    Engine(boost::asio::io_service& ioServ, RestServ& restServ);
+    ~Engine() noexcept;
+
+    // Copy.
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Move.
+    Engine(Engine&&) = delete;
+    Engine& operator=(Engine&&) = delete;
+
+  private:
+    void attach(EngineLink& link);
+    void dispatch() noexcept;
+
+    RestServ& restServ_;
+    Doorbell doorbell_;
+    std::vector<EngineLink*> links_;
+};
+
+/**
+ * Routes requests from one I/O thread to the engine that owns the market named in the request path.
+ * There is one engine for each shard. Requests that do not name an instrument, such as
+ * account-level queries, are routed to the first engine.
+ */
+class EngineRouter {
+  public:
+    EngineRouter(boost::asio::io_service& ioServ, const Rest& rest, ArrayView<Engine*> engines,
+                 std::size_t capacity);
+    ~EngineRouter() noexcept;
+
+    // Copy.
+    EngineRouter(const EngineRouter&) = delete;
+    EngineRouter& operator=(const EngineRouter&) = delete;
+
+    // Move.
+    EngineRouter(EngineRouter&&) = delete;
+    EngineRouter& operator=(EngineRouter&&) = delete;
+
+    /**
+     * I/O thread only.
+     */
+    void submit(HttpSess& sess, const HttpRequest& req, std::string& buf);
+
+  private:
+    std::size_t route(std::string_view path) const noexcept;
+
+    const Rest& rest_;
+    std::vector<std::unique_ptr<EngineLink>> links_;
+};
+
+} // swirly
+
+#endif // SWIRLYD_ENGINE_HPP
@@ -19,6 +19,7 @@
 
 #include <swirly/ws/HttpHandler.hpp>
 #include <swirly/ws/RestBody.hpp>
+#include <swirly/ws/RestBodyArray.hpp>
 #include <swirly/ws/Url.hpp>
 
 namespace swirly {
@@ -42,6 +43,14 @@ class HttpRequest : public BasicUrl<HttpRequest> {
     auto perm() const noexcept { return +perm_; }
     auto time() const noexcept { return +time_; }
     const auto& body() const noexcept { return body_; }
+    /**
+     * Bodies of a JSON array request.
+     */
+    const auto& bodies() const noexcept { return bodies_; }
+    /**
+     * True if the request body is a JSON array.
+     */
+    auto array() const noexcept { return array_; }
     auto partial() const noexcept { return partial_; }
     void clear() noexcept
     {
@@ -55,6 +64,9 @@ class HttpRequest : public BasicUrl<HttpRequest> {
         perm_.clear();
         time_.clear();
         body_.reset();
+        bodies_.reset();
+        array_ = false;
+        started_ = false;
         partial_ = false;
     }
     void flush() { BasicUrl<HttpRequest>::parse(); }
@@ -85,7 +97,20 @@ class HttpRequest : public BasicUrl<HttpRequest> {
             value_->append(sv);
         }
     }
-    void appendBody(std::string_view sv) { partial_ = !body_.parse(sv); }
+    void appendBody(std::string_view sv)
+    {
+        if (!started_) {
+            // The first non-space character determines whether the body is an object or an array.
+            const auto pos = sv.find_first_not_of(" \t\n\v\f\r");
+            if (pos == std::string_view::npos) {
+                partial_ = true;
+                return;
+            }
+            array_ = sv[pos] == '[';
+            started_ = true;
+        }
+        partial_ = array_ ? !bodies_.parse(sv) : !body_.parse(sv);
+    }
 
   private:
     HttpMethod method_{HttpMethod::Get};
@@ -97,6 +122,9 @@ class HttpRequest : public BasicUrl<HttpRequest> {
     String<24> perm_;
     String<24> time_;
     RestBody body_;
+    RestBodyArray bodies_;
+    bool array_{false};
+    bool started_{false};
     bool partial_{false};
 };
 
@@ -58,7 +58,7 @@ constexpr bool withBody(int status) noexcept
     return !((status >= 100 && status < 200) || status == 204 || status == 304);
 }
 
-void HttpResponse::reset(int status, const char* reason, bool cache)
+void HttpResponse::reset(int status, const char* reason, bool cache, const char* contentType)
 {
     buf_.reset();
     swirly::reset(*this);
@@ -71,9 +71,8 @@ void HttpResponse::reset(int status, const char* reason, bool cache)
         // Status-Line = HTTP-Version SP Status-Code SP Reason-Phrase CRLF. Use 10 space place-holder
         // for content length. RFC2616 states that field value MAY be preceded by any amount of LWS,
         // though a single SP is preferred.
-        *this << //
-            "\r\nContent-Type: application/json" //
-            "\r\nContent-Length:          0";
+        *this << "\r\nContent-Type: " << contentType //
+              << "\r\nContent-Length:          0";
         lengthAt_ = size();
     } else {
         lengthAt_ = 0;
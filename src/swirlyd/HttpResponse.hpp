@@ -66,7 +66,8 @@ class HttpResponse : public std::ostream {
 
     const char_type* data() const noexcept { return buf_.data(); }
     std::streamsize size() const noexcept { return buf_.size(); }
-    void reset(int status, const char* reason, bool cache = false);
+    void reset(int status, const char* reason, bool cache = false,
+               const char* contentType = "application/json");
     void setContentLength() noexcept;
 
   private:
@@ -24,13 +24,24 @@ using namespace std;
 using asio::ip::tcp;
 
 namespace swirly {
+namespace {
 
-HttpServ::HttpServ(asio::io_service& ioServ, uint16_t port, RestServ& restServ)
-    : ioServ_(ioServ), acceptor_{ioServ}, restServ_(restServ)
+// Allows each I/O thread to bind its own acceptor to the same port. The kernel distributes incoming
+// connections between them.
+using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+} // anonymous
+
+HttpServ::HttpServ(asio::io_service& ioServ, uint16_t port, RestServ& restServ,
+                   EngineRouter* router)
+    : ioServ_(ioServ), acceptor_{ioServ}, restServ_(restServ), router_{router}
 {
     tcp::endpoint endpoint{tcp::v4(), port};
     acceptor_.open(endpoint.protocol());
     acceptor_.set_option(tcp::acceptor::reuse_address{true});
+    if (router) {
+        acceptor_.set_option(ReusePort{true});
+    }
     acceptor_.bind(endpoint);
     acceptor_.listen();
 
@@ -41,7 +52,7 @@ HttpServ::~HttpServ() noexcept = default;
 
 void HttpServ::asyncAccept()
 {
-    auto sess = makeRefCounted<HttpSess>(ioServ_, restServ_);
+    auto sess = makeRefCounted<HttpSess>(ioServ_, restServ_, router_);
     acceptor_.async_accept(sess->socket(), [this, sess](auto ec) {
         if (!ec) {
             sess->start();
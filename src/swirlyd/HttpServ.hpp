@@ -26,11 +26,17 @@
 
 namespace swirly {
 
+class EngineRouter;
 class RestServ;
 
 class HttpServ {
   public:
-    HttpServ(boost::asio::io_service& ioServ, std::uint16_t port, RestServ& restServ);
+    /**
+     * If an engine router is specified, then requests are submitted to the engine threads, and the
+     * port may be shared with the other I/O threads.
+     */
+    HttpServ(boost::asio::io_service& ioServ, std::uint16_t port, RestServ& restServ,
+             EngineRouter* router = nullptr);
     ~HttpServ() noexcept;
 
     // Copy.
@@ -47,6 +53,7 @@ class HttpServ {
     boost::asio::io_service& ioServ_;
     boost::asio::ip::tcp::acceptor acceptor_;
     RestServ& restServ_;
+    EngineRouter* const router_;
 };
 
 } // swirly
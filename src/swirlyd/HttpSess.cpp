@@ -16,10 +16,12 @@
  */
 #include "HttpSess.hpp"
 
+#include "Engine.hpp"
 #include "HttpResponse.hpp"
 #include "RestServ.hpp"
 
 #include <swirly/util/MemAlloc.hpp>
+#include <swirly/util/Trace.hpp>
 
 using namespace boost;
 using namespace std;
@@ -64,7 +66,12 @@ auto makeAllocHandler(FnT fn)
 
 } // anonymous
 
-HttpSess::~HttpSess() noexcept = default;
+atomic<size_t> HttpSess::count_{0};
+
+HttpSess::~HttpSess() noexcept
+{
+    count_.fetch_sub(1, memory_order_relaxed);
+}
 
 void HttpSess::start()
 {
@@ -85,8 +92,37 @@ void HttpSess::stop() noexcept
     timeout_.cancel(ec);
 }
 
+void HttpSess::onResponse() noexcept
+{
+    inflight_ = false;
+    if (msgStart_ != MonoClock::time_point{}) {
+        trace(TraceStage::Request, msgStart_, MonoClock::now());
+        msgStart_ = {};
+    }
+    req_.clear();
+    if (!sock_.is_open()) {
+        // Session was stopped while the request was in flight.
+        return;
+    }
+    try {
+        // Start writing unless a previous response is still being written.
+        if (outbuf_.size() == 1) {
+            asyncWrite();
+        }
+        // Resume parsing of buffered input.
+        parse();
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR(logMsg() << "exception handling response: " << e.what());
+        stop();
+    }
+}
+
 void HttpSess::parse()
 {
+    if (inflight_) {
+        // Parsing resumes when the response is returned.
+        return;
+    }
     const auto size = asio::buffer_size(inbuf_);
     if (size > 0) {
         const auto* data = asio::buffer_cast<const char*>(inbuf_);
@@ -106,7 +142,7 @@ void HttpSess::resetTimeout()
     // prevent this.
     system::error_code ec;
     timeout_.cancel(ec);
-    timeout_.expires_from_now(posix_time::seconds{IdleTimeout});
+    timeout_.expires_from_now(posix_time::seconds{long{IdleTimeout}});
 
     HttpSessPtr session{this};
     timeout_.async_wait([this, session](auto ec) {
@@ -173,7 +209,8 @@ void HttpSess::onWrite() noexcept
     const auto wasFull = outbuf_.full();
     outbuf_.pop();
     try {
-        if (!outbuf_.empty()) {
+        // The last response is incomplete while its request is in flight.
+        if (outbuf_.size() > (inflight_ ? 1 : 0)) {
             asyncWrite();
         }
         if (wasFull) {
@@ -185,6 +222,15 @@ void HttpSess::onWrite() noexcept
     }
 }
 
+bool HttpSess::onMessageBegin() noexcept
+{
+    if (isTraceEnabled()) {
+        beginTrace();
+        msgStart_ = MonoClock::now();
+    }
+    return true;
+}
+
 bool HttpSess::onUrl(string_view sv) noexcept
 {
     bool ret{false};
@@ -237,6 +283,7 @@ bool HttpSess::onBody(string_view sv) noexcept
 {
     bool ret{false};
     try {
+        TraceScope ts{TraceStage::Body};
         req_.appendBody(sv);
         ret = true;
     } catch (const std::exception& e) {
@@ -252,12 +299,26 @@ bool HttpSess::onMessageEnd() noexcept
     bool ret{false};
     try {
         req_.flush(); // May throw.
+        if (msgStart_ != MonoClock::time_point{}) {
+            trace(TraceStage::Http, msgStart_, MonoClock::now());
+        }
         const auto wasEmpty = outbuf_.empty();
         outbuf_.write([](auto& ref) { ref.clear(); });
+        if (router_) {
+            // Suspend parsing until the engine thread has handled the request.
+            inflight_ = true;
+            pause();
+            router_->submit(*this, req_, outbuf_.back());
+            return true;
+        }
         {
             HttpResponse resp{outbuf_.back()};
             restServ_.handleRequest(req_, resp);
         }
+        if (msgStart_ != MonoClock::time_point{}) {
+            trace(TraceStage::Request, msgStart_, MonoClock::now());
+            msgStart_ = {};
+        }
         if (outbuf_.full()) {
             // Interrupt parser if output buffer is full.
             pause();
@@ -24,6 +24,9 @@
 #include <swirly/util/Log.hpp>
 #include <swirly/util/RefCounted.hpp>
 #include <swirly/util/RingBuffer.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <atomic>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
@@ -32,6 +35,7 @@
 
 namespace swirly {
 
+class EngineRouter;
 class HttpResponse;
 class RestServ;
 
@@ -41,12 +45,18 @@ class HttpSess : public RefCounted<HttpSess>, public BasicHttpHandler<HttpSess>
     enum { IdleTimeout = 5, MaxData = 4096 };
 
   public:
-    HttpSess(boost::asio::io_service& ioServ, RestServ& restServ)
+    /**
+     * Requests are handled inline by the RestServ, unless an engine router is specified, in which
+     * case they are submitted to an engine thread.
+     */
+    HttpSess(boost::asio::io_service& ioServ, RestServ& restServ, EngineRouter* router = nullptr)
         : BasicHttpHandler<HttpSess>{HttpType::Request},
           sock_{ioServ},
           timeout_{ioServ},
-          restServ_(restServ)
+          restServ_(restServ),
+          router_{router}
     {
+        count_.fetch_add(1, std::memory_order_relaxed);
     }
     ~HttpSess() noexcept;
 
@@ -58,6 +68,11 @@ class HttpSess : public RefCounted<HttpSess>, public BasicHttpHandler<HttpSess>
     HttpSess(HttpSess&&) = delete;
     HttpSess& operator=(HttpSess&&) = delete;
 
+    /**
+     * @return the number of live sessions.
+     */
+    static std::size_t count() noexcept { return count_.load(std::memory_order_relaxed); }
+
     LogMsg& logMsg() noexcept
     {
         auto& ref = swirly::logMsg();
@@ -69,6 +84,10 @@ class HttpSess : public RefCounted<HttpSess>, public BasicHttpHandler<HttpSess>
     void start();
     void stop() noexcept;
     auto& socket() noexcept { return sock_; }
+    /**
+     * Called on the I/O thread when the engine thread has handled the current request.
+     */
+    void onResponse() noexcept;
 
   private:
     void parse();
@@ -79,7 +98,7 @@ class HttpSess : public RefCounted<HttpSess>, public BasicHttpHandler<HttpSess>
     void onReadSome(std::size_t len) noexcept;
     void onWrite() noexcept;
 
-    bool onMessageBegin() noexcept { return true; }
+    bool onMessageBegin() noexcept;
     bool onUrl(std::string_view sv) noexcept;
     bool onStatus(std::string_view sv) noexcept
     {
@@ -98,9 +117,16 @@ class HttpSess : public RefCounted<HttpSess>, public BasicHttpHandler<HttpSess>
     // Close session if client is inactive.
     boost::asio::deadline_timer timeout_;
     RestServ& restServ_;
+    EngineRouter* const router_;
+    // True while the current request is being handled by the engine thread.
+    bool inflight_{false};
     char data_[MaxData];
     boost::asio::const_buffer inbuf_;
     HttpRequest req_;
+    // Start of the current message, if tracing is enabled.
+    MonoClock::time_point msgStart_{};
+
+    static std::atomic<std::size_t> count_;
     RingBuffer<std::string> outbuf_{8};
 };
 
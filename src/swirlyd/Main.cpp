@@ -14,6 +14,7 @@
  * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
  * 02110-1301, USA.
  */
+#include "Engine.hpp"
 #include "HttpServ.hpp"
 #include "RestServ.hpp"
 
@@ -23,12 +24,16 @@
 
 #include <swirly/fin/Journ.hpp>
 #include <swirly/fin/Model.hpp>
+#include <swirly/fin/Snap.hpp>
 
+#include <swirly/util/BinLog.hpp>
 #include <swirly/util/Conf.hpp>
 #include <swirly/util/Exception.hpp>
+#include <swirly/util/Finally.hpp>
 #include <swirly/util/Log.hpp>
 #include <swirly/util/MemCtx.hpp>
 #include <swirly/util/System.hpp>
+#include <swirly/util/Trace.hpp>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
@@ -39,6 +44,7 @@
 
 #include <iomanip>
 #include <iostream>
+#include <thread>
 
 #include <fcntl.h> // open()
 #include <syslog.h>
@@ -118,6 +124,195 @@ class SigHandler {
     fs::path logFile_;
 };
 
+class SnapTimer {
+  public:
+    SnapTimer(boost::asio::io_service& ioServ, Rest& rest, const char* path, Seconds interval)
+        : timer_{ioServ}, rest_(rest), path_{path}, interval_{interval}
+    {
+        wait();
+    }
+    ~SnapTimer() noexcept = default;
+
+    // Copy.
+    SnapTimer(const SnapTimer&) = delete;
+    SnapTimer& operator=(const SnapTimer&) = delete;
+
+    // Move.
+    SnapTimer(SnapTimer&&) = delete;
+    SnapTimer& operator=(SnapTimer&&) = delete;
+
+  private:
+    void wait()
+    {
+        // The timer runs on the engine thread, so snapshots are only taken between requests.
+        timer_.expires_from_now(boost::posix_time::seconds{interval_.count()});
+        timer_.async_wait([this](auto ec) {
+            if (!ec) {
+                try {
+                    rest_.snapshot(path_, UnixClock::now());
+                } catch (const exception& e) {
+                    SWIRLY_ERROR(logMsg() << "failed to write snapshot: " << e.what());
+                }
+                this->wait();
+            }
+        });
+    }
+
+    boost::asio::deadline_timer timer_;
+    Rest& rest_;
+    const char* const path_;
+    const Seconds interval_;
+};
+
+/**
+ * Runs the end-of-day process periodically. A run that does not complete within its time slice is
+ * continued on the next turn of the event loop, so that requests are handled between slices.
+ */
+class EodTimer {
+  public:
+    EodTimer(boost::asio::io_service& ioServ, Rest& rest, Seconds interval, Micros slice)
+        : ioServ_(ioServ), timer_{ioServ}, rest_(rest), interval_{interval}, slice_{slice}
+    {
+        // Start with a run, because markets may have closed while the engine was down.
+        ioServ_.post([this]() { this->run(); });
+    }
+    ~EodTimer() noexcept = default;
+
+    // Copy.
+    EodTimer(const EodTimer&) = delete;
+    EodTimer& operator=(const EodTimer&) = delete;
+
+    // Move.
+    EodTimer(EodTimer&&) = delete;
+    EodTimer& operator=(EodTimer&&) = delete;
+
+  private:
+    void wait()
+    {
+        timer_.expires_from_now(boost::posix_time::seconds{interval_.count()});
+        timer_.async_wait([this](auto ec) {
+            if (!ec) {
+                this->run();
+            }
+        });
+    }
+    void run()
+    {
+        bool done{true};
+        try {
+            done = rest_.endOfDay(UnixClock::now(), slice_);
+        } catch (const exception& e) {
+            SWIRLY_ERROR(logMsg() << "failed to run end of day: " << e.what());
+        }
+        if (done) {
+            this->wait();
+        } else {
+            ioServ_.post([this]() { this->run(); });
+        }
+    }
+
+    boost::asio::io_service& ioServ_;
+    boost::asio::deadline_timer timer_;
+    Rest& rest_;
+    const Seconds interval_;
+    const Micros slice_;
+};
+
+/**
+ * Runs the engine for one of the shards on a dedicated thread. Each engine has its own RestServ,
+ * because the RestServ holds per-request state.
+ */
+class EngineThread {
+  public:
+    EngineThread(Rest& rest, const MemCtx& memCtx)
+        : ioServ_{1}, restServ_{rest, memCtx}, engine_{ioServ_, restServ_}
+    {
+    }
+    ~EngineThread() noexcept { stop(); }
+
+    // Copy.
+    EngineThread(const EngineThread&) = delete;
+    EngineThread& operator=(const EngineThread&) = delete;
+
+    // Move.
+    EngineThread(EngineThread&&) = delete;
+    EngineThread& operator=(EngineThread&&) = delete;
+
+    Engine& engine() noexcept { return engine_; }
+
+    /**
+     * Start the thread once the I/O threads have attached their links to the engine.
+     */
+    void start() { thread_ = thread{[this]() { this->run(); }}; }
+
+    void stop() noexcept
+    {
+        ioServ_.stop();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+  private:
+    void run() noexcept
+    {
+        try {
+            ioServ_.run();
+        } catch (const exception& e) {
+            SWIRLY_ERROR(logMsg() << "exception on engine thread: " << e.what());
+        }
+    }
+
+    boost::asio::io_service ioServ_;
+    RestServ restServ_;
+    Engine engine_;
+    thread thread_;
+};
+
+/**
+ * Accepts connections and parses requests on a dedicated thread. Requests are handled by the engine
+ * threads, and responses are written back on this thread.
+ */
+class IoThread {
+  public:
+    IoThread(ArrayView<Engine*> engines, uint16_t port, RestServ& restServ, const Rest& rest,
+             size_t capacity)
+        : ioServ_{1},
+          router_{ioServ_, rest, engines, capacity},
+          serv_{ioServ_, port, restServ, &router_},
+          thread_{[this]() { this->run(); }}
+    {
+    }
+    ~IoThread() noexcept
+    {
+        ioServ_.stop();
+        thread_.join();
+    }
+
+    // Copy.
+    IoThread(const IoThread&) = delete;
+    IoThread& operator=(const IoThread&) = delete;
+
+    // Move.
+    IoThread(IoThread&&) = delete;
+    IoThread& operator=(IoThread&&) = delete;
+
+  private:
+    void run() noexcept
+    {
+        try {
+            ioServ_.run();
+        } catch (const exception& e) {
+            SWIRLY_ERROR(logMsg() << "exception on io thread: " << e.what());
+        }
+    }
+
+    boost::asio::io_service ioServ_;
+    EngineRouter router_;
+    HttpServ serv_;
+    thread thread_;
+};
+
 struct Opts {
     fs::path confFile;
     bool daemon{false};
@@ -219,7 +414,12 @@ int main(int argc, char* argv[])
             conf.read(is);
         }
 
-        memCtx = MemCtx{conf.get<size_t>("mem_size", 1) << 20};
+        MemOpts memOpts;
+        memOpts.hugePages = conf.get("mem_hugepages", false);
+        memOpts.prefault = conf.get("mem_prefault", false);
+        memOpts.lock = conf.get("mem_lock", false);
+        memOpts.maxSegments = conf.get<size_t>("mem_max_segments", 16);
+        memCtx = MemCtx{conf.get<size_t>("mem_size", 1) << 20, memOpts};
 
         const char* const logLevel{conf.get("log_level", nullptr)};
         if (logLevel) {
@@ -278,25 +478,99 @@ int main(int argc, char* argv[])
             openLogFile(logFile.c_str());
         }
 
+        // Calibrate the clocks before any threads are started, rather than on first use by a
+        // request.
+        MonoClock::calibrate();
+
+        const bool logAsync{conf.get("log_async", false) && getLogger() == stdLogger};
+        const auto logAsyncCapacity = conf.get<size_t>("log_async_capacity", 1 << 10);
+        if (logAsync) {
+            startAsyncLogger(logAsyncCapacity);
+            setLogger(asyncLogger);
+        }
+        auto finally = makeFinally([logAsync]() {
+            if (logAsync) {
+                setLogger(stdLogger);
+                stopAsyncLogger();
+                const auto drops = asyncLogDrops();
+                if (drops > 0) {
+                    SWIRLY_WARNING(logMsg() << "dropped " << drops << " log messages");
+                }
+            }
+        });
+
         const char* const httpPort{conf.get("http_port", "8080")};
+        const auto httpThreads = conf.get<size_t>("http_threads", 0);
+        const auto httpCapacity = conf.get<size_t>("http_capacity", 1 << 8);
+        const auto engineShards = max<size_t>(conf.get<size_t>("engine_shards", 1), 1);
         const auto pipeCapacity = conf.get<size_t>("pipe_capacity", 1 << 10);
         const auto maxExecs = conf.get<size_t>("max_execs", 1 << 4);
+        const auto pipeIdle = toPipeIdle(conf.get("pipe_idle", "park"));
+        const auto batchSize = conf.get<size_t>("journ_batch_size", 1 << 6);
+        const Micros batchLatency{conf.get<long>("journ_batch_latency", 1000)};
+        const char* const snapFile{conf.get("snapshot_file", "")};
+        const Seconds snapInterval{conf.get<long>("snapshot_interval", 300)};
+        const Seconds eodInterval{conf.get<long>("eod_interval", 0)};
+        const Micros eodSlice{conf.get<long>("eod_slice", 1000)};
+        const char* const traceFile{conf.get("trace_file", "")};
+        const auto traceCapacity = conf.get<size_t>("trace_capacity", 1 << 14);
+        const char* const binLogFile{conf.get("binlog_file", "")};
+        const auto binLogCapacity = conf.get<size_t>("binlog_capacity", 1 << 20);
 
         SWIRLY_NOTICE("initialising daemon");
-        SWIRLY_INFO(logMsg() << "conf_file:     " << opts.confFile);
-        SWIRLY_INFO(logMsg() << "daemon:        " << (opts.daemon ? "yes" : "no"));
-        SWIRLY_INFO(logMsg() << "start_time:    " << opts.startTime);
-        SWIRLY_INFO(logMsg() << "test_mode:     " << (opts.test ? "yes" : "no"));
-
-        SWIRLY_INFO(logMsg() << "mem_size:      " << (memCtx.maxSize() >> 20) << "MiB");
-        SWIRLY_INFO(logMsg() << "file_mode:     " << setfill('0') << setw(3) << oct
+        SWIRLY_INFO(logMsg() << "conf_file:           " << opts.confFile);
+        SWIRLY_INFO(logMsg() << "daemon:              " << (opts.daemon ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "start_time:          " << opts.startTime);
+        SWIRLY_INFO(logMsg() << "test_mode:           " << (opts.test ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "tsc_clock:           " << (MonoClock::isTsc() ? "yes" : "no"));
+
+        SWIRLY_INFO(logMsg() << "mem_size:            " << (memCtx.maxSize() >> 20) << "MiB");
+        SWIRLY_INFO(logMsg() << "mem_hugepages:       " << (memOpts.hugePages ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "mem_prefault:        " << (memOpts.prefault ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "mem_lock:            " << (memOpts.lock ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "mem_max_segments:    " << memOpts.maxSegments);
+        SWIRLY_INFO(logMsg() << "file_mode:           " << setfill('0') << setw(3) << oct
                              << swirly::fileMode());
-        SWIRLY_INFO(logMsg() << "run_dir:       " << runDir);
-        SWIRLY_INFO(logMsg() << "log_file:      " << logFile);
-        SWIRLY_INFO(logMsg() << "log_level:     " << getLogLevel());
-        SWIRLY_INFO(logMsg() << "http_port:     " << httpPort);
-        SWIRLY_INFO(logMsg() << "pipe_capacity: " << pipeCapacity);
-        SWIRLY_INFO(logMsg() << "max_execs:     " << maxExecs);
+        SWIRLY_INFO(logMsg() << "run_dir:             " << runDir);
+        SWIRLY_INFO(logMsg() << "log_file:            " << logFile);
+        SWIRLY_INFO(logMsg() << "log_level:           " << getLogLevel());
+        SWIRLY_INFO(logMsg() << "log_async:           " << (logAsync ? "yes" : "no"));
+        SWIRLY_INFO(logMsg() << "log_async_capacity:  " << logAsyncCapacity);
+        SWIRLY_INFO(logMsg() << "http_port:           " << httpPort);
+        SWIRLY_INFO(logMsg() << "http_threads:        " << httpThreads);
+        SWIRLY_INFO(logMsg() << "http_capacity:       " << httpCapacity);
+        SWIRLY_INFO(logMsg() << "engine_shards:       " << engineShards);
+        SWIRLY_INFO(logMsg() << "journ_type:          " << conf.get("journ_type", "sqlite"));
+        SWIRLY_INFO(logMsg() << "pipe_capacity:       " << pipeCapacity);
+        SWIRLY_INFO(logMsg() << "pipe_idle:           " << pipeIdle);
+        SWIRLY_INFO(logMsg() << "journ_batch_size:    " << batchSize);
+        SWIRLY_INFO(logMsg() << "journ_batch_latency: " << batchLatency.count() << "us");
+        SWIRLY_INFO(logMsg() << "max_execs:           " << maxExecs);
+        SWIRLY_INFO(logMsg() << "snapshot_file:       " << snapFile);
+        SWIRLY_INFO(logMsg() << "snapshot_interval:   " << snapInterval.count() << "s");
+        SWIRLY_INFO(logMsg() << "eod_interval:        " << eodInterval.count() << "s");
+        SWIRLY_INFO(logMsg() << "eod_slice:           " << eodSlice.count() << "us");
+        SWIRLY_INFO(logMsg() << "trace_file:          " << traceFile);
+        SWIRLY_INFO(logMsg() << "trace_capacity:      " << traceCapacity);
+        SWIRLY_INFO(logMsg() << "binlog_file:         " << binLogFile);
+        SWIRLY_INFO(logMsg() << "binlog_capacity:     " << binLogCapacity);
+
+        const bool traceEnabled{traceFile[0] != '\0'};
+        if (traceEnabled) {
+            enableTrace(traceCapacity);
+        }
+        if (binLogFile[0] != '\0') {
+            startBinLog(binLogFile, binLogCapacity);
+        }
+        auto binLogFinally = makeFinally([]() {
+            if (isBinLogEnabled()) {
+                stopBinLog();
+                const auto drops = binLogDrops();
+                if (drops > 0) {
+                    SWIRLY_WARNING(logMsg() << "dropped " << drops << " binary log records");
+                }
+            }
+        });
 
         unique_ptr<Journ> journ;
         if (!opts.test) {
@@ -304,19 +578,90 @@ int main(int argc, char* argv[])
         } else {
             journ = make_unique<TestJourn>();
         }
-        auto model = swirly::makeModel(conf);
-        Rest rest{*journ, pipeCapacity, maxExecs};
+        unique_ptr<Model> model{swirly::makeModel(conf)};
+
+        // Snapshots are tagged with binary journal sequence numbers.
+        const bool snapEnabled{!opts.test && snapFile[0] != '\0'};
+        if (snapEnabled) {
+            if (!iequals(conf.get("journ_type", "sqlite"), "binary"_sv)) {
+                throw Exception{"snapshots require binary journal"_sv};
+            }
+            if (engineShards > 1) {
+                throw Exception{"snapshots require a single engine shard"_sv};
+            }
+            auto snapModel = make_unique<SnapModel>(maxExecs);
+            if (!snapModel->loadSnap(snapFile)) {
+                snapModel->loadModel(*model, opts.startTime);
+            }
+            // Replay only the journal tail that follows the snapshot.
+            snapModel->replay(conf.get("binary_journ", "journ"));
+            if (snapModel->seq() != journ->seq()) {
+                throw Exception{errMsg() << "snapshot sequence " << snapModel->seq()
+                                         << " does not match journal sequence " << journ->seq()};
+            }
+            model = move(snapModel);
+        }
+
+        Rest rest{*journ, pipeCapacity, maxExecs, pipeIdle, batchSize, batchLatency, engineShards};
         rest.load(*model, opts.startTime);
         model = nullptr;
 
-        boost::asio::io_service ioServ;
+        // The main thread is the engine thread for the first shard. It owns the Rest, and runs the
+        // signal handler and the snapshot and end-of-day timers, so that snapshots are only taken
+        // between requests.
+        boost::asio::io_service ioServ{1};
         SigHandler sigHandler{ioServ, logFile};
 
-        RestServ restServ{rest};
-        HttpServ serv{ioServ, stou16(httpPort), restServ};
+        unique_ptr<SnapTimer> snapTimer;
+        if (snapEnabled && snapInterval.count() > 0) {
+            snapTimer = make_unique<SnapTimer>(ioServ, rest, snapFile, snapInterval);
+        }
+        unique_ptr<EodTimer> eodTimer;
+        if (eodInterval.count() > 0) {
+            eodTimer = make_unique<EodTimer>(ioServ, rest, eodInterval, eodSlice);
+        }
+
+        RestServ restServ{rest, memCtx};
+        unique_ptr<HttpServ> serv;
+        unique_ptr<Engine> engine;
+        vector<unique_ptr<EngineThread>> engineThreads;
+        vector<unique_ptr<IoThread>> ioThreads;
+        if (httpThreads == 0) {
+            // Parse requests and handle all shards on the engine thread.
+            serv = make_unique<HttpServ>(ioServ, stou16(httpPort), restServ);
+        } else {
+            engine = make_unique<Engine>(ioServ, restServ);
+            vector<Engine*> engines{engine.get()};
+            for (size_t i{1}; i < engineShards; ++i) {
+                engineThreads.push_back(make_unique<EngineThread>(rest, memCtx));
+                engines.push_back(&engineThreads.back()->engine());
+            }
+            for (size_t i{0}; i < httpThreads; ++i) {
+                ioThreads.push_back(make_unique<IoThread>(engines, stou16(httpPort), restServ,
+                                                          rest, httpCapacity));
+            }
+            for (auto& engineThread : engineThreads) {
+                engineThread->start();
+            }
+        }
 
         SWIRLY_NOTICE(logMsg() << "started http server on port " << httpPort);
         ioServ.run();
+        // Stop the engine threads, then the I/O threads, before the engine state is torn down.
+        for (auto& engineThread : engineThreads) {
+            engineThread->stop();
+        }
+        ioThreads.clear();
+        engineThreads.clear();
+
+        if (snapEnabled) {
+            // Final snapshot, so that the next start has no journal to replay.
+            rest.snapshot(snapFile, UnixClock::now());
+        }
+        if (traceEnabled) {
+            const auto n = writeTrace(traceFile);
+            SWIRLY_NOTICE(logMsg() << "wrote " << n << " trace events to " << traceFile);
+        }
         ret = 0;
 
     } catch (const exception& e) {
@@ -18,21 +18,150 @@
 
 #include "HttpRequest.hpp"
 #include "HttpResponse.hpp"
+#include "HttpSess.hpp"
 
 #include <swirly/ws/Rest.hpp>
 
+#include <swirly/clob/AsyncJourn.hpp>
+
 #include <swirly/fin/Exception.hpp>
 
-#include <swirly/util/Finally.hpp>
+#include <swirly/util/Atomic.hpp>
+#include <swirly/util/BinLog.hpp>
 #include <swirly/util/Log.hpp>
+#include <swirly/util/MemCtx.hpp>
+#include <swirly/util/Trace.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <tuple>
 
 using namespace std;
 
 namespace swirly {
 namespace {
 
+// Route labels. The last is for unknown routes.
+constexpr const char* RouteNames[] = {
+    "/refdata",      "/accnt",        "/accnt/markets", "/accnt/orders",
+    "/accnt/execs",  "/accnt/trades", "/accnt/posns",   "/markets",
+    "/admin",        "/metrics",      "other"};
+
+constexpr const char* MethodNames[] = {"GET", "POST", "PUT", "DELETE", "OTHER"};
+
+// Upper bounds of request latency buckets in microseconds.
+constexpr int64_t LatencyBounds[] = {10,   25,   50,   100,   250,   500,
+                                     1000, 2500, 5000, 10000, 25000, 100000};
+
+string_view popToken(Tokeniser& toks) noexcept
+{
+    if (toks.empty()) {
+        return {};
+    }
+    auto tok = toks.top();
+    toks.pop();
+    // Support both plural and singular forms.
+    if (!tok.empty() && tok.back() == 's') {
+        tok.remove_suffix(1);
+    }
+    return tok;
+}
+
+int toRoute(string_view path) noexcept
+{
+    if (!path.empty() && path.front() == '/') {
+        path.remove_prefix(1);
+    }
+    Tokeniser toks{path, "/"_sv};
+    const auto tok = popToken(toks);
+    if (tok == "refdata"_sv) {
+        return 0;
+    }
+    if (tok == "accnt"_sv) {
+        const auto sub = popToken(toks);
+        if (sub.empty()) {
+            return 1;
+        }
+        const string_view subs[] = {"market"_sv, "order"_sv, "exec"_sv, "trade"_sv, "posn"_sv};
+        for (int i{0}; i < 5; ++i) {
+            if (sub == subs[i]) {
+                return 2 + i;
+            }
+        }
+    } else if (tok == "market"_sv) {
+        return 7;
+    } else if (tok == "admin"_sv) {
+        return 8;
+    } else if (tok == "metric"_sv) {
+        return 9;
+    }
+    return 10;
+}
+
+int toMethod(HttpMethod method) noexcept
+{
+    switch (method) {
+    case HttpMethod::Get:
+        return 0;
+    case HttpMethod::Post:
+        return 1;
+    case HttpMethod::Put:
+        return 2;
+    case HttpMethod::Delete:
+        return 3;
+    default:
+        break;
+    }
+    return 4;
+}
+
+double toSeconds(Nanos ns) noexcept
+{
+    return ns.count() / 1e9;
+}
+
+/**
+ * The time-in-force of new orders is given by the optional "tif" query parameter, so that it may
+ * also be applied to a batch of orders.
+ */
+TimeInForce getTif(const HttpRequest& req)
+{
+    auto tif = TimeInForce::Gtc;
+    Tokeniser toks{req.query(), "&;"_sv};
+    while (!toks.empty()) {
+        string_view key, val;
+        tie(key, val) = splitPair(toks.top(), '=');
+        if (key == "tif"_sv) {
+            if (val == "GTC"_sv) {
+                tif = TimeInForce::Gtc;
+            } else if (val == "IOC"_sv) {
+                tif = TimeInForce::Ioc;
+            } else if (val == "FOK"_sv) {
+                tif = TimeInForce::Fok;
+            } else {
+                throw InvalidException{errMsg() << "invalid tif '" << val << '\''};
+            }
+        }
+        toks.pop();
+    }
+    return tif;
+}
+
+/**
+ * RestServ instances, so that /metrics can report the counters of all engine threads.
+ */
+struct Registry {
+    mutex servsMutex;
+    vector<const RestServ*> servs;
+};
+
+Registry& registry() noexcept
+{
+    static Registry registry;
+    return registry;
+}
+
 class ScopedIds {
   public:
     ScopedIds(string_view sv, vector<Id64>& ids) noexcept : ids_{ids}
@@ -91,22 +220,35 @@ string_view getTrader(const HttpRequest& req)
 
 } // anonymous
 
-RestServ::~RestServ() noexcept = default;
+RestServ::RestServ(Rest& rest, const MemCtx& memCtx)
+    : rest_(rest), memCtx_(memCtx), profile_{"profile"_sv}
+{
+    static_assert(sizeof(LatencyBounds) / sizeof(LatencyBounds[0]) == LatencyBuckets,
+                  "latency bucket mismatch");
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.servsMutex};
+    reg.servs.push_back(this);
+}
+
+RestServ::~RestServ() noexcept
+{
+    auto& reg = registry();
+    lock_guard<mutex> lock{reg.servsMutex};
+    reg.servs.erase(remove(reg.servs.begin(), reg.servs.end(), this), reg.servs.end());
+}
 
 void RestServ::handleRequest(const HttpRequest& req, HttpResponse& resp) noexcept
 {
-    TimeRecorder tr{profile_};
-    auto finally = makeFinally([this]() {
-        if (this->profile_.size() % 10 == 0) {
-            this->profile_.report();
-        }
-    });
+    const auto start = MonoClock::now();
+    TraceScope ts{TraceStage::Rest};
     const auto cache = reset(req); // noexcept
     const auto now = getTime(req); // noexcept
 
+    int status{200};
     if (req.method() != HttpMethod::Delete) {
         resp.reset(200, "OK", cache); // noexcept
     } else {
+        status = 204;
         resp.reset(204, "No Content"); // noexcept
     }
     try {
@@ -125,10 +267,11 @@ void RestServ::handleRequest(const HttpRequest& req, HttpResponse& resp) noexcep
     } catch (const ServException& e) {
         SWIRLY_ERROR(logMsg() << "exception: status=" << e.httpStatus()
                               << ", reason=" << e.httpReason() << ", detail=" << e.what());
+        status = e.httpStatus();
         resp.reset(e.httpStatus(), e.httpReason());
         resp << e;
     } catch (const exception& e) {
-        const int status{500};
+        status = 500;
         const char* const reason{"Internal Server Error"};
         SWIRLY_ERROR(logMsg() << "exception: status=" << status << ", reason=" << reason
                               << ", detail=" << e.what());
@@ -136,6 +279,20 @@ void RestServ::handleRequest(const HttpRequest& req, HttpResponse& resp) noexcep
         ServException::toJson(status, reason, e.what(), resp);
     }
     resp.setContentLength(); // noexcept
+
+    const auto elapsed = MonoClock::now() - start;
+    const auto ns = chrono::duration_cast<Nanos>(elapsed).count();
+    singleWriterAdd(requests_[toRoute(req.path())][toMethod(req.method())], 1);
+    singleWriterAdd(responses_[min(max(status / 100, 1), int{StatusClasses}) - 1], 1);
+    // The first bucket whose upper bound is not exceeded, or the overflow bucket.
+    const auto* const bucket = find_if(begin(LatencyBounds), end(LatencyBounds),
+                                       [ns](auto us) { return ns <= us * 1000; });
+    singleWriterAdd(latencies_[bucket - begin(LatencyBounds)], 1);
+    singleWriterAdd(latencySum_, ns);
+    profile_.record(elapsed);
+    if (profile_.size() % 10 == 0) {
+        profile_.report();
+    }
 }
 
 bool RestServ::reset(const HttpRequest& req) noexcept
@@ -173,6 +330,12 @@ void RestServ::restRequest(const HttpRequest& req, Time now, HttpResponse& resp)
     } else if (tok == "accnt"_sv) {
         // /accnt
         accntRequest(req, now, resp);
+    } else if (tok == "admin"_sv) {
+        // /admin
+        adminRequest(req, resp);
+    } else if (tok == "metrics"_sv) {
+        // /metrics
+        metricsRequest(req, resp);
     } else {
         // Support both plural and singular forms.
         if (!tok.empty() && tok.back() == 's') {
@@ -185,6 +348,213 @@ void RestServ::restRequest(const HttpRequest& req, Time now, HttpResponse& resp)
     }
 }
 
+void RestServ::adminRequest(const HttpRequest& req, HttpResponse& resp)
+{
+    if (path_.empty()) {
+        return;
+    }
+
+    const auto tok = path_.top();
+    path_.pop();
+
+    if (tok == "mem"_sv) {
+
+        if (path_.empty()) {
+
+            // /admin/mem
+            matchPath_ = true;
+
+            if (req.method() == HttpMethod::Get) {
+                // GET /admin/mem
+                matchMethod_ = true;
+                getAdmin(req);
+                resp << memCtx_.stats();
+            }
+        }
+    }
+}
+
+void RestServ::metricsRequest(const HttpRequest& req, HttpResponse& resp)
+{
+    if (!path_.empty()) {
+        return;
+    }
+
+    // /metrics
+    matchPath_ = true;
+
+    if (req.method() != HttpMethod::Get) {
+        return;
+    }
+
+    // GET /metrics
+    matchMethod_ = true;
+
+    // Prometheus text exposition format.
+    resp.reset(200, "OK", false, "text/plain; version=0.0.4");
+
+    uint64_t requests[Routes][Methods]{};
+    uint64_t responses[StatusClasses]{};
+    uint64_t latencies[LatencyBuckets + 1]{};
+    int64_t latencySum{0};
+    {
+        // Guards the registry only; the counters are read without blocking their writers.
+        auto& reg = registry();
+        lock_guard<mutex> lock{reg.servsMutex};
+        for (const auto* serv : reg.servs) {
+            for (int i{0}; i < Routes; ++i) {
+                for (int j{0}; j < Methods; ++j) {
+                    requests[i][j] += serv->requests_[i][j].load(memory_order_relaxed);
+                }
+            }
+            for (int i{0}; i < StatusClasses; ++i) {
+                responses[i] += serv->responses_[i].load(memory_order_relaxed);
+            }
+            for (int i{0}; i <= LatencyBuckets; ++i) {
+                latencies[i] += serv->latencies_[i].load(memory_order_relaxed);
+            }
+            latencySum += serv->latencySum_.load(memory_order_relaxed);
+        }
+    }
+
+    resp << "# HELP swirly_http_requests_total HTTP requests by route and method.\n"
+            "# TYPE swirly_http_requests_total counter\n";
+    for (int i{0}; i < Routes; ++i) {
+        for (int j{0}; j < Methods; ++j) {
+            if (requests[i][j] > 0) {
+                resp << "swirly_http_requests_total{route=\"" << RouteNames[i] << "\",method=\""
+                     << MethodNames[j] << "\"} " << requests[i][j] << '\n';
+            }
+        }
+    }
+    resp << "# HELP swirly_http_responses_total HTTP responses by status class.\n"
+            "# TYPE swirly_http_responses_total counter\n";
+    for (int i{0}; i < StatusClasses; ++i) {
+        resp << "swirly_http_responses_total{code=\"" << i + 1 << "xx\"} " << responses[i]
+             << '\n';
+    }
+
+    resp << "# HELP swirly_http_request_duration_seconds HTTP request latency.\n"
+            "# TYPE swirly_http_request_duration_seconds histogram\n";
+    // Prometheus buckets are cumulative.
+    uint64_t count{0};
+    for (int i{0}; i < LatencyBuckets; ++i) {
+        count += latencies[i];
+        resp << "swirly_http_request_duration_seconds_bucket{le=\"" << LatencyBounds[i] / 1e6
+             << "\"} " << count << '\n';
+    }
+    count += latencies[LatencyBuckets];
+    resp << "swirly_http_request_duration_seconds_bucket{le=\"+Inf\"} " << count << '\n'
+         << "swirly_http_request_duration_seconds_sum " << latencySum / 1e9 << '\n'
+         << "swirly_http_request_duration_seconds_count " << count << '\n';
+
+    resp << "# HELP swirly_http_sessions Active HTTP sessions.\n"
+            "# TYPE swirly_http_sessions gauge\n"
+            "swirly_http_sessions "
+         << HttpSess::count() << '\n';
+
+    // Counters are summed across engine shards.
+    uint64_t orders{0}, revises{0}, cancels{0}, matches{0};
+    size_t depth{0}, capacity{0};
+    uint64_t stalls{0}, msgs{0}, batches{0};
+    Nanos stallTime{0}, commitTime{0};
+    for (size_t i{0}; i < rest_.shards(); ++i) {
+        const auto& serv = rest_.serv(i);
+        const auto& stats = serv.stats();
+        orders += stats.orders();
+        revises += stats.revises();
+        cancels += stats.cancels();
+        matches += stats.matches();
+        const auto& journ = serv.journ();
+        const auto& journStats = journ.stats();
+        depth += journ.depth();
+        capacity += journ.capacity();
+        stalls += journ.stalls();
+        stallTime += journ.stallTime();
+        msgs += journStats.msgs();
+        batches += journStats.batches();
+        commitTime += journStats.commitTime();
+    }
+    resp << "# HELP swirly_engine_shards Engine shards.\n"
+            "# TYPE swirly_engine_shards gauge\n"
+            "swirly_engine_shards "
+         << rest_.shards() << '\n'
+         << "# HELP swirly_orders_total Orders created.\n"
+            "# TYPE swirly_orders_total counter\n"
+            "swirly_orders_total "
+         << orders << '\n'
+         << "# HELP swirly_revises_total Orders revised.\n"
+            "# TYPE swirly_revises_total counter\n"
+            "swirly_revises_total "
+         << revises << '\n'
+         << "# HELP swirly_cancels_total Orders cancelled.\n"
+            "# TYPE swirly_cancels_total counter\n"
+            "swirly_cancels_total "
+         << cancels << '\n'
+         << "# HELP swirly_matches_total Matches between taker and maker orders.\n"
+            "# TYPE swirly_matches_total counter\n"
+            "swirly_matches_total "
+         << matches << '\n';
+
+    resp << "# HELP swirly_journ_queue_depth Messages waiting for the journal thread.\n"
+            "# TYPE swirly_journ_queue_depth gauge\n"
+            "swirly_journ_queue_depth "
+         << depth << '\n'
+         << "# HELP swirly_journ_queue_capacity Capacity of the journal pipe.\n"
+            "# TYPE swirly_journ_queue_capacity gauge\n"
+            "swirly_journ_queue_capacity "
+         << capacity << '\n'
+         << "# HELP swirly_journ_stalls_total Writes that waited for space in the journal pipe.\n"
+            "# TYPE swirly_journ_stalls_total counter\n"
+            "swirly_journ_stalls_total "
+         << stalls << '\n'
+         << "# HELP swirly_journ_stall_seconds_total Time spent waiting for the journal pipe.\n"
+            "# TYPE swirly_journ_stall_seconds_total counter\n"
+            "swirly_journ_stall_seconds_total "
+         << toSeconds(stallTime) << '\n'
+         << "# HELP swirly_journ_msgs_total Messages committed to the journal.\n"
+            "# TYPE swirly_journ_msgs_total counter\n"
+            "swirly_journ_msgs_total "
+         << msgs << '\n'
+         << "# HELP swirly_journ_batches_total Batches committed to the journal.\n"
+            "# TYPE swirly_journ_batches_total counter\n"
+            "swirly_journ_batches_total "
+         << batches << '\n'
+         << "# HELP swirly_journ_commit_seconds_total Time spent committing batches.\n"
+            "# TYPE swirly_journ_commit_seconds_total counter\n"
+            "swirly_journ_commit_seconds_total "
+         << toSeconds(commitTime) << '\n';
+
+    resp << "# HELP swirly_log_drops_total Log messages dropped by the asynchronous logger.\n"
+            "# TYPE swirly_log_drops_total counter\n"
+            "swirly_log_drops_total "
+         << asyncLogDrops() << '\n'
+         << "# HELP swirly_binlog_drops_total Binary log records dropped.\n"
+            "# TYPE swirly_binlog_drops_total counter\n"
+            "swirly_binlog_drops_total "
+         << binLogDrops() << '\n';
+
+    const auto mem = memCtx_.stats();
+    resp << "# HELP swirly_mem_segments Memory segments in use.\n"
+            "# TYPE swirly_mem_segments gauge\n"
+            "swirly_mem_segments "
+         << mem.segments << '\n'
+         << "# HELP swirly_mem_max_segments Maximum memory segments.\n"
+            "# TYPE swirly_mem_max_segments gauge\n"
+            "swirly_mem_max_segments "
+         << mem.maxSegments << '\n'
+         << "# HELP swirly_mem_reserved_bytes Bytes reserved from memory segments.\n"
+            "# TYPE swirly_mem_reserved_bytes gauge\n"
+            "swirly_mem_reserved_bytes "
+         << mem.reserved << '\n'
+         << "# HELP swirly_mem_blocks_in_use Allocated blocks by size class.\n"
+            "# TYPE swirly_mem_blocks_in_use gauge\n";
+    for (const auto& cs : mem.classes) {
+        resp << "swirly_mem_blocks_in_use{size=\"" << cs.blockSize << "\"} "
+             << static_cast<int64_t>(cs.allocs - cs.frees) << '\n';
+    }
+}
+
 void RestServ::refDataRequest(const HttpRequest& req, Time now, HttpResponse& resp)
 {
     if (path_.empty()) {
@@ -461,6 +831,26 @@ void RestServ::marketRequest(const HttpRequest& req, Time now, HttpResponse& res
         }
         return;
     }
+
+    const auto tok = popToken(path_);
+
+    if (path_.empty() && tok == "order"_sv) {
+
+        // /market/INSTR/SETTL_DATE/orders
+        matchPath_ = true;
+
+        switch (req.method()) {
+        case HttpMethod::Delete:
+            // DELETE /market/INSTR/SETTL_DATE/orders
+            matchMethod_ = true;
+            getAdmin(req);
+            rest_.deleteMarketOrder(instr, settlDate, now);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
 }
 
 void RestServ::orderRequest(const HttpRequest& req, Time now, HttpResponse& resp)
@@ -490,9 +880,14 @@ void RestServ::orderRequest(const HttpRequest& req, Time now, HttpResponse& resp
                 }
                 rest_.postOrder(accnt, req.body().instr(), req.body().settlDate(), req.body().ref(),
                                 req.body().side(), req.body().lots(), req.body().ticks(),
-                                req.body().minLots(), now, resp);
+                                req.body().minLots(), getTif(req), now, resp);
             }
             break;
+        case HttpMethod::Delete:
+            // DELETE /accnt/orders
+            matchMethod_ = true;
+            rest_.deleteOrder(getTrader(req), now);
+            break;
         default:
             break;
         }
@@ -527,7 +922,7 @@ void RestServ::orderRequest(const HttpRequest& req, Time now, HttpResponse& resp
                 }
                 rest_.postOrder(accnt, instr, req.body().settlDate(), req.body().ref(),
                                 req.body().side(), req.body().lots(), req.body().ticks(),
-                                req.body().minLots(), now, resp);
+                                req.body().minLots(), getTif(req), now, resp);
             }
             break;
         default:
@@ -558,12 +953,28 @@ void RestServ::orderRequest(const HttpRequest& req, Time now, HttpResponse& resp
                 const auto accnt = getTrader(req);
                 constexpr auto ReqFields = RestBody::Side | RestBody::Lots | RestBody::Ticks;
                 constexpr auto OptFields = RestBody::Ref | RestBody::MinLots;
+                if (req.array()) {
+                    // Batch of orders.
+                    const auto& bodies = req.bodies();
+                    const auto tif = getTif(req);
+                    specs_.clear();
+                    for (size_t i{0}; i < bodies.size(); ++i) {
+                        const auto& body = bodies[i];
+                        if (!body.valid(ReqFields, OptFields)) {
+                            throw InvalidException{"request fields are invalid"_sv};
+                        }
+                        specs_.push_back({body.ref(), body.side(), body.lots(), body.ticks(),
+                                          body.minLots(), tif});
+                    }
+                    rest_.postOrders(accnt, instr, settlDate, specs_, now, resp);
+                    break;
+                }
                 if (!req.body().valid(ReqFields, OptFields)) {
                     throw InvalidException{"request fields are invalid"_sv};
                 }
                 rest_.postOrder(accnt, instr, settlDate, req.body().ref(), req.body().side(),
-                                req.body().lots(), req.body().ticks(), req.body().minLots(), now,
-                                resp);
+                                req.body().lots(), req.body().ticks(), req.body().minLots(),
+                                getTif(req), now, resp);
             }
             break;
         default:
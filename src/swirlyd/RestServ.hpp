@@ -23,17 +23,20 @@
 #include <swirly/util/Time.hpp>
 #include <swirly/util/Tokeniser.hpp>
 
+#include <atomic>
 #include <vector>
 
 namespace swirly {
 
 class HttpRequest;
 class HttpResponse;
+class MemCtx;
+struct OrderSpec;
 class Rest;
 
 class RestServ {
   public:
-    explicit RestServ(Rest& rest) noexcept : rest_(rest), profile_{"profile"_sv} {}
+    RestServ(Rest& rest, const MemCtx& memCtx);
     ~RestServ() noexcept;
 
     // Copy.
@@ -51,6 +54,10 @@ class RestServ {
 
     void restRequest(const HttpRequest& req, Time now, HttpResponse& resp);
 
+    void adminRequest(const HttpRequest& req, HttpResponse& resp);
+
+    void metricsRequest(const HttpRequest& req, HttpResponse& resp);
+
     void refDataRequest(const HttpRequest& req, Time now, HttpResponse& resp);
     void assetRequest(const HttpRequest& req, Time now, HttpResponse& resp);
     void instrRequest(const HttpRequest& req, Time now, HttpResponse& resp);
@@ -63,13 +70,24 @@ class RestServ {
     void tradeRequest(const HttpRequest& req, Time now, HttpResponse& resp);
     void posnRequest(const HttpRequest& req, Time now, HttpResponse& resp);
 
+    enum : int { Routes = 11, Methods = 5, StatusClasses = 5, LatencyBuckets = 12 };
+
     Rest& rest_;
+    const MemCtx& memCtx_;
     bool matchMethod_{false};
     bool matchPath_{false};
     Tokeniser path_;
     std::vector<Id64> ids_;
+    std::vector<OrderSpec> specs_;
     std::vector<Symbol> symbols_;
     Profile profile_;
+    // Request counters by route and method, response counters by status class, and request
+    // latency counters by bucket. Each engine thread has its own RestServ, which is the only writer
+    // of its counters, so that /metrics can sum the counters of all without locking.
+    std::atomic<std::uint64_t> requests_[Routes][Methods]{};
+    std::atomic<std::uint64_t> responses_[StatusClasses]{};
+    std::atomic<std::uint64_t> latencies_[LatencyBuckets + 1]{};
+    std::atomic<std::int64_t> latencySum_{0};
 };
 
 } // swirly
@@ -63,6 +63,38 @@ class Archiver {
     vector<Id64> ids_;
 };
 
+/**
+ * Remove and re-insert resting orders near the touch, so that every operation removes and inserts a
+ * price level.
+ */
+void benchLevels(Profile& profile, size_t ladderTicks, Time now)
+{
+    MarketSide side{ladderTicks};
+    vector<OrderPtr> orders;
+    for (int i = 0; i < 64; ++i) {
+        // Spread orders over the first 64 ticks.
+        const auto ticks = 12345_tks + Ticks{(i * 37) % 64};
+        orders.push_back(Order::make("MARAYL"_sv, 1_id64, "EURUSD"_sv, 0_jd, Id64{i + 1}, ""_sv,
+                                     Side::Sell, 10_lts, ticks, 1_lts, now));
+        side.insertOrder(orders.back());
+    }
+    for (int i = 0; i < 25100; ++i) {
+
+        // Reset profile after warmup period.
+        if (i == 100) {
+            profile.clear();
+        }
+
+        const auto& order = orders[i % orders.size()];
+        TimeRecorder tr{profile};
+        side.removeOrder(*order);
+        side.insertOrder(order);
+    }
+    for (const auto& order : orders) {
+        side.removeOrder(*order);
+    }
+}
+
 MemCtx memCtx;
 
 } // anonymous
@@ -115,6 +147,14 @@ int main(int argc, char* argv[])
         auto& marayl = serv.accnt("MARAYL"_sv);
         auto& pipayl = serv.accnt("PIPAYL"_sv);
 
+        {
+            // Compare level-set implementations.
+            Profile tree{"tree"_sv};
+            Profile ladder{"ladder"_sv};
+            benchLevels(tree, 0, now);
+            benchLevels(ladder, 1024, now);
+        }
+
         Profile maker{"maker"_sv};
         Profile taker{"taker"_sv};
 
@@ -132,80 +172,80 @@ int main(int argc, char* argv[])
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 10_lts, 12348_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 10_lts, 12348_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(marayl, market, ""_sv, Side::Sell, 10_lts, 12348_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(marayl, market, ""_sv, Side::Sell, 10_lts, 12348_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 10_lts, 12347_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 10_lts, 12347_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(marayl, market, ""_sv, Side::Sell, 5_lts, 12347_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(marayl, market, ""_sv, Side::Sell, 5_lts, 12347_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 5_lts, 12346_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(gosayl, market, ""_sv, Side::Sell, 5_lts, 12346_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
 
             // Maker buy-side.
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(marayl, market, ""_sv, Side::Buy, 5_lts, 12344_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(gosayl, market, ""_sv, Side::Buy, 5_lts, 12343_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(gosayl, market, ""_sv, Side::Buy, 5_lts, 12343_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(marayl, market, ""_sv, Side::Buy, 10_lts, 12343_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(marayl, market, ""_sv, Side::Buy, 10_lts, 12343_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(gosayl, market, ""_sv, Side::Buy, 10_lts, 12342_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(gosayl, market, ""_sv, Side::Buy, 10_lts, 12342_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
             {
                 TimeRecorder tr{maker};
                 resp.clear();
-                serv.createOrder(marayl, market, ""_sv, Side::Buy, 10_lts, 12342_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(marayl, market, ""_sv, Side::Buy, 10_lts, 12342_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
 
             // Taker sell-side.
             {
                 TimeRecorder tr{taker};
                 resp.clear();
-                serv.createOrder(eddayl, market, ""_sv, Side::Sell, 40_lts, 12342_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(eddayl, market, ""_sv, Side::Sell, 40_lts, 12342_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
 
             // Taker buy-side.
             {
                 TimeRecorder tr{taker};
                 resp.clear();
-                serv.createOrder(pipayl, market, ""_sv, Side::Buy, 40_lts, 12348_tks, 1_lts, now,
-                                 resp);
+                serv.createOrder(pipayl, market, ""_sv, Side::Buy, 40_lts, 12348_tks, 1_lts,
+                                 TimeInForce::Gtc, now, resp);
             }
 
             arch(eddayl, market.id(), now);
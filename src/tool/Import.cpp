@@ -0,0 +1,84 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/fin/BinJourn.hpp>
+
+#include <swirly/util/Conf.hpp>
+#include <swirly/util/String.hpp>
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+// Records are imported in batches of at most this size, except that batches are extended to the
+// end of any multi-part sequence.
+constexpr size_t BatchSize{1 << 10};
+
+} // anonymous
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+
+        if (argc < 2) {
+            cerr << "usage: swirly_import journ_dir [sqlite_journ [from_seq]]\n";
+            return ret;
+        }
+
+        const char* const dir{argv[1]};
+
+        Conf conf;
+        conf.set("journ_type", "sqlite");
+        if (argc > 2) {
+            conf.set("sqlite_journ", argv[2]);
+        }
+        const uint64_t fromSeq{argc > 3 ? stou64(argv[3]) : 1};
+
+        auto journ = makeJourn(conf);
+
+        vector<Msg> batch;
+        batch.reserve(BatchSize);
+        size_t count{0};
+        const auto last = readBinJourn(dir, fromSeq, [&](uint64_t seq, const Msg& msg) {
+            batch.push_back(msg);
+            if (batch.size() >= BatchSize && moreOf(msg) == More::No) {
+                journ->update(batch);
+                count += batch.size();
+                batch.clear();
+            }
+        });
+        if (!batch.empty()) {
+            journ->update(batch);
+            count += batch.size();
+        }
+
+        cout << "imported " << count << " records";
+        if (count > 0) {
+            cout << " up to sequence " << last;
+        }
+        cout << endl;
+
+        ret = 0;
+    } catch (const exception& e) {
+        cerr << "exception: " << e.what() << endl;
+    }
+    return ret;
+}
@@ -0,0 +1,146 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/fin/Journ.hpp>
+#include <swirly/fin/MarketId.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/util/Conf.hpp>
+#include <swirly/util/Date.hpp>
+#include <swirly/util/String.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+// Execs are journaled in batches of this size, which matches the engine's default group commit.
+constexpr size_t BatchSize{1 << 6};
+
+constexpr auto SettlDay = ymdToJd(2014, 3, 2);
+constexpr auto MarketId = toMarketId(1_id32, SettlDay);
+
+Msg makeExec(Id64 id, Id64 orderId, State state, Lots lots, Time now)
+{
+    Msg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MsgType::CreateExec;
+    auto& body = msg.createExec;
+    setCString(body.accnt, orderId.count() % 2 == 0 ? "MARAYL"_sv : "GOSAYL"_sv);
+    body.marketId = MarketId;
+    setCString(body.instr, "EURUSD"_sv);
+    body.settlDay = SettlDay;
+    body.id = id;
+    body.orderId = orderId;
+    body.state = state;
+    body.side = orderId.count() % 2 == 0 ? Side::Buy : Side::Sell;
+    body.lots = lots;
+    body.ticks = 12345_tks;
+    body.resdLots = lots;
+    body.minLots = 1_lts;
+    body.tif = TimeInForce::Gtc;
+    body.created = msSinceEpoch(now);
+    body.more = More::No;
+    return msg;
+}
+
+/**
+ * Journal execs in batches.
+ *
+ * @return the elapsed time.
+ */
+template <typename FnT>
+Nanos journal(Journ& journ, size_t count, FnT fn)
+{
+    vector<Msg> batch;
+    batch.reserve(BatchSize);
+    const auto start = chrono::steady_clock::now();
+    for (size_t i{0}; i < count; ++i) {
+        batch.push_back(fn(i));
+        if (batch.size() == BatchSize || i + 1 == count) {
+            journ.update(batch);
+            batch.clear();
+        }
+    }
+    return chrono::steady_clock::now() - start;
+}
+
+void report(const char* name, size_t count, Nanos elapsed)
+{
+    const auto us = chrono::duration_cast<Micros>(elapsed).count();
+    cout << name << ": execs=" << count << ",elapsed_ms=" << us / 1000
+         << ",execs_per_sec=" << (us > 0 ? count * 1000000 / us : 0)
+         << ",us_per_exec=" << (count > 0 ? static_cast<double>(us) / count : 0) << endl;
+}
+
+} // anonymous
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+
+        if (argc < 2) {
+            cerr << "usage: swirly_journbench sqlite_journ [orders [execs]]\n";
+            return ret;
+        }
+
+        // The database must contain the reference data, but no market for EURUSD on 2014-03-02.
+        Conf conf;
+        conf.set("journ_type", "sqlite");
+        conf.set("sqlite_journ", argv[1]);
+        const size_t orders{argc > 2 ? stou64(argv[2]) : 1 << 20};
+        const size_t execs{argc > 3 ? stou64(argv[3]) : 1 << 12};
+
+        auto journ = makeJourn(conf);
+        const auto now = UnixClock::now();
+
+        Msg msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.type = MsgType::CreateMarket;
+        msg.createMarket.id = MarketId;
+        setCString(msg.createMarket.instr, "EURUSD"_sv);
+        msg.createMarket.settlDay = SettlDay;
+        journ->update(msg);
+
+        // Populate the database with resting orders.
+        auto elapsed = journal(*journ, orders, [now](size_t i) {
+            const Id64 id{static_cast<int64_t>(i + 1)};
+            return makeExec(id, id, State::New, 10_lts, now);
+        });
+        report("new", orders, elapsed);
+
+        // Revise randomly chosen orders. Each revision updates an existing order row.
+        mt19937_64 gen{1};
+        uniform_int_distribution<int64_t> dist{1, static_cast<int64_t>(orders)};
+        elapsed = journal(*journ, execs, [&](size_t i) {
+            const Id64 id{static_cast<int64_t>(orders + i + 1)};
+            return makeExec(id, Id64{dist(gen)}, State::Revise, 5_lts, now);
+        });
+        report("revise", execs, elapsed);
+
+        ret = 0;
+    } catch (const exception& e) {
+        cerr << "exception: " << e.what() << endl;
+    }
+    return ret;
+}
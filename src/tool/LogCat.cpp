@@ -0,0 +1,55 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/util/BinLog.hpp>
+
+#include <iostream>
+
+#include <ctime>
+
+using namespace std;
+using namespace swirly;
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+
+        if (argc < 2) {
+            cerr << "usage: swirly_logcat binlog_file\n";
+            return ret;
+        }
+
+        // Render records in the same format as the standard logger, but with the thread id in place
+        // of the process id.
+        readBinLog(argv[1], [](uint32_t tid, int level, Time time, string_view msg) {
+            const auto t = UnixClock::to_time_t(time);
+            struct tm tm;
+            localtime_r(&t, &tm);
+            char head[64];
+            auto len = strftime(head, sizeof(head), "%b %d %H:%M:%S", &tm);
+            len += snprintf(head + len, sizeof(head) - len, ".%03d %-7s [%u]: ",
+                            static_cast<int>(msSinceEpoch(time) % 1000), logLabel(level), tid);
+            cout.write(head, len).write(msg.data(), msg.size()) << '\n';
+        });
+        cout.flush();
+
+        ret = 0;
+    } catch (const exception& e) {
+        cerr << "exception: " << e.what() << endl;
+    }
+    return ret;
+}
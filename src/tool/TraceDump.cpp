@@ -0,0 +1,111 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2017 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/util/Histogram.hpp>
+#include <swirly/util/String.hpp>
+#include <swirly/util/Trace.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+using Key = pair<uint32_t, uint64_t>;
+// Nanoseconds spent in each stage by a request.
+using Stages = array<int64_t, TraceStages>;
+
+double toMicros(double ns) noexcept
+{
+    return ns / 1000.0;
+}
+
+void report(TraceStage stage, const Histogram& h)
+{
+    cout << stage << ": requests=" << h.count() //
+         << ",mean_us=" << toMicros(h.mean()) //
+         << ",p50_us=" << toMicros(h.valueAt(50)) //
+         << ",p99_us=" << toMicros(h.valueAt(99)) //
+         << ",p999_us=" << toMicros(h.valueAt(99.9)) //
+         << ",max_us=" << toMicros(h.max()) << endl;
+}
+
+} // anonymous
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+
+        if (argc < 2) {
+            cerr << "usage: swirly_tracedump trace_file [slowest]\n";
+            return ret;
+        }
+        const size_t slowest{argc > 2 ? stou64(argv[2]) : 10};
+
+        // A stage may occur more than once per request, so durations are summed.
+        map<Key, Stages> reqs;
+        readTrace(argv[1], [&reqs](const auto& ev) {
+            auto it = reqs.find({ev.tid, ev.req});
+            if (it == reqs.end()) {
+                it = reqs.emplace(Key{ev.tid, ev.req}, Stages{}).first;
+            }
+            it->second[static_cast<int>(ev.stage)] += max<int64_t>(ev.end - ev.start, 0);
+        });
+
+        array<Histogram, TraceStages> hists;
+        vector<pair<int64_t, Key>> totals;
+        for (const auto& req : reqs) {
+            for (int i{0}; i < TraceStages; ++i) {
+                if (req.second[i] > 0) {
+                    hists[i].record(req.second[i]);
+                }
+            }
+            const auto total = req.second[static_cast<int>(TraceStage::Request)];
+            if (total > 0) {
+                totals.emplace_back(total, req.first);
+            }
+        }
+        for (int i{0}; i < TraceStages; ++i) {
+            if (!hists[i].empty()) {
+                report(static_cast<TraceStage>(i), hists[i]);
+            }
+        }
+
+        const auto n = min(slowest, totals.size());
+        partial_sort(totals.begin(), totals.begin() + n, totals.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+        for (size_t i{0}; i < n; ++i) {
+            const auto& key = totals[i].second;
+            const auto& stages = reqs[key];
+            cout << "slowest: tid=" << key.first << ",req=" << key.second;
+            for (int j{0}; j < TraceStages; ++j) {
+                cout << ',' << static_cast<TraceStage>(j) << "_us=" << toMicros(stages[j]);
+            }
+            cout << endl;
+        }
+
+        ret = 0;
+    } catch (const exception& e) {
+        cerr << "exception: " << e.what() << endl;
+    }
+    return ret;
+}